@@ -0,0 +1,217 @@
+// obs-scene-switcher plugin
+// Copyright (C) 2025 ksmksks
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+// core のヘッドレスベンチマーク（OBS なしで実行できる）
+//
+//   scene-switcher-core-bench [iterations]
+//
+// - ルール照合、EventSub メッセージのパース、ルールの JSON 変換のスループット
+// - MockFrontend 上での切替 → 着地確認 → 復帰のサイクル
+
+#include "core/eventsub_parser.hpp"
+#include "core/log.hpp"
+#include "core/mock/mock_frontend.hpp"
+#include "core/rule_engine.hpp"
+#include "core/rule_predicates.hpp"
+#include "core/rule_serialization.hpp"
+#include "core/switch_engine.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+using BenchClock = std::chrono::steady_clock;
+
+namespace {
+
+// 最適化で計算が消えないようにするための書き込み先
+volatile size_t g_sink = 0;
+
+void report(const char *name, size_t iterations, BenchClock::duration elapsed)
+{
+	const double ns = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+	const double perOp = iterations ? ns / static_cast<double>(iterations) : 0.0;
+	const double perSec = ns > 0 ? static_cast<double>(iterations) * 1e9 / ns : 0.0;
+	std::printf("%-28s %10zu ops %12.1f ns/op %14.0f ops/s\n", name, iterations, perOp, perSec);
+}
+
+void quietSink(int level, const char *message)
+{
+	if (level <= corelog::Warning)
+		std::fprintf(stderr, "%s\n", message);
+}
+
+std::vector<RewardRule> makeRules(size_t count)
+{
+	std::vector<RewardRule> rules;
+	rules.reserve(count);
+	for (size_t i = 0; i < count; ++i) {
+		RewardRule rule;
+		rule.rewardId = "reward-" + std::to_string(i);
+		rule.sourceScene = i % 3 == 0 ? "Any" : "Main";
+		rule.targetScene = "Scene " + std::to_string(i % 8);
+		rule.revertSeconds = static_cast<int>(i % 30);
+		rule.actions.push_back(SceneItemVisibilityAction{"Main", "Overlay " + std::to_string(i), true, 5});
+		rules.push_back(std::move(rule));
+	}
+	return rules;
+}
+
+void benchMatch(size_t iterations)
+{
+	const auto rules = makeRules(200);
+	const TwitchEvent hit = RedemptionEvent{"", rules.back().rewardId, "", "", "", ""};
+	const TwitchEvent miss = RedemptionEvent{"", "reward-unknown", "", "", "", ""};
+	const std::string scene = "Main";
+
+	auto start = BenchClock::now();
+	for (size_t i = 0; i < iterations; ++i)
+		g_sink = g_sink + (matchRule(rules, hit, scene) != nullptr);
+	report("match (200 rules, last)", iterations, BenchClock::now() - start);
+
+	start = BenchClock::now();
+	for (size_t i = 0; i < iterations; ++i)
+		g_sink = g_sink + (matchRule(rules, miss, scene) != nullptr);
+	report("match (200 rules, miss)", iterations, BenchClock::now() - start);
+
+	// 発火条件つき（正規表現・許可リスト）。条件に合わない前半のルールを読み飛ばして最後で当たる
+	auto conditional = makeRules(200);
+	for (auto &rule : conditional) {
+		rule.rewardId = "reward-conditional";
+		rule.predicates.inputPattern = "^(brb|break)\\b";
+		rule.predicates.inputRegex = true;
+		rule.predicates.allowUsers = {"mod_a", "mod_b", "Cooler_User"};
+	}
+	conditional.back().predicates.inputPattern = "pog";
+	conditional.back().predicates.inputRegex = false;
+	compileRulePredicates(conditional);
+	const TwitchEvent input =
+		RedemptionEvent{"", "reward-conditional", "9001", "cooler_user", "Cooler_User", "POGCHAMP"};
+
+	start = BenchClock::now();
+	for (size_t i = 0; i < iterations / 10; ++i)
+		g_sink = g_sink + (matchRule(conditional, input, scene) == &conditional.back());
+	report("match (200 predicates)", iterations / 10, BenchClock::now() - start);
+}
+
+void benchParse(size_t iterations)
+{
+	const std::string notification =
+		R"({"metadata":{"message_id":"befa7b53-d79d-478f-86b9-120f112b044e","message_type":"notification",)"
+		R"("message_timestamp":"2022-11-16T10:11:12.464757833Z","subscription_type":)"
+		R"("channel.channel_points_custom_reward_redemption.add","subscription_version":"1"},)"
+		R"("payload":{"subscription":{"id":"f1c2a387-161a-49f9-a165-0f21d7a4e1c4","status":"enabled",)"
+		R"("type":"channel.channel_points_custom_reward_redemption.add","version":"1",)"
+		R"("condition":{"broadcaster_user_id":"1337"},"transport":{"method":"websocket",)"
+		R"("session_id":"AQoQexAWVYKSTIu4ec_2VAxyuhAB"},"created_at":"2022-11-16T10:11:12.464757833Z","cost":0},)"
+		R"("event":{"id":"17fa2df1-ad76-4804-bfa5-a40ef63efe63","broadcaster_user_id":"1337",)"
+		R"("broadcaster_user_login":"cool_user","broadcaster_user_name":"Cool_User","user_id":"9001",)"
+		R"("user_login":"cooler_user","user_name":"Cooler_User","user_input":"pogchamp","status":"unfulfilled",)"
+		R"("reward":{"id":"92af127c-7326-4483-a52b-b0da0be61c01","title":"title","cost":100,"prompt":"reward prompt"},)"
+		R"("redeemed_at":"2022-11-16T10:11:12.464757833Z"}}})";
+	const std::string keepalive =
+		R"({"metadata":{"message_id":"84c1e79a-2a4b-4c13-ba0b-4312293e9308","message_type":"session_keepalive",)"
+		R"("message_timestamp":"2023-07-19T10:11:12.634234626Z"},"payload":{}})";
+
+	EventSubMessage message;
+	std::string error;
+
+	auto start = BenchClock::now();
+	for (size_t i = 0; i < iterations; ++i)
+		g_sink = g_sink + parseEventSubMessage(notification, message, error) + message.event.has_value();
+	report("eventsub parse (notification)", iterations, BenchClock::now() - start);
+
+	start = BenchClock::now();
+	for (size_t i = 0; i < iterations; ++i)
+		g_sink = g_sink + parseEventSubMessage(keepalive, message, error);
+	report("eventsub parse (keepalive)", iterations, BenchClock::now() - start);
+}
+
+void benchSerialization(size_t iterations)
+{
+	const auto rules = makeRules(1);
+	RewardRule parsed;
+
+	const auto start = BenchClock::now();
+	for (size_t i = 0; i < iterations; ++i)
+		g_sink = g_sink + ruleFromJson(ruleToJson(rules.front()), parsed) + parsed.actions.size();
+	report("rule json round trip", iterations, BenchClock::now() - start);
+}
+
+// 着地待ちの切替がなくなるまでタイマーを駆動する
+void drain(SwitchEngine &engine, MockFrontend &frontend, std::optional<TimerWheel::Clock::time_point> &wakeup)
+{
+	while (frontend.switchesInFlight() > 0) {
+		if (wakeup)
+			std::this_thread::sleep_until(*wakeup);
+		engine.advanceTimers();
+	}
+}
+
+void benchSwitchCycles(size_t cycles, int transitionMs)
+{
+	MockFrontend frontend({"Main", "BRB", "Gameplay"});
+	SwitchEngine engine(frontend);
+
+	std::optional<TimerWheel::Clock::time_point> wakeup;
+	engine.setWakeupCallback([&wakeup](std::optional<TimerWheel::Clock::time_point> next) { wakeup = next; });
+	frontend.setScheduler([&engine](std::chrono::milliseconds delay, std::function<void()> task) {
+		engine.scheduleAfter(delay, std::move(task));
+	});
+	frontend.setEventCallback([&engine](MockFrontend::Event event) {
+		if (event == MockFrontend::Event::SceneChanged)
+			engine.onSceneChanged();
+		else
+			engine.onTransitionStopped();
+	});
+	frontend.setTransition(transitionMs > 0 ? "Fade" : "Cut", transitionMs, transitionMs <= 0);
+
+	RewardRule rule;
+	rule.rewardId = "bench";
+	rule.targetScene = "BRB";
+	rule.revertSeconds = 60;
+
+	// 切替 → 着地 → 手動復帰 → 着地 を 1 サイクルとする
+	const auto start = BenchClock::now();
+	for (size_t i = 0; i < cycles; ++i) {
+		engine.switchWithRevert(rule);
+		drain(engine, frontend, wakeup);
+		engine.revertNow();
+		drain(engine, frontend, wakeup);
+	}
+	const auto elapsed = BenchClock::now() - start;
+
+	char name[64];
+	std::snprintf(name, sizeof(name), "switch cycle (%s %d ms)", transitionMs > 0 ? "fade" : "cut", transitionMs);
+	report(name, cycles, elapsed);
+
+	for (const auto &[label, stats] : engine.switchLatency()) {
+		std::printf("  on-air %-22s n=%llu avg=%.2f ms max=%.2f ms retries=%llu failures=%llu superseded=%llu\n",
+			    label.c_str(),
+			    (unsigned long long)stats.onAir.count(), stats.onAir.averageMs(),
+			    static_cast<double>(stats.onAir.maxUs()) / 1000.0,
+			    (unsigned long long)stats.retries.load(), (unsigned long long)stats.failures.load(),
+			    (unsigned long long)stats.superseded.load());
+	}
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+	const size_t iterations = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 200000;
+
+	corelog::setSink(&quietSink);
+
+	benchMatch(iterations);
+	benchParse(iterations / 4);
+	benchSerialization(iterations / 4);
+	benchSwitchCycles(200, 0);
+	benchSwitchCycles(20, 20);
+
+	return g_sink == 0 ? 1 : 0;
+}
@@ -0,0 +1,127 @@
+// obs-scene-switcher plugin
+// Copyright (C) 2025 ksmksks
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "combo_tracker.hpp"
+#include "core/rule_key.hpp"
+
+#include <algorithm>
+#include <unordered_set>
+
+namespace {
+
+// クールダウン表のキーと混ざらないようにするタグ
+constexpr uint8_t kComboKeyTag = 0x80;
+constexpr uint8_t kUserKeyTag = 0x81;
+
+uint64_t comboKey(const RewardRule &rule)
+{
+	return KeyHash(kComboKeyTag).addRule(rule).value();
+}
+
+bool sameCombo(const RuleCombo &a, const RuleCombo &b)
+{
+	return a.count == b.count && a.windowSeconds == b.windowSeconds && a.distinctUsers == b.distinctUsers;
+}
+
+} // namespace
+
+void ComboTracker::Window::reset(const RuleCombo &next)
+{
+	combo = next;
+	const size_t capacity = static_cast<size_t>(std::clamp(next.count, 2, kMaxCount));
+	times.assign(capacity, Clock::time_point{});
+	users.assign(next.distinctUsers ? capacity : 0, 0);
+	head = 0;
+	size = 0;
+}
+
+bool ComboTracker::Window::addEvent(Clock::time_point now)
+{
+	const size_t capacity = times.size();
+	times[head] = now;
+	head = (head + 1) % capacity;
+	if (size < capacity)
+		++size;
+
+	// 満杯なら head が最も古い時刻（N 件前）
+	return size == capacity && times[head] >= now - std::chrono::seconds(combo.windowSeconds);
+}
+
+bool ComboTracker::Window::addUser(uint64_t user, Clock::time_point now)
+{
+	const size_t capacity = times.size();
+	const auto cutoff = now - std::chrono::seconds(combo.windowSeconds);
+
+	size_t live = 0;
+	size_t freeSlot = capacity;
+	size_t oldest = 0;
+	bool found = false;
+	for (size_t i = 0; i < capacity; ++i) {
+		const bool alive = times[i] != Clock::time_point{} && times[i] >= cutoff;
+		if (alive && users[i] == user) {
+			times[i] = now;
+			found = true;
+		}
+		if (alive)
+			++live;
+		else if (freeSlot == capacity)
+			freeSlot = i;
+		if (times[i] < times[oldest])
+			oldest = i;
+	}
+
+	// 空きがないのは揃ったまま consume() されていないとき。最も古いユーザーと入れ替えて揃った状態を保つ
+	if (!found) {
+		const size_t slot = freeSlot != capacity ? freeSlot : oldest;
+		if (slot == freeSlot)
+			++live;
+		users[slot] = user;
+		times[slot] = now;
+	}
+
+	return live >= capacity;
+}
+
+bool ComboTracker::record(const RewardRule &rule, const TwitchEvent &event, Clock::time_point now)
+{
+	if (!rule.combo.enabled())
+		return true;
+
+	Window &window = windows_[comboKey(rule)];
+	// 新しいルール、または件数・秒数を変えたルールは数え直す
+	if (window.times.empty() || !sameCombo(window.combo, rule.combo))
+		window.reset(rule.combo);
+
+	if (!rule.combo.distinctUsers)
+		return window.addEvent(now);
+
+	// 匿名の通知は人数に数えない
+	const std::string_view userId = eventUserId(event);
+	if (userId.empty())
+		return false;
+	return window.addUser(KeyHash(kUserKeyTag).add(userId).value(), now);
+}
+
+void ComboTracker::consume(const RewardRule &rule)
+{
+	auto it = windows_.find(comboKey(rule));
+	if (it != windows_.end())
+		it->second.reset(rule.combo);
+}
+
+void ComboTracker::retain(const std::vector<RewardRule> &rules)
+{
+	std::unordered_set<uint64_t> keys;
+	for (const auto &rule : rules) {
+		if (rule.combo.enabled())
+			keys.insert(comboKey(rule));
+	}
+
+	for (auto it = windows_.begin(); it != windows_.end();) {
+		if (keys.count(it->first))
+			++it;
+		else
+			it = windows_.erase(it);
+	}
+}
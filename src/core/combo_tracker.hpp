@@ -0,0 +1,52 @@
+// obs-scene-switcher plugin
+// Copyright (C) 2025 ksmksks
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+#include "core/reward_rule.hpp"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * コンボルール（T 秒以内に N 回 / N 人）のスライディングウィンドウ
+ *
+ * - ルールごとに直近 N 件の時刻（人数で数える場合はユーザーごとの最終時刻）だけを固定長の配列に持つ
+ * - 回数は N 件前の時刻がウィンドウ内かで判定する（O(1)）。人数は N 要素の走査で判定する
+ * - 揃っても record() はウィンドウを空にしない。実行が決まったら consume() で空にする
+ *   （クールダウンで実行できなかったコンボは、クールダウン明けに次の通知で揃い直す）
+ * - スレッドセーフではない（UI スレッドからのみ使う）
+ */
+class ComboTracker {
+public:
+	using Clock = std::chrono::steady_clock;
+
+	// 1 ルールで保持する件数の上限（UI の上限と同じ）
+	static constexpr int kMaxCount = 500;
+
+	// 通知を 1 件数え、コンボが揃ったら true
+	bool record(const RewardRule &rule, const TwitchEvent &event, Clock::time_point now = Clock::now());
+	// 揃ったコンボを実行したとき。ウィンドウを空にする（続けて届いた通知は次のコンボとして数える）
+	void consume(const RewardRule &rule);
+
+	// ルールの更新時。残っているルールのウィンドウだけを保持する
+	void retain(const std::vector<RewardRule> &rules);
+	void clear() { windows_.clear(); }
+
+private:
+	struct Window {
+		RuleCombo combo;
+		std::vector<Clock::time_point> times;  // リングバッファ（人数で数える場合は users と対応）
+		std::vector<uint64_t> users;
+		size_t head = 0;  // 次に書き込む位置（回数で数える場合、満杯ならここが最も古い）
+		size_t size = 0;
+
+		void reset(const RuleCombo &next);
+		bool addEvent(Clock::time_point now);
+		bool addUser(uint64_t user, Clock::time_point now);
+	};
+
+	std::unordered_map<uint64_t, Window> windows_;
+};
@@ -0,0 +1,93 @@
+// obs-scene-switcher plugin
+// Copyright (C) 2025 ksmksks
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "cooldown_table.hpp"
+#include "core/rule_key.hpp"
+
+#include <algorithm>
+
+const char *cooldownScopeName(CooldownScope scope)
+{
+	switch (scope) {
+	case CooldownScope::Global:
+		return "global";
+	case CooldownScope::Rule:
+		return "rule";
+	case CooldownScope::Reward:
+		return "reward";
+	case CooldownScope::User:
+		return "user";
+	}
+	return "unknown";
+}
+
+std::optional<CooldownRejection> CooldownTable::tryAcquire(const RewardRule &rule, const TwitchEvent &event,
+							   int globalSeconds, Clock::time_point now)
+{
+	struct Entry {
+		CooldownScope scope;
+		uint64_t key;
+		int seconds;
+	};
+	Entry entries[kCooldownScopeCount];
+	size_t count = 0;
+
+	const auto keyFor = [](CooldownScope scope) { return KeyHash(static_cast<uint8_t>(scope)); };
+
+	if (globalSeconds > 0)
+		entries[count++] = {CooldownScope::Global, keyFor(CooldownScope::Global).value(), globalSeconds};
+
+	if (rule.cooldowns.ruleSeconds > 0) {
+		const uint64_t key = keyFor(CooldownScope::Rule).addRule(rule).value();
+		entries[count++] = {CooldownScope::Rule, key, rule.cooldowns.ruleSeconds};
+	}
+
+	if (rule.cooldowns.rewardSeconds > 0) {
+		const uint64_t key =
+			keyFor(CooldownScope::Reward).add(static_cast<uint8_t>(rule.trigger)).add(rule.rewardId).value();
+		entries[count++] = {CooldownScope::Reward, key, rule.cooldowns.rewardSeconds};
+	}
+
+	// 匿名の Bits などユーザーが分からない通知にはユーザー単位の制限をかけない
+	const std::string_view userId = eventUserId(event);
+	if (rule.cooldowns.userSeconds > 0 && !userId.empty()) {
+		const uint64_t key = keyFor(CooldownScope::User).addRule(rule).add(userId).value();
+		entries[count++] = {CooldownScope::User, key, rule.cooldowns.userSeconds};
+	}
+
+	for (size_t i = 0; i < count; ++i) {
+		const auto it = until_.find(entries[i].key);
+		if (it != until_.end() && it->second > now) {
+			const auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(it->second - now);
+			return CooldownRejection{entries[i].scope, static_cast<int>(remaining.count())};
+		}
+	}
+
+	for (size_t i = 0; i < count; ++i)
+		until_[entries[i].key] = now + std::chrono::seconds(entries[i].seconds);
+
+	if (until_.size() >= pruneThreshold_)
+		prune(now);
+
+	return std::nullopt;
+}
+
+void CooldownTable::clear()
+{
+	until_.clear();
+	pruneThreshold_ = 256;
+}
+
+void CooldownTable::prune(Clock::time_point now)
+{
+	for (auto it = until_.begin(); it != until_.end();) {
+		if (it->second <= now)
+			it = until_.erase(it);
+		else
+			++it;
+	}
+
+	// 有効なエントリが多いときに毎回走査しないよう、次の閾値を広げる
+	pruneThreshold_ = std::max<size_t>(256, until_.size() * 2);
+}
@@ -0,0 +1,56 @@
+// obs-scene-switcher plugin
+// Copyright (C) 2025 ksmksks
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+#include "core/twitch_event.hpp"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+
+struct RewardRule;
+
+// クールダウンの単位（メトリクスの添字にも使う）
+enum class CooldownScope : int {
+	Global = 0,  // すべてのルール
+	Rule,        // ルール単位
+	Reward,      // 報酬単位（同じ報酬の別ルールも含む。引き換え以外はイベントの種類単位）
+	User,        // ルール × ユーザー単位
+};
+
+constexpr size_t kCooldownScopeCount = 4;
+
+const char *cooldownScopeName(CooldownScope scope);
+
+struct CooldownRejection {
+	CooldownScope scope;
+	int remainingMs;
+};
+
+/**
+ * ルール実行のクールダウン表
+ *
+ * - キー（単位 + ルール・報酬・ユーザー）の 64 ビットハッシュ → 解除時刻 の表で、判定は O(1)
+ * - すべての単位を通ったときだけ記録する（拒否した要求は次のクールダウンを延ばさない）
+ * - 期限切れのエントリは表が大きくなったときにまとめて捨てる
+ * - スレッドセーフではない（UI スレッドからのみ使う）
+ */
+class CooldownTable {
+public:
+	using Clock = std::chrono::steady_clock;
+
+	// 実行してよければ記録して nullopt、クールダウン中なら最初に引っかかった単位を返す
+	std::optional<CooldownRejection> tryAcquire(const RewardRule &rule, const TwitchEvent &event,
+						    int globalSeconds, Clock::time_point now = Clock::now());
+
+	void clear();
+	size_t size() const { return until_.size(); }
+
+private:
+	void prune(Clock::time_point now);
+
+	std::unordered_map<uint64_t, Clock::time_point> until_;
+	size_t pruneThreshold_ = 256;
+};
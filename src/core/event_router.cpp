@@ -0,0 +1,57 @@
+// obs-scene-switcher plugin
+// Copyright (C) 2025 ksmksks
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "event_router.hpp"
+
+namespace eventsub {
+
+namespace {
+
+constexpr uint32_t typeHash(EventKind kind)
+{
+	return fnv1a(kEventTypes[static_cast<size_t>(kind)].subscriptionType);
+}
+
+} // namespace
+
+std::optional<EventKind> kindForSubscriptionType(std::string_view type)
+{
+	std::optional<EventKind> kind;
+
+	switch (fnv1a(type)) {
+	case typeHash(EventKind::Redemption):
+		kind = EventKind::Redemption;
+		break;
+	case typeHash(EventKind::Cheer):
+		kind = EventKind::Cheer;
+		break;
+	case typeHash(EventKind::Subscribe):
+		kind = EventKind::Subscribe;
+		break;
+	case typeHash(EventKind::Raid):
+		kind = EventKind::Raid;
+		break;
+	case typeHash(EventKind::Follow):
+		kind = EventKind::Follow;
+		break;
+	default:
+		return std::nullopt;
+	}
+
+	// 未知の型名が同じハッシュになった場合
+	if (type != eventTypeInfo(*kind).subscriptionType)
+		return std::nullopt;
+	return kind;
+}
+
+} // namespace eventsub
+
+std::optional<EventKind> eventKindFromName(std::string_view name)
+{
+	for (const auto &info : kEventTypes) {
+		if (name == info.name)
+			return info.kind;
+	}
+	return std::nullopt;
+}
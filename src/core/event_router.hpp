@@ -0,0 +1,52 @@
+// obs-scene-switcher plugin
+// Copyright (C) 2025 ksmksks
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+#include "core/twitch_event.hpp"
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+/**
+ * EventSub の subscription.type → EventKind の振り分け
+ *
+ * - kEventTypes の型名に対する FNV-1a ハッシュをコンパイル時に計算し、switch で引く
+ * - ハッシュが衝突しないこと（既知の型名に対して完全ハッシュであること）は static_assert で保証する
+ * - 未知の型名がたまたま同じハッシュになっても、最後に文字列を比較して弾く
+ */
+namespace eventsub {
+
+constexpr uint32_t fnv1a(std::string_view text)
+{
+	uint32_t hash = 2166136261u;
+	for (char c : text) {
+		hash ^= static_cast<uint8_t>(c);
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+constexpr bool hashesAreUnique()
+{
+	for (size_t i = 0; i < kEventKindCount; ++i)
+		for (size_t j = i + 1; j < kEventKindCount; ++j)
+			if (fnv1a(kEventTypes[i].subscriptionType) == fnv1a(kEventTypes[j].subscriptionType))
+				return false;
+	return true;
+}
+
+constexpr bool tableIsOrdered()
+{
+	for (size_t i = 0; i < kEventKindCount; ++i)
+		if (static_cast<size_t>(kEventTypes[i].kind) != i)
+			return false;
+	return true;
+}
+
+static_assert(hashesAreUnique(), "EventSub subscription types must hash to distinct values");
+static_assert(tableIsOrdered(), "kEventTypes must be ordered by EventKind");
+
+std::optional<EventKind> kindForSubscriptionType(std::string_view type);
+
+} // namespace eventsub
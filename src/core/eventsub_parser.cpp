@@ -0,0 +1,212 @@
+// obs-scene-switcher plugin
+// Copyright (C) 2025 ksmksks
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "eventsub_parser.hpp"
+#include "event_router.hpp"
+
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+
+static EventSubMessage::Type messageType(const std::string &type)
+{
+	if (type == "session_welcome")
+		return EventSubMessage::Type::SessionWelcome;
+	if (type == "session_reconnect")
+		return EventSubMessage::Type::SessionReconnect;
+	if (type == "notification")
+		return EventSubMessage::Type::Notification;
+	if (type == "session_keepalive")
+		return EventSubMessage::Type::SessionKeepalive;
+	if (type == "revocation")
+		return EventSubMessage::Type::Revocation;
+	return EventSubMessage::Type::Unknown;
+}
+
+// オブジェクトの子要素（なければ空のオブジェクト）
+static const json &child(const json &parent, const char *key)
+{
+	static const json empty = json::object();
+	if (!parent.is_object())
+		return empty;
+
+	auto it = parent.find(key);
+	return it != parent.end() && it->is_object() ? *it : empty;
+}
+
+static std::string stringField(const json &object, const char *key)
+{
+	auto it = object.find(key);
+	return it != object.end() && it->is_string() ? it->get<std::string>() : std::string();
+}
+
+static int intField(const json &object, const char *key)
+{
+	auto it = object.find(key);
+	return it != object.end() && it->is_number_integer() ? it->get<int>() : 0;
+}
+
+static bool boolField(const json &object, const char *key)
+{
+	auto it = object.find(key);
+	return it != object.end() && it->is_boolean() && it->get<bool>();
+}
+
+// 通知の event オブジェクトのデコーダ（EventKind の並び）
+static TwitchEvent decodeRedemption(const json &event)
+{
+	RedemptionEvent out;
+	out.id = stringField(event, "id");
+	out.rewardId = stringField(child(event, "reward"), "id");
+	out.userId = stringField(event, "user_id");
+	out.userLogin = stringField(event, "user_login");
+	out.userName = stringField(event, "user_name");
+	out.userInput = stringField(event, "user_input");
+	return out;
+}
+
+static TwitchEvent decodeCheer(const json &event)
+{
+	CheerEvent out;
+	out.anonymous = boolField(event, "is_anonymous");
+	out.userId = stringField(event, "user_id");
+	out.userLogin = stringField(event, "user_login");
+	out.userName = stringField(event, "user_name");
+	out.message = stringField(event, "message");
+	out.bits = intField(event, "bits");
+	return out;
+}
+
+static TwitchEvent decodeSubscribe(const json &event)
+{
+	SubscribeEvent out;
+	out.userId = stringField(event, "user_id");
+	out.userLogin = stringField(event, "user_login");
+	out.userName = stringField(event, "user_name");
+	out.tier = stringField(event, "tier");
+	out.isGift = boolField(event, "is_gift");
+	return out;
+}
+
+static TwitchEvent decodeRaid(const json &event)
+{
+	RaidEvent out;
+	out.fromUserId = stringField(event, "from_broadcaster_user_id");
+	out.fromUserLogin = stringField(event, "from_broadcaster_user_login");
+	out.fromUserName = stringField(event, "from_broadcaster_user_name");
+	out.viewers = intField(event, "viewers");
+	return out;
+}
+
+static TwitchEvent decodeFollow(const json &event)
+{
+	FollowEvent out;
+	out.userId = stringField(event, "user_id");
+	out.userLogin = stringField(event, "user_login");
+	out.userName = stringField(event, "user_name");
+	return out;
+}
+
+using EventDecoder = TwitchEvent (*)(const json &event);
+
+static constexpr EventDecoder kDecoders[kEventKindCount] = {
+	decodeRedemption, decodeCheer, decodeSubscribe, decodeRaid, decodeFollow,
+};
+
+bool parseEventSubMessage(const std::string &text, EventSubMessage &out, std::string &error)
+{
+	// 例外を使わずにパースする（不正な JSON は discarded を返す）
+	const json root = json::parse(text, nullptr, false);
+	if (root.is_discarded() || !root.is_object()) {
+		error = "invalid JSON";
+		return false;
+	}
+
+	const json &metadata = child(root, "metadata");
+	out = EventSubMessage();
+	out.type = messageType(stringField(metadata, "message_type"));
+	out.messageId = stringField(metadata, "message_id");
+	out.messageTimestamp = stringField(metadata, "message_timestamp");
+
+	const json &payload = child(root, "payload");
+
+	switch (out.type) {
+	case EventSubMessage::Type::SessionWelcome:
+	case EventSubMessage::Type::SessionReconnect: {
+		const json &session = child(payload, "session");
+		out.sessionId = stringField(session, "id");
+		out.reconnectUrl = stringField(session, "reconnect_url");
+		break;
+	}
+
+	case EventSubMessage::Type::Revocation: {
+		const json &subscription = child(payload, "subscription");
+		out.subscriptionId = stringField(subscription, "id");
+		out.subscriptionType = stringField(subscription, "type");
+		out.subscriptionStatus = stringField(subscription, "status");
+		break;
+	}
+
+	case EventSubMessage::Type::Notification: {
+		const json &subscription = child(payload, "subscription");
+		out.subscriptionId = stringField(subscription, "id");
+		out.subscriptionType = stringField(subscription, "type");
+
+		const json &event = child(payload, "event");
+		if (const auto kind = eventsub::kindForSubscriptionType(out.subscriptionType))
+			out.event = kDecoders[static_cast<size_t>(*kind)](event);
+
+		out.eventTimestamp = stringField(event, "redeemed_at");
+		if (out.eventTimestamp.empty())
+			out.eventTimestamp = stringField(event, "followed_at");
+		break;
+	}
+
+	default:
+		break;
+	}
+
+	return true;
+}
+
+bool parseSubscriptionResponse(const std::string &text, EventSubSubscriptionResponse &out, std::string &error)
+{
+	const json root = json::parse(text, nullptr, false);
+	if (root.is_discarded() || !root.is_object()) {
+		error = "invalid JSON";
+		return false;
+	}
+
+	out = EventSubSubscriptionResponse();
+	out.total = intField(root, "total");
+	out.totalCost = intField(root, "total_cost");
+	out.maxTotalCost = intField(root, "max_total_cost");
+	out.cursor = stringField(child(root, "pagination"), "cursor");
+	out.message = stringField(root, "message");
+
+	auto data = root.find("data");
+	if (data == root.end() || !data->is_array())
+		return true;
+
+	out.subscriptions.reserve(data->size());
+	for (const auto &item : *data) {
+		if (!item.is_object())
+			continue;
+
+		EventSubSubscription sub;
+		sub.id = stringField(item, "id");
+		sub.type = stringField(item, "type");
+		sub.version = stringField(item, "version");
+		sub.status = stringField(item, "status");
+		const json &condition = child(item, "condition");
+		sub.broadcasterUserId = stringField(condition, "broadcaster_user_id");
+		if (sub.broadcasterUserId.empty())
+			sub.broadcasterUserId = stringField(condition, "to_broadcaster_user_id");
+		sub.sessionId = stringField(child(item, "transport"), "session_id");
+		sub.cost = intField(item, "cost");
+		out.subscriptions.push_back(std::move(sub));
+	}
+
+	return true;
+}
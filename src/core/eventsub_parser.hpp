@@ -0,0 +1,77 @@
+// obs-scene-switcher plugin
+// Copyright (C) 2025 ksmksks
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+#include "core/twitch_event.hpp"
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+/**
+ * EventSub WebSocket メッセージのパース結果
+ *
+ * - 接続管理（EventSubClient）から切り離し、受信テキストを構造体へ変換するだけを行う
+ * - 使うフィールドのみを取り出す（未知の message_type は Type::Unknown）
+ */
+struct EventSubMessage {
+	// トレースにはこの番号を記録する
+	enum class Type : int {
+		Unknown = -1,
+		SessionWelcome = 0,
+		SessionReconnect = 1,
+		Notification = 2,
+		SessionKeepalive = 3,
+		Revocation = 4,
+	};
+
+	Type type = Type::Unknown;
+	std::string messageId;
+	std::string messageTimestamp;
+
+	// session_welcome / session_reconnect
+	std::string sessionId;
+	std::string reconnectUrl;
+
+	// notification / revocation（payload.subscription）
+	std::string subscriptionId;
+	std::string subscriptionType;
+	std::string subscriptionStatus;  // revocation の理由（authorization_revoked など）
+
+	// notification（subscription.type ごとのデコーダで取り出す。未知の型なら nullopt）
+	std::optional<TwitchEvent> event;
+	// 通知の発生時刻（event.redeemed_at / followed_at。ない種類は空で、message_timestamp を使う）
+	std::string eventTimestamp;
+};
+
+// 失敗時は false を返し、error に理由を書く
+bool parseEventSubMessage(const std::string &text, EventSubMessage &out, std::string &error);
+
+// Helix /eventsub/subscriptions の 1 件
+struct EventSubSubscription {
+	std::string id;
+	std::string type;
+	std::string version;
+	std::string status;             // enabled / websocket_disconnected など
+	std::string broadcasterUserId;  // condition.broadcaster_user_id（raid は to_broadcaster_user_id）
+	std::string sessionId;          // transport.session_id（websocket のみ）
+	int cost = 0;
+};
+
+/**
+ * Helix /eventsub/subscriptions の応答（一覧・作成・エラー）
+ *
+ * - 作成の応答は subscriptions が 1 件
+ * - エラー応答（409 など）は message だけが入る
+ */
+struct EventSubSubscriptionResponse {
+	std::vector<EventSubSubscription> subscriptions;
+	int total = 0;
+	int totalCost = 0;
+	int maxTotalCost = 0;
+	std::string cursor;   // 続きのページ（pagination.cursor）
+	std::string message;  // エラー応答の message
+};
+
+bool parseSubscriptionResponse(const std::string &text, EventSubSubscriptionResponse &out, std::string &error);
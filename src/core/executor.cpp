@@ -0,0 +1,82 @@
+// obs-scene-switcher plugin
+// Copyright (C) 2025 ksmksks
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "executor.hpp"
+
+#include <utility>
+
+Executor::Executor(size_t threads, std::string name) : name_(std::move(name))
+{
+	if (threads == 0)
+		threads = 1;
+
+	workers_.reserve(threads);
+	for (size_t i = 0; i < threads; ++i)
+		workers_.emplace_back([this]() { workerLoop(); });
+}
+
+Executor::~Executor()
+{
+	shutdown();
+}
+
+bool Executor::post(Task task)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		if (stopping_)
+			return false;
+		queue_.push_back(std::move(task));
+	}
+
+	cv_.notify_one();
+	return true;
+}
+
+void Executor::shutdown()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		if (stopping_ && workers_.empty())
+			return;
+		stopping_ = true;
+		queue_.clear();
+	}
+
+	cv_.notify_all();
+
+	for (auto &worker : workers_) {
+		// タスク内から自分自身の shutdown を呼んだ場合は join できないため切り離す
+		if (worker.get_id() == std::this_thread::get_id())
+			worker.detach();
+		else if (worker.joinable())
+			worker.join();
+	}
+
+	std::lock_guard<std::mutex> lock(mutex_);
+	workers_.clear();
+}
+
+bool Executor::isStopping() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return stopping_;
+}
+
+void Executor::workerLoop()
+{
+	while (true) {
+		Task task;
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			cv_.wait(lock, [this]() { return stopping_ || !queue_.empty(); });
+			if (stopping_)
+				return;
+			task = std::move(queue_.front());
+			queue_.pop_front();
+		}
+
+		task();
+	}
+}
@@ -0,0 +1,48 @@
+// obs-scene-switcher plugin
+// Copyright (C) 2025 ksmksks
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * 固定スレッド数のタスク実行器
+ *
+ * - post() はどのスレッドからでも呼べる
+ * - shutdown() は未着手のタスクを破棄し、実行中のタスクの完了を待ってスレッドを join する
+ */
+class Executor {
+public:
+	using Task = std::function<void()>;
+
+	Executor(size_t threads, std::string name);
+	~Executor();
+
+	Executor(const Executor &) = delete;
+	Executor &operator=(const Executor &) = delete;
+
+	// 停止後は false を返し、タスクは実行されない
+	bool post(Task task);
+
+	void shutdown();
+
+	bool isStopping() const;
+	const std::string &name() const { return name_; }
+
+private:
+	void workerLoop();
+
+	const std::string name_;
+	mutable std::mutex mutex_;
+	std::condition_variable cv_;
+	std::deque<Task> queue_;
+	std::vector<std::thread> workers_;
+	bool stopping_ = false;
+};
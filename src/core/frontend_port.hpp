@@ -0,0 +1,51 @@
+// obs-scene-switcher plugin
+// Copyright (C) 2025 ksmksks
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+#include "core/reward_rule.hpp"
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+/**
+ * OBS フロントエンドへの薄いポート
+ *
+ * - core（切替の State Machine など）は obs_frontend_* を直接呼ばず、このインターフェースだけを使う
+ * - プラグインでは ObsFrontendPort、ベンチマークでは MockFrontend が実装する
+ * - すべて UI スレッド（core を駆動するスレッド）から呼ばれる
+ * - シーン切替の着地は SwitchEngine::onSceneChanged() / onTransitionStopped() で通知する
+ */
+class FrontendPort {
+public:
+	virtual ~FrontendPort() = default;
+
+	// シーン
+	virtual std::vector<std::string> sceneNames() const = 0;
+	virtual std::string currentScene() const = 0;
+	// 切替を要求する（シーンがなければ false）。着地は非同期
+	virtual bool setCurrentScene(const std::string &name) = 0;
+
+	// トランジション
+	virtual int transitionDurationMs() const = 0;
+	virtual bool isCutTransition() const = 0;
+	// ルールのトランジション名を解決して transitionSlot に書き込む
+	virtual void compileTransitions(std::vector<RewardRule> &rules) = 0;
+	// ルール指定のトランジションに一時的に差し替える（差し替えたら true）
+	virtual bool applyTransitionOverride(const RewardRule &rule) = 0;
+	// 差し替え前のトランジションに戻す（差し替えていなければ何もしない）
+	virtual void restoreTransitionOverride() = 0;
+
+	// ビデオのフレーム時刻（ns）と 1 フレームの長さ（ns、不明なら 0）
+	virtual uint64_t videoFrameTimeNs() const = 0;
+	virtual uint64_t frameIntervalNs() const = 0;
+
+	// アクション。変更前の状態を返す（対象が見つからなければ nullopt）
+	virtual std::optional<bool> setSceneItemVisible(const std::string &scene, const std::string &source,
+							bool visible) = 0;
+	virtual std::optional<bool> setFilterEnabled(const std::string &source, const std::string &filter,
+						     bool enabled) = 0;
+	virtual bool restartMedia(const std::string &source) = 0;
+	virtual void stopMedia(const std::string &source) = 0;
+};
@@ -0,0 +1,56 @@
+// obs-scene-switcher plugin
+// Copyright (C) 2025 ksmksks
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * 固定バケットのレイテンシヒストグラム（マイクロ秒単位）
+ *
+ * record() はロックフリーで、任意のスレッドから呼び出せる。
+ */
+class LatencyHistogram {
+public:
+	// 各バケットの上限値（最後のバケットは +Inf）
+	static constexpr std::array<uint64_t, 18> kBoundsUs = {
+		100,     250,     500,     1000,    2500,     5000,     10000,    25000,    50000,
+		100000,  250000,  500000,  1000000, 2500000,  5000000,  10000000, 30000000, 60000000,
+	};
+	static constexpr size_t kBuckets = kBoundsUs.size() + 1;
+
+	void record(uint64_t us)
+	{
+		size_t i = 0;
+		while (i < kBoundsUs.size() && us > kBoundsUs[i])
+			++i;
+
+		buckets_[i].fetch_add(1, std::memory_order_relaxed);
+		count_.fetch_add(1, std::memory_order_relaxed);
+		sumUs_.fetch_add(us, std::memory_order_relaxed);
+
+		uint64_t prev = maxUs_.load(std::memory_order_relaxed);
+		while (us > prev && !maxUs_.compare_exchange_weak(prev, us, std::memory_order_relaxed)) {
+		}
+	}
+
+	uint64_t count() const { return count_.load(std::memory_order_relaxed); }
+	uint64_t sumUs() const { return sumUs_.load(std::memory_order_relaxed); }
+	uint64_t maxUs() const { return maxUs_.load(std::memory_order_relaxed); }
+	uint64_t bucket(size_t i) const { return buckets_[i].load(std::memory_order_relaxed); }
+
+	double averageMs() const
+	{
+		const uint64_t n = count();
+		return n ? static_cast<double>(sumUs()) / static_cast<double>(n) / 1000.0 : 0.0;
+	}
+
+private:
+	std::array<std::atomic<uint64_t>, kBuckets> buckets_{};
+	std::atomic<uint64_t> count_{0};
+	std::atomic<uint64_t> sumUs_{0};
+	std::atomic<uint64_t> maxUs_{0};
+};
@@ -0,0 +1,42 @@
+// obs-scene-switcher plugin
+// Copyright (C) 2025 ksmksks
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "log.hpp"
+
+#include <atomic>
+#include <cstdarg>
+#include <cstdio>
+
+namespace corelog {
+
+namespace {
+
+void stderrSink(int level, const char *message)
+{
+	const char *name = level <= Error ? "error" : level <= Warning ? "warning" : level <= Info ? "info" : "debug";
+	std::fprintf(stderr, "[%s] %s\n", name, message);
+}
+
+std::atomic<Sink> g_sink{&stderrSink};
+
+} // namespace
+
+void setSink(Sink sink)
+{
+	g_sink.store(sink ? sink : &stderrSink, std::memory_order_release);
+}
+
+void write(int level, const char *format, ...)
+{
+	char message[1024];
+
+	va_list args;
+	va_start(args, format);
+	std::vsnprintf(message, sizeof(message), format, args);
+	va_end(args);
+
+	g_sink.load(std::memory_order_acquire)(level, message);
+}
+
+} // namespace corelog
@@ -0,0 +1,33 @@
+// obs-scene-switcher plugin
+// Copyright (C) 2025 ksmksks
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+
+/**
+ * core 用のログ出力
+ *
+ * - core は libobs に依存しないため blog() を直接呼ばない
+ * - プラグインは setSink() で blog() へ転送し、ベンチマーク等では標準エラー出力（既定）に書く
+ * - レベルの値は libobs の LOG_ERROR / LOG_WARNING / LOG_INFO / LOG_DEBUG と同じ
+ */
+namespace corelog {
+
+enum Level : int {
+	Error = 100,
+	Warning = 200,
+	Info = 300,
+	Debug = 400,
+};
+
+using Sink = void (*)(int level, const char *message);
+
+// nullptr で既定（標準エラー出力）に戻す
+void setSink(Sink sink);
+
+#if defined(__GNUC__) || defined(__clang__)
+__attribute__((format(printf, 2, 3)))
+#endif
+void write(int level, const char *format, ...);
+
+} // namespace corelog
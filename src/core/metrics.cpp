@@ -0,0 +1,233 @@
+// obs-scene-switcher plugin
+// Copyright (C) 2025 ksmksks
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "metrics.hpp"
+#include "core/rule_key.hpp"
+
+#include <algorithm>
+#include <cstdarg>
+#include <cstdio>
+
+namespace metrics {
+
+namespace {
+
+void appendf(std::string &out, const char *fmt, ...)
+#if defined(__GNUC__)
+	__attribute__((format(printf, 2, 3)))
+#endif
+	;
+
+void appendf(std::string &out, const char *fmt, ...)
+{
+	char buf[512];
+	va_list args;
+	va_start(args, fmt);
+	const int n = std::vsnprintf(buf, sizeof(buf), fmt, args);
+	va_end(args);
+	if (n > 0)
+		out.append(buf, std::min(static_cast<size_t>(n), sizeof(buf) - 1));
+}
+
+void renderCounter(std::string &out, const char *name, const char *help, const Counter &counter)
+{
+	appendf(out, "# HELP %s %s\n# TYPE %s counter\n%s %llu\n", name, help, name, name,
+		(unsigned long long)counter.value());
+}
+
+void renderHistogram(std::string &out, const std::string &name, const std::string &help,
+		     const LatencyHistogram &histogram)
+{
+	appendf(out, "# HELP %s %s\n# TYPE %s histogram\n", name.c_str(), help.c_str(), name.c_str());
+
+	// バケットは累積値で出力する（単位は秒）
+	uint64_t cumulative = 0;
+	for (size_t i = 0; i < LatencyHistogram::kBoundsUs.size(); ++i) {
+		cumulative += histogram.bucket(i);
+		appendf(out, "%s_bucket{le=\"%g\"} %llu\n", name.c_str(), LatencyHistogram::kBoundsUs[i] / 1e6,
+			(unsigned long long)cumulative);
+	}
+	cumulative += histogram.bucket(LatencyHistogram::kBuckets - 1);
+	appendf(out, "%s_bucket{le=\"+Inf\"} %llu\n", name.c_str(), (unsigned long long)cumulative);
+	appendf(out, "%s_sum %.6f\n%s_count %llu\n", name.c_str(), histogram.sumUs() / 1e6, name.c_str(),
+		(unsigned long long)cumulative);
+}
+
+// ラベル値のエスケープ（\ " 改行）
+std::string escapeLabel(const std::string &value)
+{
+	std::string out;
+	out.reserve(value.size());
+	for (char c : value) {
+		if (c == '\\' || c == '"') {
+			out += '\\';
+			out += c;
+		} else if (c == '\n') {
+			out += "\\n";
+		} else {
+			out += c;
+		}
+	}
+	return out;
+}
+
+// 発火回数を引き継ぐルールの識別。ラベルが同じでも発火条件が違えば別のルールとして数える
+uint64_t ruleCounterKey(const RewardRule &rule)
+{
+	constexpr uint8_t kRuleCounterKeyTag = 0x90;  // クールダウン・コンボのキーと混ざらないようにする
+
+	const RulePredicates &p = rule.predicates;
+	KeyHash key(kRuleCounterKeyTag);
+	key.addRule(rule).add(p.inputPattern).add(static_cast<uint8_t>(p.inputRegex)).add(std::to_string(p.minBits));
+	for (const auto &user : p.allowUsers)
+		key.add(user);
+	key.add(0xfe);
+	for (const auto &user : p.denyUsers)
+		key.add(user);
+	return key.value();
+}
+
+} // namespace
+
+Registry &Registry::instance()
+{
+	static Registry registry;
+	return registry;
+}
+
+std::vector<std::shared_ptr<Counter>> Registry::setRules(const std::vector<RewardRule> &rules)
+{
+	std::vector<RuleCounter> table;
+	table.reserve(rules.size());
+	std::vector<std::shared_ptr<Counter>> counters;
+	counters.reserve(rules.size());
+
+	std::lock_guard<std::mutex> lock(rulesMutex_);
+	for (const auto &rule : rules) {
+		RuleCounter entry;
+		entry.key = ruleCounterKey(rule);
+		entry.occurrence = static_cast<size_t>(std::count_if(
+			table.begin(), table.end(), [&](const RuleCounter &other) { return other.key == entry.key; }));
+		entry.label = ruleLabel(rule);
+
+		// 同じルールのカウンタはそのまま共有する（延期中・tick 待ちの古いスナップショットの発火も失わない）
+		const auto old = std::find_if(rules_.begin(), rules_.end(), [&](const RuleCounter &other) {
+			return other.key == entry.key && other.occurrence == entry.occurrence;
+		});
+		entry.fired = old != rules_.end() ? old->fired : std::make_shared<Counter>();
+
+		counters.push_back(entry.fired);
+		table.push_back(std::move(entry));
+	}
+
+	rules_ = std::move(table);
+	return counters;
+}
+
+void Registry::registerHistogram(const std::string &name, const std::string &help, const LatencyHistogram *histogram)
+{
+	std::lock_guard<std::mutex> lock(histogramsMutex_);
+	histograms_.push_back({name, help, histogram});
+}
+
+void Registry::unregisterHistogram(const LatencyHistogram *histogram)
+{
+	std::lock_guard<std::mutex> lock(histogramsMutex_);
+	histograms_.erase(std::remove_if(histograms_.begin(), histograms_.end(),
+					 [histogram](const NamedHistogram &h) { return h.histogram == histogram; }),
+			  histograms_.end());
+}
+
+std::string Registry::renderPrometheus() const
+{
+	std::string out;
+	out.reserve(8192);
+
+	renderCounter(out, "scene_switcher_redemptions_received_total", "Channel point redemptions received",
+		      redemptionsReceived);
+	renderCounter(out, "scene_switcher_redemptions_matched_total", "Notifications that matched an enabled rule",
+		      redemptionsMatched);
+	renderCounter(out, "scene_switcher_redemptions_unmatched_total", "Notifications with no matching rule",
+		      redemptionsUnmatched);
+	renderCounter(out, "scene_switcher_redemptions_suppressed_total",
+		      "Switch requests suppressed while a switch was active", redemptionsSuppressed);
+	renderCounter(out, "scene_switcher_redemptions_deduplicated_total",
+		      "EventSub notifications dropped as duplicate message_id", redemptionsDeduplicated);
+	renderCounter(out, "scene_switcher_combos_completed_total", "Combo rules that reached their count and ran",
+		      combosCompleted);
+	renderCounter(out, "scene_switcher_combo_events_absorbed_total",
+		      "Notifications counted toward a combo without running it", comboEventsAbsorbed);
+	renderCounter(out, "scene_switcher_stale_events_dropped_total",
+		      "Notifications not run because they arrived later than the rule's age limit", staleEventsDropped);
+	renderCounter(out, "scene_switcher_eventsub_reconnects_total", "EventSub WebSocket reconnect attempts",
+		      eventsubReconnects);
+	renderCounter(out, "scene_switcher_eventsub_subscriptions_created_total", "EventSub subscriptions created",
+		      eventsubSubscriptionsCreated);
+	renderCounter(out, "scene_switcher_eventsub_subscriptions_reused_total",
+		      "EventSub subscriptions reused instead of created (listed, 409 or migrated session)",
+		      eventsubSubscriptionsReused);
+	renderCounter(out, "scene_switcher_eventsub_revocations_total", "EventSub subscription revocations",
+		      eventsubRevocations);
+	renderCounter(out, "scene_switcher_token_refreshes_total", "Successful access token refreshes",
+		      tokenRefreshes);
+	renderCounter(out, "scene_switcher_token_refresh_failures_total", "Failed access token refreshes",
+		      tokenRefreshFailures);
+	renderCounter(out, "scene_switcher_helix_coalesced_total",
+		      "Helix GETs that joined an identical in-flight request", helixCoalesced);
+	renderCounter(out, "scene_switcher_helix_cache_hits_total", "Helix GETs answered from the response cache",
+		      helixCacheHits);
+	renderCounter(out, "scene_switcher_helix_throttled_total",
+		      "Times Helix dispatch waited for the rate-limit bucket", helixThrottled);
+	renderCounter(out, "scene_switcher_helix_rate_limited_total", "Helix responses with HTTP 429",
+		      helixRateLimited);
+	renderCounter(out, "scene_switcher_redemption_status_batches_total",
+		      "Batched redemption status updates sent to Helix", redemptionStatusBatches);
+	renderCounter(out, "scene_switcher_redemption_status_updates_total",
+		      "Redemptions marked FULFILLED or CANCELED", redemptionStatusUpdates);
+	renderCounter(out, "scene_switcher_redemption_status_failures_total",
+		      "Redemptions whose status update failed", redemptionStatusFailures);
+
+	out += "# HELP scene_switcher_events_received_total EventSub notifications received by type\n"
+	       "# TYPE scene_switcher_events_received_total counter\n";
+	for (const auto &info : kEventTypes) {
+		appendf(out, "scene_switcher_events_received_total{kind=\"%s\"} %llu\n", info.name,
+			(unsigned long long)eventsReceived[static_cast<size_t>(info.kind)].value());
+	}
+
+	out += "# HELP scene_switcher_cooldown_rejected_total Matched rules not run because of a cooldown\n"
+	       "# TYPE scene_switcher_cooldown_rejected_total counter\n";
+	for (size_t i = 0; i < kCooldownScopeCount; ++i) {
+		appendf(out, "scene_switcher_cooldown_rejected_total{scope=\"%s\"} %llu\n",
+			cooldownScopeName(static_cast<CooldownScope>(i)), (unsigned long long)cooldownRejected[i].value());
+	}
+
+	// ルール別の発火回数
+	out += "# HELP scene_switcher_rule_fired_total Times each rule fired\n"
+	       "# TYPE scene_switcher_rule_fired_total counter\n";
+	{
+		std::lock_guard<std::mutex> lock(rulesMutex_);
+		for (size_t i = 0; i < rules_.size(); ++i) {
+			const auto &rule = rules_[i];
+			appendf(out, "scene_switcher_rule_fired_total{rule=\"%s\",index=\"%zu\"} %llu\n",
+				escapeLabel(rule.label).c_str(), i, (unsigned long long)rule.fired->value());
+		}
+	}
+
+	renderHistogram(out, "scene_switcher_helix_request_seconds", "Twitch Helix API request latency",
+			helixLatency);
+	renderHistogram(out, "scene_switcher_switch_on_air_seconds", "Switch request to on-air latency",
+			switchOnAir);
+	renderHistogram(out, "scene_switcher_redemption_status_flush_seconds",
+			"First queued redemption to batched status update response", redemptionStatusFlush);
+	renderHistogram(out, "scene_switcher_event_age_seconds",
+			"Notification age on arrival (event time to receipt, server clock offset removed)", eventAge);
+
+	std::lock_guard<std::mutex> lock(histogramsMutex_);
+	for (const auto &h : histograms_)
+		renderHistogram(out, h.name, h.help, *h.histogram);
+
+	return out;
+}
+
+} // namespace metrics
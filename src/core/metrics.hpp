@@ -0,0 +1,145 @@
+// obs-scene-switcher plugin
+// Copyright (C) 2025 ksmksks
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+#include "core/cooldown_table.hpp"
+#include "core/latency_histogram.hpp"
+#include "core/reward_rule.hpp"
+#include "core/twitch_event.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace metrics {
+
+// ロックフリーの単調増加カウンタ
+class Counter {
+public:
+	void inc(uint64_t n = 1) { value_.fetch_add(n, std::memory_order_relaxed); }
+	uint64_t value() const { return value_.load(std::memory_order_relaxed); }
+
+private:
+	std::atomic<uint64_t> value_{0};
+};
+
+// スコープの経過時間をヒストグラムに記録する
+class ScopedLatency {
+public:
+	explicit ScopedLatency(LatencyHistogram &histogram)
+		: histogram_(histogram),
+		  start_(std::chrono::steady_clock::now())
+	{
+	}
+
+	~ScopedLatency()
+	{
+		const auto us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() -
+										     start_)
+					.count();
+		histogram_.record(static_cast<uint64_t>(us));
+	}
+
+	ScopedLatency(const ScopedLatency &) = delete;
+	ScopedLatency &operator=(const ScopedLatency &) = delete;
+
+private:
+	LatencyHistogram &histogram_;
+	std::chrono::steady_clock::time_point start_;
+};
+
+/**
+ * プラグイン全体のメトリクス
+ *
+ * - カウンタ・ヒストグラムの更新はロックフリー（ホットパスから直接呼べる）
+ * - 他のオブジェクトが所有するヒストグラムは registerHistogram() で登録する
+ * - renderPrometheus() は Prometheus テキスト形式で出力する（任意のスレッドから呼べる）
+ */
+class Registry {
+public:
+	static Registry &instance();
+
+	// EventSub の通知（種類別。添字は EventKind）
+	Counter eventsReceived[kEventKindCount];
+
+	// リデンプション（matched / unmatched はすべての種類の通知を数える）
+	Counter redemptionsReceived;
+	Counter redemptionsMatched;
+	Counter redemptionsUnmatched;
+	Counter redemptionsSuppressed;
+	Counter redemptionsDeduplicated;
+	// クールダウン中で実行しなかったルール（単位別。添字は CooldownScope）
+	Counter cooldownRejected[kCooldownScopeCount];
+	// コンボルール（揃って実行した回数・揃うまで実行せずに数えた通知）
+	Counter combosCompleted;
+	Counter comboEventsAbsorbed;
+	// 発生から時間が経ちすぎて実行しなかった通知（ルールの上限秒数を超えたもの）
+	Counter staleEventsDropped;
+
+	// 接続・認証
+	Counter eventsubReconnects;
+	// EventSub サブスクリプション（作成・既存の再利用・revocation）
+	Counter eventsubSubscriptionsCreated;
+	Counter eventsubSubscriptionsReused;
+	Counter eventsubRevocations;
+	Counter tokenRefreshes;
+	Counter tokenRefreshFailures;
+
+	// Helix GET の重複排除（実行中の同一要求に相乗り・TTL キャッシュから応答）
+	Counter helixCoalesced;
+	Counter helixCacheHits;
+	// Helix のレート制限（バケットが空で送信を待った回数・429 応答）
+	Counter helixThrottled;
+	Counter helixRateLimited;
+	// 引き換えの状態更新（まとめて送った PATCH の回数・更新した引き換え数・失敗した引き換え数）
+	Counter redemptionStatusBatches;
+	Counter redemptionStatusUpdates;
+	Counter redemptionStatusFailures;
+
+	// Helix API 呼び出し（要求送信から応答の読み終わりまで）
+	LatencyHistogram helixLatency;
+	// 切替要求からオンエアまで（全ルール合算）
+	LatencyHistogram switchOnAir;
+	// 引き換えの状態更新（最初に積んでから応答まで）
+	LatencyHistogram redemptionStatusFlush;
+	// 通知の発生から受信まで（サーバーとの時計のずれを除いた推定値）
+	LatencyHistogram eventAge;
+
+	// ルール一覧の更新（内容が同じルールは同じカウンタを使い続ける）。
+	// 戻り値は rules と同じ並びの発火回数カウンタで、ルール側に持たせて実行時に直接 inc() する
+	std::vector<std::shared_ptr<Counter>> setRules(const std::vector<RewardRule> &rules);
+
+	// 外部所有のヒストグラムを登録（owner の寿命中のみ有効、解除は unregisterHistogram）
+	void registerHistogram(const std::string &name, const std::string &help, const LatencyHistogram *histogram);
+	void unregisterHistogram(const LatencyHistogram *histogram);
+
+	std::string renderPrometheus() const;
+
+private:
+	Registry() = default;
+
+	struct RuleCounter {
+		uint64_t key = 0;       // ルールの内容（切替元・先と発火条件）のハッシュ
+		size_t occurrence = 0;  // 内容がまったく同じルールのうち何番目か
+		std::string label;
+		std::shared_ptr<Counter> fired;
+	};
+
+	// 表の差し替えと出力だけがロックを取る（発火時はカウンタを直接 inc() するので取らない）
+	mutable std::mutex rulesMutex_;
+	std::vector<RuleCounter> rules_;
+
+	struct NamedHistogram {
+		std::string name;
+		std::string help;
+		const LatencyHistogram *histogram;
+	};
+	mutable std::mutex histogramsMutex_;
+	std::vector<NamedHistogram> histograms_;
+};
+
+} // namespace metrics
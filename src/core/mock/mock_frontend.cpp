@@ -0,0 +1,163 @@
+// obs-scene-switcher plugin
+// Copyright (C) 2025 ksmksks
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "mock_frontend.hpp"
+
+#include <algorithm>
+
+MockFrontend::MockFrontend(std::vector<std::string> scenes, int fps) : scenes_(std::move(scenes))
+{
+	if (!scenes_.empty())
+		current_ = scenes_.front();
+	if (fps > 0)
+		frameIntervalNs_ = 1000000000ULL / static_cast<uint64_t>(fps);
+}
+
+void MockFrontend::setTransition(const std::string &name, int durationMs, bool cut)
+{
+	transition_ = name;
+	durationMs_ = std::max(0, durationMs);
+	cut_ = cut || durationMs_ == 0;
+}
+
+void MockFrontend::addTransition(const std::string &name)
+{
+	transitions_.push_back(name);
+}
+
+void MockFrontend::addSceneItem(const std::string &scene, const std::string &source, bool visible)
+{
+	sceneItems_[{scene, source}] = visible;
+}
+
+void MockFrontend::addFilter(const std::string &source, const std::string &filter, bool enabled)
+{
+	filters_[{source, filter}] = enabled;
+}
+
+void MockFrontend::addMediaSource(const std::string &source)
+{
+	mediaSources_.insert(source);
+}
+
+bool MockFrontend::setCurrentScene(const std::string &name)
+{
+	if (std::find(scenes_.begin(), scenes_.end(), name) == scenes_.end())
+		return false;
+
+	++switchRequests_;
+	++inFlight_;
+
+	// 切替要求は呼び出し元に戻ってから反映される（OBS の UI スレッドと同じ）
+	const bool cut = cut_;
+	const int durationMs = durationMs_;
+	auto begin = [this, name, cut]() {
+		current_ = name;
+		emitEvent(Event::SceneChanged);
+		if (cut)
+			--inFlight_;
+	};
+
+	if (!scheduler_) {
+		begin();
+		if (!cut) {
+			emitEvent(Event::TransitionStopped);
+			--inFlight_;
+		}
+		return true;
+	}
+
+	scheduler_(std::chrono::milliseconds(0), std::move(begin));
+	if (!cut) {
+		scheduler_(std::chrono::milliseconds(durationMs), [this]() {
+			emitEvent(Event::TransitionStopped);
+			--inFlight_;
+		});
+	}
+	return true;
+}
+
+void MockFrontend::compileTransitions(std::vector<RewardRule> &rules)
+{
+	for (auto &rule : rules) {
+		rule.transitionSlot = -1;
+		if (rule.transitionName.empty())
+			continue;
+
+		auto it = std::find(transitions_.begin(), transitions_.end(), rule.transitionName);
+		if (it != transitions_.end())
+			rule.transitionSlot = static_cast<int>(it - transitions_.begin());
+	}
+}
+
+bool MockFrontend::applyTransitionOverride(const RewardRule &rule)
+{
+	restoreTransitionOverride();
+
+	if (rule.transitionSlot < 0 || static_cast<size_t>(rule.transitionSlot) >= transitions_.size())
+		return false;
+
+	override_ = SavedTransition{transition_, durationMs_, cut_};
+	transition_ = transitions_[rule.transitionSlot];
+	if (rule.transitionDurationMs > 0)
+		durationMs_ = rule.transitionDurationMs;
+	cut_ = durationMs_ == 0;
+	return true;
+}
+
+void MockFrontend::restoreTransitionOverride()
+{
+	if (!override_)
+		return;
+
+	transition_ = override_->name;
+	durationMs_ = override_->durationMs;
+	cut_ = override_->cut;
+	override_.reset();
+}
+
+uint64_t MockFrontend::videoFrameTimeNs() const
+{
+	// 直前のフレーム境界に丸める
+	const uint64_t now = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+								   std::chrono::steady_clock::now().time_since_epoch())
+								   .count());
+	return frameIntervalNs_ ? now - now % frameIntervalNs_ : now;
+}
+
+std::optional<bool> MockFrontend::setSceneItemVisible(const std::string &scene, const std::string &source,
+						      bool visible)
+{
+	auto it = sceneItems_.find({scene, source});
+	if (it == sceneItems_.end())
+		return std::nullopt;
+
+	const bool previous = it->second;
+	it->second = visible;
+	return previous;
+}
+
+std::optional<bool> MockFrontend::setFilterEnabled(const std::string &source, const std::string &filter, bool enabled)
+{
+	auto it = filters_.find({source, filter});
+	if (it == filters_.end())
+		return std::nullopt;
+
+	const bool previous = it->second;
+	it->second = enabled;
+	return previous;
+}
+
+bool MockFrontend::restartMedia(const std::string &source)
+{
+	return mediaSources_.count(source) > 0;
+}
+
+void MockFrontend::stopMedia(const std::string &) {}
+
+void MockFrontend::emitEvent(Event event)
+{
+	if (eventCallback_)
+		eventCallback_(event);
+}
@@ -0,0 +1,97 @@
+// obs-scene-switcher plugin
+// Copyright (C) 2025 ksmksks
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+#include "core/frontend_port.hpp"
+#include <chrono>
+#include <functional>
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * OBS なしで core を動かすためのフロントエンドの模擬実装（ベンチマーク用）
+ *
+ * - シーン一覧・現在のシーン・トランジションの長さを保持する
+ * - 切替要求は Scheduler 経由で遅延させ、OBS と同じ順序で EventCallback を呼ぶ
+ *   （開始時に SceneChanged、遷移時間の経過後に TransitionStopped。カットは SceneChanged のみ）
+ * - フレーム時刻は単調時計から算出する
+ */
+class MockFrontend : public FrontendPort {
+public:
+	enum class Event {
+		SceneChanged,
+		TransitionStopped
+	};
+
+	using EventCallback = std::function<void(Event)>;
+	using Scheduler = std::function<void(std::chrono::milliseconds delay, std::function<void()> task)>;
+
+	explicit MockFrontend(std::vector<std::string> scenes, int fps = 60);
+
+	void setScheduler(Scheduler scheduler) { scheduler_ = std::move(scheduler); }
+	void setEventCallback(EventCallback callback) { eventCallback_ = std::move(callback); }
+
+	// 現在のトランジション（durationMs <= 0 または cut ならカット扱い）
+	void setTransition(const std::string &name, int durationMs, bool cut);
+	void addTransition(const std::string &name);
+	// アクションの対象
+	void addSceneItem(const std::string &scene, const std::string &source, bool visible);
+	void addFilter(const std::string &source, const std::string &filter, bool enabled);
+	void addMediaSource(const std::string &source);
+
+	// 着地待ちの切替の数
+	int switchesInFlight() const { return inFlight_; }
+	uint64_t switchRequests() const { return switchRequests_; }
+
+	std::vector<std::string> sceneNames() const override { return scenes_; }
+	std::string currentScene() const override { return current_; }
+	bool setCurrentScene(const std::string &name) override;
+
+	int transitionDurationMs() const override { return durationMs_; }
+	bool isCutTransition() const override { return cut_; }
+	void compileTransitions(std::vector<RewardRule> &rules) override;
+	bool applyTransitionOverride(const RewardRule &rule) override;
+	void restoreTransitionOverride() override;
+
+	uint64_t videoFrameTimeNs() const override;
+	uint64_t frameIntervalNs() const override { return frameIntervalNs_; }
+
+	std::optional<bool> setSceneItemVisible(const std::string &scene, const std::string &source,
+						bool visible) override;
+	std::optional<bool> setFilterEnabled(const std::string &source, const std::string &filter,
+					     bool enabled) override;
+	bool restartMedia(const std::string &source) override;
+	void stopMedia(const std::string &source) override;
+
+private:
+	void emitEvent(Event event);
+
+	std::vector<std::string> scenes_;
+	std::string current_;
+	uint64_t frameIntervalNs_ = 0;
+
+	std::string transition_ = "Cut";
+	int durationMs_ = 0;
+	bool cut_ = true;
+	std::vector<std::string> transitions_;
+
+	struct SavedTransition {
+		std::string name;
+		int durationMs = 0;
+		bool cut = true;
+	};
+	std::optional<SavedTransition> override_;
+
+	std::map<std::pair<std::string, std::string>, bool> sceneItems_;
+	std::map<std::pair<std::string, std::string>, bool> filters_;
+	std::set<std::string> mediaSources_;
+
+	Scheduler scheduler_;
+	EventCallback eventCallback_;
+	int inFlight_ = 0;
+	uint64_t switchRequests_ = 0;
+};
@@ -0,0 +1,89 @@
+// obs-scene-switcher plugin
+// Copyright (C) 2025 ksmksks
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "rate_limiter.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+RateLimiter::RateLimiter(double capacity, std::chrono::milliseconds refillInterval)
+	: capacity_(capacity),
+	  perMs_(capacity / static_cast<double>(std::max<long long>(1, refillInterval.count()))),
+	  tokens_(capacity),
+	  last_(Clock::now())
+{
+}
+
+void RateLimiter::refill(Clock::time_point now)
+{
+	if (now <= last_)
+		return;
+
+	const double elapsedMs = std::chrono::duration<double, std::milli>(now - last_).count();
+	tokens_ = std::min(capacity_, tokens_ + elapsedMs * perMs_);
+	last_ = now;
+}
+
+bool RateLimiter::tryAcquire(Clock::time_point now)
+{
+	if (now < pausedUntil_)
+		return false;
+
+	refill(now);
+	if (tokens_ < 1.0)
+		return false;
+
+	tokens_ -= 1.0;
+	return true;
+}
+
+RateLimiter::Clock::time_point RateLimiter::nextAvailable(Clock::time_point now) const
+{
+	if (now < pausedUntil_)
+		return pausedUntil_;
+
+	const double current = available(now);
+	if (current >= 1.0)
+		return now;
+
+	const auto waitMs = static_cast<long long>(std::ceil((1.0 - current) / perMs_));
+	return now + std::chrono::milliseconds(waitMs);
+}
+
+double RateLimiter::available(Clock::time_point now) const
+{
+	if (now <= last_)
+		return tokens_;
+
+	const double elapsedMs = std::chrono::duration<double, std::milli>(now - last_).count();
+	return std::min(capacity_, tokens_ + elapsedMs * perMs_);
+}
+
+void RateLimiter::updateFromServer(int limit, int remaining, Clock::time_point reset, Clock::time_point now)
+{
+	if (limit > 0 && static_cast<double>(limit) != capacity_) {
+		// 補充速度は容量に比例させる（満杯までの時間は変えない）
+		perMs_ = perMs_ * static_cast<double>(limit) / capacity_;
+		capacity_ = static_cast<double>(limit);
+	}
+
+	refill(now);
+	if (remaining >= 0)
+		tokens_ = std::min(capacity_, static_cast<double>(remaining));
+
+	// 使い切ったらリセット時刻まで待つ
+	if (remaining == 0 && reset > now)
+		pauseUntil(reset);
+}
+
+void RateLimiter::pauseUntil(Clock::time_point until)
+{
+	pausedUntil_ = std::max(pausedUntil_, until);
+}
+
+RateLimiter::Clock::time_point RateLimiter::fromUnixSeconds(long long seconds)
+{
+	const auto wall = std::chrono::system_clock::time_point(std::chrono::seconds(seconds));
+	return Clock::now() + std::chrono::duration_cast<Clock::duration>(wall - std::chrono::system_clock::now());
+}
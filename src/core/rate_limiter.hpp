@@ -0,0 +1,45 @@
+// obs-scene-switcher plugin
+// Copyright (C) 2025 ksmksks
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+#include <chrono>
+
+/**
+ * サーバーのレート制限に追従するトークンバケット
+ *
+ * - 容量 capacity、refillInterval で満杯まで連続的に補充される（Twitch Helix は 800 ポイント/分）
+ * - 応答の Ratelimit-Limit / Remaining / Reset ヘッダを updateFromServer() で反映し、
+ *   ローカルの見積もりをサーバーの値に合わせる
+ * - 残量 0 や 429 応答ではリセット時刻まで一切払い出さない
+ * - スレッドセーフではない（呼び出し側で排他すること）
+ */
+class RateLimiter {
+public:
+	using Clock = std::chrono::steady_clock;
+
+	RateLimiter(double capacity, std::chrono::milliseconds refillInterval);
+
+	// 1 ポイント消費できれば消費して true
+	bool tryAcquire(Clock::time_point now = Clock::now());
+	// 次に 1 ポイント払い出せる時刻（now 以前なら即時）
+	Clock::time_point nextAvailable(Clock::time_point now = Clock::now()) const;
+	double available(Clock::time_point now = Clock::now()) const;
+
+	// サーバーが示した残量を反映する（limit <= 0 なら容量は変えない）
+	void updateFromServer(int limit, int remaining, Clock::time_point reset, Clock::time_point now = Clock::now());
+	// until まで払い出しを止める（429 応答など）
+	void pauseUntil(Clock::time_point until);
+
+	// Unix 時刻（秒）を単調時計の時刻に換算する
+	static Clock::time_point fromUnixSeconds(long long seconds);
+
+private:
+	void refill(Clock::time_point now);
+
+	double capacity_;
+	double perMs_;  // 1ms あたりの補充量
+	double tokens_;
+	Clock::time_point last_;
+	Clock::time_point pausedUntil_{};
+};
@@ -0,0 +1,146 @@
+// obs-scene-switcher plugin
+// Copyright (C) 2025 ksmksks
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "redemption_batcher.hpp"
+#include "log.hpp"
+#include "metrics.hpp"
+
+const char *redemptionStatusName(RedemptionStatus status)
+{
+	return status == RedemptionStatus::Canceled ? "CANCELED" : "FULFILLED";
+}
+
+RedemptionBatcher::RedemptionBatcher(int flushIntervalMs) : flushIntervalMs_(flushIntervalMs) {}
+
+RedemptionBatcher::~RedemptionBatcher() = default;
+
+bool RedemptionBatcher::enqueue(const std::string &rewardId, const std::string &redemptionId,
+				RedemptionStatus status)
+{
+	if (rewardId.empty() || redemptionId.empty() || isUnmanageable(rewardId))
+		return false;
+
+	const Key key{rewardId, status};
+	Batch &batch = pending_[key];
+	if (batch.ids.empty())
+		batch.firstQueuedAt = Clock::now();
+	batch.ids.push_back(redemptionId);
+
+	// 上限に達したら待たずに送る
+	if (batch.ids.size() >= kMaxBatchSize) {
+		Batch full = std::move(batch);
+		pending_.erase(key);
+		send(key, std::move(full));
+		return true;
+	}
+
+	if (!flushScheduled_) {
+		if (!scheduler_) {
+			flush();
+			return true;
+		}
+
+		flushScheduled_ = true;
+		const uint64_t generation = generation_;
+		scheduler_(flushIntervalMs_, [this, generation]() {
+			if (generation != generation_)
+				return;
+			flushScheduled_ = false;
+			flush();
+		});
+	}
+	return true;
+}
+
+void RedemptionBatcher::flush()
+{
+	auto batches = std::move(pending_);
+	pending_.clear();
+
+	for (auto &[key, batch] : batches)
+		send(key, std::move(batch));
+}
+
+void RedemptionBatcher::clear()
+{
+	pending_.clear();
+	unmanageable_.clear();
+	flushScheduled_ = false;
+	generation_++;
+}
+
+size_t RedemptionBatcher::pendingCount() const
+{
+	size_t count = 0;
+	for (const auto &[key, batch] : pending_)
+		count += batch.ids.size();
+	return count;
+}
+
+void RedemptionBatcher::send(const Key &key, Batch batch)
+{
+	if (!sender_ || batch.ids.empty())
+		return;
+
+	const Clock::time_point firstQueuedAt = batch.firstQueuedAt;
+	const uint64_t generation = generation_;
+	const std::vector<std::string> ids = batch.ids;
+
+	sender_(key.first, batch.ids, key.second, [this, key, ids, firstQueuedAt, generation](int httpStatus) {
+		if (generation != generation_)
+			return;
+		onSent(key, ids, firstQueuedAt, httpStatus);
+	});
+}
+
+void RedemptionBatcher::onSent(const Key &key, const std::vector<std::string> &ids, Clock::time_point firstQueuedAt,
+			       int httpStatus)
+{
+	const size_t size = ids.size();
+	auto &registry = metrics::Registry::instance();
+	const auto latencyUs =
+		std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - firstQueuedAt).count();
+
+	if (httpStatus >= 200 && httpStatus < 300) {
+		registry.redemptionStatusBatches.inc();
+		registry.redemptionStatusUpdates.inc(size);
+		registry.redemptionStatusFlush.record(static_cast<uint64_t>(latencyUs));
+		corelog::write(corelog::Debug,
+			       "[obs-scene-switcher] Redemption status %s: %zu ids for reward %s in %.1f ms",
+			       redemptionStatusName(key.second), size, key.first.c_str(),
+			       static_cast<double>(latencyUs) / 1000.0);
+		return;
+	}
+
+	// どの ID が更新できなかったかは返らないため、1 件ずつ送り直して残りを更新する
+	if (httpStatus == 404 && size > 1) {
+		corelog::write(corelog::Debug,
+			       "[obs-scene-switcher] Redemption status %s for reward %s returned 404; retrying %zu ids "
+			       "one by one",
+			       redemptionStatusName(key.second), key.first.c_str(), size);
+		for (const auto &id : ids)
+			send(key, Batch{{id}, firstQueuedAt});
+		return;
+	}
+
+	registry.redemptionStatusFailures.inc(size);
+
+	// 他のクライアントで作った報酬は更新できない（一度だけ記録して以降は積まない）
+	if (httpStatus == 403) {
+		if (unmanageable_.insert(key.first).second) {
+			corelog::write(corelog::Warning,
+				       "[obs-scene-switcher] Reward %s is not manageable by this client (HTTP %d); "
+				       "redemption status updates disabled for it",
+				       key.first.c_str(), httpStatus);
+		}
+		pending_.erase({key.first, RedemptionStatus::Fulfilled});
+		pending_.erase({key.first, RedemptionStatus::Canceled});
+		return;
+	}
+
+	// 404 は処理済み・取り消し済みの引き換えや削除された報酬（この ID だけの失敗）
+	corelog::write(corelog::Warning,
+		       "[obs-scene-switcher] Redemption status update failed: %zu ids for reward %s (HTTP %d)", size,
+		       key.first.c_str(), httpStatus);
+}
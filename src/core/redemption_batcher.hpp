@@ -0,0 +1,81 @@
+// obs-scene-switcher plugin
+// Copyright (C) 2025 ksmksks
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+#include <chrono>
+#include <functional>
+#include <map>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+// 引き換えの最終状態（Helix の status 値）
+enum class RedemptionStatus {
+	Fulfilled,
+	Canceled  // ポイントは視聴者に返還される
+};
+
+const char *redemptionStatusName(RedemptionStatus status);
+
+/**
+ * 引き換えの状態更新（FULFILLED / CANCELED）を報酬ごとにまとめて送る
+ *
+ * - Helix の PATCH は 1 回で同じ報酬の引き換え ID を最大 kMaxBatchSize 件まで更新できる
+ * - 最初の ID を受けてから flushIntervalMs 後、または上限に達した時点で送信する
+ * - 報酬がこのクライアントの管理外（403）なら以降はその報酬を積まない
+ * - 404 はまとめた ID のどれかが UNFULFILLED でない（モデレーターが処理済みなど）ことがあるため、
+ *   1 件ずつ送り直して残りの ID を更新する
+ * - スレッドセーフではない（UI スレッドから使い、送信完了も UI スレッドで通知すること）
+ */
+class RedemptionBatcher {
+public:
+	using Clock = std::chrono::steady_clock;
+	using Scheduler = std::function<void(int delayMs, std::function<void()>)>;
+	// 送信完了時に done(HTTP ステータス、通信失敗なら 0) を呼ぶ
+	using Sender = std::function<void(const std::string &rewardId, const std::vector<std::string> &ids,
+					  RedemptionStatus status, std::function<void(int httpStatus)> done)>;
+
+	static constexpr size_t kMaxBatchSize = 50;
+
+	explicit RedemptionBatcher(int flushIntervalMs = 250);
+	~RedemptionBatcher();
+
+	RedemptionBatcher(const RedemptionBatcher &) = delete;
+	RedemptionBatcher &operator=(const RedemptionBatcher &) = delete;
+
+	void setScheduler(Scheduler scheduler) { scheduler_ = std::move(scheduler); }
+	void setSender(Sender sender) { sender_ = std::move(sender); }
+
+	// 管理外の報酬なら false（積まない）
+	bool enqueue(const std::string &rewardId, const std::string &redemptionId, RedemptionStatus status);
+	// 溜まっている分をすぐに送る
+	void flush();
+	// 溜まっている分と管理外の記録を破棄する（ログアウト時など）
+	void clear();
+
+	bool isUnmanageable(const std::string &rewardId) const { return unmanageable_.count(rewardId) > 0; }
+	size_t pendingCount() const;
+
+private:
+	using Key = std::pair<std::string, RedemptionStatus>;
+
+	struct Batch {
+		std::vector<std::string> ids;
+		Clock::time_point firstQueuedAt;
+	};
+
+	void send(const Key &key, Batch batch);
+	void onSent(const Key &key, const std::vector<std::string> &ids, Clock::time_point firstQueuedAt,
+		    int httpStatus);
+
+	int flushIntervalMs_;
+	Scheduler scheduler_;
+	Sender sender_;
+
+	std::map<Key, Batch> pending_;
+	bool flushScheduled_ = false;
+	uint64_t generation_ = 0;  // clear() 以前に予約した flush・送信完了を無視するため
+	std::unordered_set<std::string> unmanageable_;
+};
@@ -3,13 +3,96 @@
 // SPDX-License-Identifier: GPL-2.0-or-later
 
 #pragma once
+#include "core/rule_action.hpp"
+#include "core/twitch_event.hpp"
+#include <memory>
 #include <string>
+#include <vector>
+
+class CompiledPredicates;
+namespace metrics {
+class Counter;
+}
+
+// 発火条件（空の項目は条件なし）。照合用の形にはルール保存時に compileRulePredicates() で変換する
+struct RulePredicates {
+	std::string inputPattern;  // 入力（引き換えのテキスト・Bits のメッセージ）に対する条件
+	bool inputRegex = false;   // true: inputPattern を正規表現として扱う / false: カンマ区切りのキーワード
+	std::vector<std::string> allowUsers;  // 空でなければこのユーザー（ログイン名・表示名）だけ
+	std::vector<std::string> denyUsers;   // このユーザーは除外
+	int minBits = 0;                      // Bits ルールのみ。0 なら下限なし
+
+	bool empty() const
+	{
+		return inputPattern.empty() && allowUsers.empty() && denyUsers.empty() && minBits <= 0;
+	}
+};
+
+// 実行後に同じ要求を受け付けない秒数（0 なら制限なし）
+struct RuleCooldowns {
+	int ruleSeconds = 0;    // このルール
+	int rewardSeconds = 0;  // 同じ報酬（引き換え以外は同じ種類のイベント）を使うすべてのルール
+	int userSeconds = 0;    // このルールを同じユーザーが
+
+	bool empty() const { return ruleSeconds <= 0 && rewardSeconds <= 0 && userSeconds <= 0; }
+};
+
+// 集計で発火する条件（windowSeconds 秒以内に count 回、または count 人）。揃うまでの通知は実行せず、揃ったら 1 回実行する
+struct RuleCombo {
+	int count = 0;          // 2 以上で有効
+	int windowSeconds = 0;
+	bool distinctUsers = false;  // true: 異なるユーザーの人数で数える
+
+	bool enabled() const { return count > 1 && windowSeconds > 0; }
+};
 
 struct RewardRule {
+	// トリガーになるイベント（Redemption 以外は rewardId を使わず、その種類の通知すべてにマッチする）
+	EventKind trigger = EventKind::Redemption;
 	std::string sourceScene;
 	std::string rewardId;
 	std::string rewardTitle;
 	std::string targetScene;
 	int revertSeconds = 0;
 	bool enabled = true;  // ルールの有効/無効（デフォルトは有効）
+	bool prewarm = false; // 有効中は切替先シーンを事前に表示状態にしておく
+	bool highPriority = false; // 高負荷時も延期せずに実行する
+	int maxEventAgeSeconds = 0; // 発生からこの秒数を過ぎて届いた通知では実行しない（0 なら無制限）
+
+	// この切替だけに使うトランジション（空ならOBSの現在の設定）
+	std::string transitionName;
+	int transitionDurationMs = 0;  // 0 ならトランジションの既定の長さ
+
+	// transitionName を解決したキャッシュのスロット（実行時のみ、保存しない）
+	int transitionSlot = -1;
+
+	RulePredicates predicates;
+	RuleCooldowns cooldowns;
+	RuleCombo combo;
+	// predicates をコンパイルした照合器（実行時のみ、保存しない）
+	std::shared_ptr<const CompiledPredicates> compiledPredicates;
+	// メトリクスの発火回数（実行時のみ、保存しない）。実際に実行したときだけ数える
+	std::shared_ptr<metrics::Counter> firedCounter;
+
+	// シーン切替以外の追加アクション（アイテム表示・フィルタ・メディア）
+	std::vector<RuleAction> actions;
 };
+
+// ルールが行うシーン切替の数（targetScene と SwitchScene アクション）。切替は 1 ルールにつき 1 つまで
+inline size_t sceneSwitchCount(const RewardRule &rule)
+{
+	size_t count = rule.targetScene.empty() ? 0 : 1;
+	for (const auto &action : rule.actions) {
+		if (std::holds_alternative<SwitchSceneAction>(action))
+			++count;
+	}
+	return count;
+}
+
+// ログ・統計用のルール識別ラベル（"reward_id -> target"、引き換え以外は "cheer -> target" など）
+inline std::string ruleLabel(const RewardRule &rule)
+{
+	const std::string trigger =
+		rule.trigger == EventKind::Redemption ? rule.rewardId : eventTypeInfo(rule.trigger).name;
+	return trigger + " -> " + (rule.targetScene.empty() ? std::string("(actions)") : rule.targetScene);
+}
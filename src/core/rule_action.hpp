@@ -0,0 +1,55 @@
+// obs-scene-switcher plugin
+// Copyright (C) 2025 ksmksks
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+#include <string>
+#include <variant>
+
+// シーン切替（State Machine を経由し、抑制の対象になる）
+struct SwitchSceneAction {
+	std::string scene;
+	int revertSeconds = 0;
+};
+
+// シーンアイテムの表示/非表示
+struct SceneItemVisibilityAction {
+	std::string scene;
+	std::string source;
+	bool visible = true;
+	int revertSeconds = 0;  // 経過後に元の表示状態へ戻す
+};
+
+// フィルタの有効/無効
+struct FilterToggleAction {
+	std::string source;
+	std::string filter;
+	bool enabled = true;
+	int revertSeconds = 0;  // 経過後に元の有効状態へ戻す
+};
+
+// メディアソースを先頭から再生
+struct MediaRestartAction {
+	std::string source;
+	int revertSeconds = 0;  // 経過後に再生を停止する
+};
+
+// ルールに紐づくアクション（仮想関数ではなく std::visit で振り分ける）
+using RuleAction = std::variant<SwitchSceneAction, SceneItemVisibilityAction, FilterToggleAction, MediaRestartAction>;
+
+// 設定ファイル上のアクション種別名
+inline const char *actionTypeName(const RuleAction &action)
+{
+	switch (action.index()) {
+	case 0:
+		return "switch_scene";
+	case 1:
+		return "scene_item_visibility";
+	case 2:
+		return "filter_toggle";
+	case 3:
+		return "media_restart";
+	default:
+		return "";
+	}
+}
@@ -0,0 +1,94 @@
+// obs-scene-switcher plugin
+// Copyright (C) 2025 ksmksks
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "rule_engine.hpp"
+#include "core/metrics.hpp"
+#include "core/rule_predicates.hpp"
+#include "core/log.hpp"
+#include "core/trace.hpp"
+
+#include <atomic>
+#include <chrono>
+
+// 引き換え以外は報酬 ID を持たない
+static const std::string &eventRewardId(const TwitchEvent &event)
+{
+	static const std::string none;
+	const auto *redemption = std::get_if<RedemptionEvent>(&event);
+	return redemption ? redemption->rewardId : none;
+}
+
+// 照合できなかった引き換えの警告（同じ報酬を連打されてもログを埋めないよう、1 秒に 1 回まで）
+static void warnUnmatchedRedemption(const std::string &rewardId, size_t ruleCount)
+{
+	static std::atomic<int64_t> lastWarnMs{-1000000};
+	static std::atomic<uint32_t> suppressed{0};
+
+	const int64_t nowMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+				      std::chrono::steady_clock::now().time_since_epoch())
+				      .count();
+	int64_t last = lastWarnMs.load(std::memory_order_relaxed);
+	if (nowMs - last < 1000 || !lastWarnMs.compare_exchange_strong(last, nowMs, std::memory_order_relaxed)) {
+		suppressed.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+
+	const uint32_t skipped = suppressed.exchange(0, std::memory_order_relaxed);
+	if (skipped > 0)
+		corelog::write(corelog::Warning,
+			       "[obs-scene-switcher] No enabled rule found for reward_id=%s (total rules: %zu, "
+			       "%u similar warnings suppressed)",
+			       rewardId.c_str(), ruleCount, skipped);
+	else
+		corelog::write(corelog::Warning,
+			       "[obs-scene-switcher] No enabled rule found for reward_id=%s (total rules: %zu)",
+			       rewardId.c_str(), ruleCount);
+}
+
+const RewardRule *matchRule(const std::vector<RewardRule> &rules, const TwitchEvent &event,
+			    const std::string &currentScene)
+{
+	auto &registry = metrics::Registry::instance();
+	const EventKind kind = eventKind(event);
+	const std::string &rewardId = eventRewardId(event);
+	const EventFacts facts = eventFacts(event);
+
+	for (size_t i = 0; i < rules.size(); ++i) {
+		const auto &rule = rules[i];
+		if (rule.trigger != kind || (kind == EventKind::Redemption && rule.rewardId != rewardId))
+			continue;
+
+		// ルールが無効の場合は次のルールへ
+		if (!rule.enabled) {
+			SS_TRACE_DEBUG(trace::Event::RuleSkippedDisabled, static_cast<int64_t>(i));
+			continue;
+		}
+
+		// ソースシーンのチェック
+		// 空文字列または "Any" の場合は任意のシーンにマッチ
+		const bool sourceMatches = rule.sourceScene.empty() || rule.sourceScene == "Any" ||
+					   rule.sourceScene == currentScene;
+		if (!sourceMatches) {
+			SS_TRACE_DEBUG(trace::Event::RuleSkippedScene, static_cast<int64_t>(i));
+			continue;
+		}
+
+		// 発火条件（入力・ユーザー・Bits）。合わなければ下のルールを探す
+		if (!predicatesMatch(rule, facts)) {
+			SS_TRACE_DEBUG(trace::Event::RuleSkippedPredicate, static_cast<int64_t>(i));
+			continue;
+		}
+
+		SS_TRACE_INFO(trace::Event::RuleMatched, static_cast<int64_t>(i), rule.revertSeconds, 0, rule.targetScene);
+		registry.redemptionsMatched.inc();
+		return &rule;
+	}
+
+	SS_TRACE_INFO(trace::Event::RuleNotFound, static_cast<int64_t>(rules.size()), static_cast<int64_t>(kind), 0,
+		      rewardId);
+	registry.redemptionsUnmatched.inc();
+	if (kind == EventKind::Redemption)
+		warnUnmatchedRedemption(rewardId, rules.size());
+	return nullptr;
+}
@@ -0,0 +1,19 @@
+// obs-scene-switcher plugin
+// Copyright (C) 2025 ksmksks
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+#include "core/reward_rule.hpp"
+#include <string>
+#include <vector>
+
+/**
+ * 通知（引き換え・Bits・サブスク・レイド・フォロー）に対するルール照合
+ *
+ * - 上から順に検索し、最初の有効なマッチを返す（なければ nullptr）
+ * - 引き換えは報酬 ID、それ以外はイベントの種類が一致するルールを対象にする
+ * - 発火条件は compileRulePredicates() 済みの照合器で判定する
+ * - 照合結果はトレース・メトリクスに記録する（どのルールにも合わない引き換えは警告ログも出す。1 秒に 1 回まで）
+ */
+const RewardRule *matchRule(const std::vector<RewardRule> &rules, const TwitchEvent &event,
+			    const std::string &currentScene);
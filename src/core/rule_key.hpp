@@ -0,0 +1,60 @@
+// obs-scene-switcher plugin
+// Copyright (C) 2025 ksmksks
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+#include "core/reward_rule.hpp"
+#include <cstdint>
+#include <string_view>
+#include <type_traits>
+
+/**
+ * 実行時の表（クールダウン・コンボ）のキー
+ *
+ * - 文字列を組み立てずに FNV-1a 64 ビットでハッシュする
+ * - 文字列ごとに区切りを入れて "ab"+"c" と "a"+"bc" を分ける
+ */
+class KeyHash {
+public:
+	explicit KeyHash(uint8_t tag) { add(tag); }
+
+	KeyHash &add(std::string_view text)
+	{
+		for (char c : text)
+			add(static_cast<uint8_t>(c));
+		add(0xff);
+		return *this;
+	}
+
+	KeyHash &add(uint8_t byte)
+	{
+		hash_ ^= byte;
+		hash_ *= 1099511628211ull;
+		return *this;
+	}
+
+	// ルールの識別（保存し直しても同じルールは同じキーになるよう、並び順ではなく内容で決める）
+	KeyHash &addRule(const RewardRule &rule)
+	{
+		return add(static_cast<uint8_t>(rule.trigger)).add(rule.rewardId).add(rule.sourceScene).add(rule.targetScene);
+	}
+
+	uint64_t value() const { return hash_; }
+
+private:
+	uint64_t hash_ = 14695981039346656037ull;
+};
+
+// 通知したユーザーの ID（レイドは元の配信者。匿名なら空）
+inline std::string_view eventUserId(const TwitchEvent &event)
+{
+	return std::visit(
+		[](const auto &e) -> std::string_view {
+			using T = std::decay_t<decltype(e)>;
+			if constexpr (std::is_same_v<T, RaidEvent>)
+				return e.fromUserId;
+			else
+				return e.userId;
+		},
+		event);
+}
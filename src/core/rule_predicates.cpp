@@ -0,0 +1,202 @@
+// obs-scene-switcher plugin
+// Copyright (C) 2025 ksmksks
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "rule_predicates.hpp"
+#include "core/log.hpp"
+
+#include <algorithm>
+#include <type_traits>
+
+namespace {
+
+// ASCII のみ小文字化する（ロケールに依存させない。マルチバイト文字はそのまま比較する）
+char lowerAscii(char c)
+{
+	return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+std::string lowered(std::string_view text)
+{
+	std::string out(text);
+	std::transform(out.begin(), out.end(), out.begin(), lowerAscii);
+	return out;
+}
+
+std::string_view trimmed(std::string_view text)
+{
+	const auto first = text.find_first_not_of(" \t\r\n");
+	if (first == std::string_view::npos)
+		return {};
+	const auto last = text.find_last_not_of(" \t\r\n");
+	return text.substr(first, last - first + 1);
+}
+
+// 大文字小文字を区別しない比較（needle は小文字化済み）
+bool containsFolded(std::string_view haystack, std::string_view needle)
+{
+	if (needle.size() > haystack.size())
+		return false;
+	return std::search(haystack.begin(), haystack.end(), needle.begin(), needle.end(),
+			   [](char a, char b) { return lowerAscii(a) == b; }) != haystack.end();
+}
+
+int compareFolded(std::string_view a, std::string_view lowerB)
+{
+	const size_t n = std::min(a.size(), lowerB.size());
+	for (size_t i = 0; i < n; ++i) {
+		const auto ca = static_cast<unsigned char>(lowerAscii(a[i]));
+		const auto cb = static_cast<unsigned char>(lowerB[i]);
+		if (ca != cb)
+			return ca < cb ? -1 : 1;
+	}
+	return a.size() == lowerB.size() ? 0 : (a.size() < lowerB.size() ? -1 : 1);
+}
+
+std::vector<std::string> sortedUsers(const std::vector<std::string> &users)
+{
+	std::vector<std::string> out;
+	out.reserve(users.size());
+	for (const auto &user : users) {
+		// "@name" と書かれていても受け付ける
+		auto name = trimmed(user);
+		if (!name.empty() && name.front() == '@')
+			name.remove_prefix(1);
+		if (!name.empty())
+			out.push_back(lowered(name));
+	}
+	std::sort(out.begin(), out.end());
+	out.erase(std::unique(out.begin(), out.end()), out.end());
+	return out;
+}
+
+} // namespace
+
+EventFacts eventFacts(const TwitchEvent &event)
+{
+	return std::visit(
+		[](const auto &e) {
+			using T = std::decay_t<decltype(e)>;
+			EventFacts facts;
+			if constexpr (std::is_same_v<T, RedemptionEvent>) {
+				facts.input = e.userInput;
+				facts.userLogin = e.userLogin;
+				facts.userName = e.userName;
+			} else if constexpr (std::is_same_v<T, CheerEvent>) {
+				facts.input = e.message;
+				facts.userLogin = e.userLogin;
+				facts.userName = e.userName;
+				facts.bits = e.bits;
+			} else if constexpr (std::is_same_v<T, RaidEvent>) {
+				facts.userLogin = e.fromUserLogin;
+				facts.userName = e.fromUserName;
+			} else {
+				facts.userLogin = e.userLogin;
+				facts.userName = e.userName;
+			}
+			return facts;
+		},
+		event);
+}
+
+std::shared_ptr<const CompiledPredicates> CompiledPredicates::compile(const RulePredicates &predicates,
+								      EventKind trigger, std::string &error)
+{
+	auto compiled = std::make_shared<CompiledPredicates>();
+
+	if (predicates.inputRegex && !predicates.inputPattern.empty()) {
+		try {
+			compiled->regex_.emplace(predicates.inputPattern, std::regex::ECMAScript | std::regex::icase |
+										  std::regex::optimize);
+		} catch (const std::regex_error &e) {
+			error = e.what();
+			compiled->invalid_ = true;
+		}
+	} else {
+		std::string_view rest = predicates.inputPattern;
+		while (!rest.empty()) {
+			const auto comma = rest.find(',');
+			const auto keyword = trimmed(rest.substr(0, comma));
+			if (!keyword.empty())
+				compiled->keywords_.push_back(lowered(keyword));
+			rest = comma == std::string_view::npos ? std::string_view() : rest.substr(comma + 1);
+		}
+	}
+
+	compiled->allowUsers_ = sortedUsers(predicates.allowUsers);
+	compiled->denyUsers_ = sortedUsers(predicates.denyUsers);
+	// Bits の下限は Bits ルールにだけ意味がある
+	compiled->minBits_ = trigger == EventKind::Cheer ? predicates.minBits : 0;
+
+	return compiled;
+}
+
+bool CompiledPredicates::inputMatches(std::string_view input) const
+{
+	if (regex_) {
+		// 視聴者の入力に対して照合するため、実装によっては error_complexity / error_stack を投げうる
+		try {
+			return std::regex_search(input.begin(), input.end(), *regex_);
+		} catch (const std::regex_error &e) {
+			if (!regexErrorLogged_.exchange(true))
+				corelog::write(corelog::Warning,
+					       "[obs-scene-switcher] Input regex failed while matching (%s); treated as no match",
+					       e.what());
+			return false;
+		}
+	}
+	if (keywords_.empty())
+		return true;
+	for (const auto &keyword : keywords_) {
+		if (containsFolded(input, keyword))
+			return true;
+	}
+	return false;
+}
+
+bool CompiledPredicates::listContains(const std::vector<std::string> &sorted, const EventFacts &facts)
+{
+	const auto contains = [&sorted](std::string_view name) {
+		if (name.empty())
+			return false;
+		const auto it = std::lower_bound(sorted.begin(), sorted.end(), name,
+						 [](const std::string &entry, std::string_view key) {
+							 return compareFolded(key, entry) > 0;
+						 });
+		return it != sorted.end() && compareFolded(name, *it) == 0;
+	};
+	return contains(facts.userLogin) || contains(facts.userName);
+}
+
+bool CompiledPredicates::matches(const EventFacts &facts) const
+{
+	if (invalid_)
+		return false;
+	if (facts.bits < minBits_)
+		return false;
+	// 匿名（ユーザー名なし）は許可リストに入りようがない
+	if (!allowUsers_.empty() && !listContains(allowUsers_, facts))
+		return false;
+	if (!denyUsers_.empty() && listContains(denyUsers_, facts))
+		return false;
+	return inputMatches(facts.input);
+}
+
+void compileRulePredicates(std::vector<RewardRule> &rules)
+{
+	for (size_t i = 0; i < rules.size(); ++i) {
+		auto &rule = rules[i];
+		if (rule.predicates.empty()) {
+			rule.compiledPredicates.reset();
+			continue;
+		}
+
+		std::string error;
+		rule.compiledPredicates = CompiledPredicates::compile(rule.predicates, rule.trigger, error);
+		if (!error.empty()) {
+			corelog::write(corelog::Warning,
+				       "[obs-scene-switcher] Rule %zu (%s): invalid input pattern '%s', rule will not fire: %s",
+				       i, ruleLabel(rule).c_str(), rule.predicates.inputPattern.c_str(), error.c_str());
+		}
+	}
+}
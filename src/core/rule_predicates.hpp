@@ -0,0 +1,63 @@
+// obs-scene-switcher plugin
+// Copyright (C) 2025 ksmksks
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+#include "core/reward_rule.hpp"
+#include <atomic>
+#include <optional>
+#include <regex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// 条件の判定に使う通知の値（通知の文字列を参照するだけでコピーしない）
+struct EventFacts {
+	std::string_view input;  // 引き換えのテキスト・Bits のメッセージ
+	std::string_view userLogin;
+	std::string_view userName;
+	int bits = 0;
+};
+
+EventFacts eventFacts(const TwitchEvent &event);
+
+/**
+ * ルールの発火条件を照合用に変換したもの
+ *
+ * - 正規表現の構築・キーワードの小文字化・ユーザー一覧の整列はコンパイル時に済ませる
+ * - キーワード・ユーザー一覧の照合は文字列を確保しない（ASCII の大文字小文字は区別しない）。
+ *   正規表現の照合は std::regex が内部で状態を確保する
+ * - 正規表現が照合中に例外（複雑すぎる入力など）を投げたらマッチしなかったものとする（ログは 1 度だけ）
+ * - 照合結果に関わる状態は不変なのでスレッド間で共有してよい
+ */
+class CompiledPredicates {
+public:
+	// 正規表現が不正なら error に理由を入れ、どの通知にもマッチしない照合器を返す
+	static std::shared_ptr<const CompiledPredicates> compile(const RulePredicates &predicates, EventKind trigger,
+								 std::string &error);
+
+	bool matches(const EventFacts &facts) const;
+
+private:
+	bool inputMatches(std::string_view input) const;
+	static bool listContains(const std::vector<std::string> &sorted, const EventFacts &facts);
+
+	bool invalid_ = false;
+	std::optional<std::regex> regex_;
+	mutable std::atomic<bool> regexErrorLogged_{false};
+	std::vector<std::string> keywords_;    // 小文字化済み
+	std::vector<std::string> allowUsers_;  // 小文字化・整列済み
+	std::vector<std::string> denyUsers_;
+	int minBits_ = 0;
+};
+
+// 各ルールの compiledPredicates を作り直す（ルールの保存・読み込み時）
+void compileRulePredicates(std::vector<RewardRule> &rules);
+
+// 条件がなければ true。条件があるのにコンパイルされていなければ false（発火させない側に倒す）
+inline bool predicatesMatch(const RewardRule &rule, const EventFacts &facts)
+{
+	if (rule.predicates.empty())
+		return true;
+	return rule.compiledPredicates && rule.compiledPredicates->matches(facts);
+}
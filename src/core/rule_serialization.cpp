@@ -0,0 +1,182 @@
+// obs-scene-switcher plugin
+// Copyright (C) 2025 ksmksks
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "rule_serialization.hpp"
+
+#include <nlohmann/json.hpp>
+#include <type_traits>
+
+using json = nlohmann::json;
+
+static json actionToJson(const RuleAction &action)
+{
+	json j{{"type", actionTypeName(action)}};
+
+	std::visit(
+		[&j](const auto &a) {
+			using T = std::decay_t<decltype(a)>;
+			if constexpr (std::is_same_v<T, SwitchSceneAction>) {
+				j["scene"] = a.scene;
+			} else if constexpr (std::is_same_v<T, SceneItemVisibilityAction>) {
+				j["scene"] = a.scene;
+				j["source"] = a.source;
+				j["visible"] = a.visible;
+			} else if constexpr (std::is_same_v<T, FilterToggleAction>) {
+				j["source"] = a.source;
+				j["filter"] = a.filter;
+				j["enabled"] = a.enabled;
+			} else if constexpr (std::is_same_v<T, MediaRestartAction>) {
+				j["source"] = a.source;
+			}
+			j["revert_seconds"] = a.revertSeconds;
+		},
+		action);
+
+	return j;
+}
+
+static bool actionFromJson(const json &j, RuleAction &out)
+{
+	const std::string type = j.value("type", "");
+	const int revertSeconds = j.value("revert_seconds", 0);
+
+	if (type == "switch_scene") {
+		out = SwitchSceneAction{j.value("scene", ""), revertSeconds};
+	} else if (type == "scene_item_visibility") {
+		out = SceneItemVisibilityAction{j.value("scene", ""), j.value("source", ""), j.value("visible", true),
+						revertSeconds};
+	} else if (type == "filter_toggle") {
+		out = FilterToggleAction{j.value("source", ""), j.value("filter", ""), j.value("enabled", true),
+					 revertSeconds};
+	} else if (type == "media_restart") {
+		out = MediaRestartAction{j.value("source", ""), revertSeconds};
+	} else {
+		// 未知の種別は読み飛ばす（新しい設定を古い版で開いた場合）
+		return false;
+	}
+
+	return true;
+}
+
+static std::vector<std::string> stringList(const json &object, const char *key)
+{
+	std::vector<std::string> out;
+	auto it = object.find(key);
+	if (it == object.end() || !it->is_array())
+		return out;
+	for (const auto &item : *it) {
+		if (item.is_string())
+			out.push_back(item.get<std::string>());
+	}
+	return out;
+}
+
+std::string ruleToJson(const RewardRule &r)
+{
+	json j{
+		{"reward_id", r.rewardId},
+		{"source_scene", r.sourceScene},
+		{"target_scene", r.targetScene},
+		{"revert_seconds", r.revertSeconds},
+		{"enabled", r.enabled},
+		{"prewarm", r.prewarm},
+		{"high_priority", r.highPriority}
+	};
+	if (r.trigger != EventKind::Redemption)
+		j["trigger"] = eventTypeInfo(r.trigger).name;
+	if (r.maxEventAgeSeconds > 0)
+		j["max_event_age_seconds"] = r.maxEventAgeSeconds;
+	if (!r.transitionName.empty()) {
+		j["transition"] = r.transitionName;
+		j["transition_duration_ms"] = r.transitionDurationMs;
+	}
+	if (!r.predicates.empty()) {
+		const auto &p = r.predicates;
+		json predicates = json::object();
+		if (!p.inputPattern.empty()) {
+			predicates["input"] = p.inputPattern;
+			predicates["input_regex"] = p.inputRegex;
+		}
+		if (!p.allowUsers.empty())
+			predicates["allow_users"] = p.allowUsers;
+		if (!p.denyUsers.empty())
+			predicates["deny_users"] = p.denyUsers;
+		if (p.minBits > 0)
+			predicates["min_bits"] = p.minBits;
+		j["predicates"] = predicates;
+	}
+	if (!r.cooldowns.empty()) {
+		j["cooldowns"] = {
+			{"rule", r.cooldowns.ruleSeconds},
+			{"reward", r.cooldowns.rewardSeconds},
+			{"user", r.cooldowns.userSeconds}
+		};
+	}
+	if (r.combo.enabled()) {
+		j["combo"] = {
+			{"count", r.combo.count},
+			{"window_seconds", r.combo.windowSeconds},
+			{"distinct_users", r.combo.distinctUsers}
+		};
+	}
+	if (!r.actions.empty()) {
+		json actions = json::array();
+		for (const auto &action : r.actions)
+			actions.push_back(actionToJson(action));
+		j["actions"] = actions;
+	}
+	return j.dump();
+}
+
+bool ruleFromJson(const std::string &raw, RewardRule &r)
+{
+	auto j = json::parse(raw, nullptr, false);
+	if (j.is_discarded() || !j.is_object())
+		return false;
+
+	r = RewardRule();
+	// 未知のトリガー（新しい設定を古い版で開いた場合）は読み込まない
+	const auto trigger = eventKindFromName(j.value("trigger", "redemption"));
+	if (!trigger)
+		return false;
+	r.trigger = *trigger;
+	r.rewardId = j.value("reward_id", "");
+	r.sourceScene = j.value("source_scene", "");
+	r.targetScene = j.value("target_scene", "");
+	r.revertSeconds = j.value("revert_seconds", 0);
+	r.enabled = j.value("enabled", true);
+	r.prewarm = j.value("prewarm", false);
+	r.highPriority = j.value("high_priority", false);
+	r.maxEventAgeSeconds = j.value("max_event_age_seconds", 0);
+	r.transitionName = j.value("transition", "");
+	r.transitionDurationMs = j.value("transition_duration_ms", 0);
+	if (j.contains("predicates") && j["predicates"].is_object()) {
+		const auto &jp = j["predicates"];
+		r.predicates.inputPattern = jp.value("input", "");
+		r.predicates.inputRegex = jp.value("input_regex", false);
+		r.predicates.allowUsers = stringList(jp, "allow_users");
+		r.predicates.denyUsers = stringList(jp, "deny_users");
+		r.predicates.minBits = jp.value("min_bits", 0);
+	}
+	if (j.contains("cooldowns") && j["cooldowns"].is_object()) {
+		const auto &jc = j["cooldowns"];
+		r.cooldowns.ruleSeconds = jc.value("rule", 0);
+		r.cooldowns.rewardSeconds = jc.value("reward", 0);
+		r.cooldowns.userSeconds = jc.value("user", 0);
+	}
+	if (j.contains("combo") && j["combo"].is_object()) {
+		const auto &jc = j["combo"];
+		r.combo.count = jc.value("count", 0);
+		r.combo.windowSeconds = jc.value("window_seconds", 0);
+		r.combo.distinctUsers = jc.value("distinct_users", false);
+	}
+	if (j.contains("actions") && j["actions"].is_array()) {
+		for (const auto &ja : j["actions"]) {
+			RuleAction action;
+			if (actionFromJson(ja, action))
+				r.actions.push_back(std::move(action));
+		}
+	}
+	return true;
+}
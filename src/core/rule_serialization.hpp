@@ -0,0 +1,17 @@
+// obs-scene-switcher plugin
+// Copyright (C) 2025 ksmksks
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+#include "core/reward_rule.hpp"
+#include <string>
+
+/**
+ * ルールの JSON 表現（設定ファイルの rule= 行）
+ *
+ * - 未知のアクション種別は読み飛ばす（新しい設定を古い版で開いた場合）
+ */
+std::string ruleToJson(const RewardRule &rule);
+
+// JSON として不正なら false（必須項目の検証は呼び出し側で行う）
+bool ruleFromJson(const std::string &raw, RewardRule &out);
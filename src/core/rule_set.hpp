@@ -0,0 +1,45 @@
+// obs-scene-switcher plugin
+// Copyright (C) 2025 ksmksks
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+#include "core/reward_rule.hpp"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/**
+ * 不変スナップショットの公開先（RCU 風）
+ *
+ * - 書き込み側は新しい値を丸ごと作って store() で差し替える（書き込み側は 1 スレッドに限ること）
+ * - 読み取り側は load() で参照を取り、持っている間は古い値も解放されない
+ * - 読み取り側はロックを取らず、差し替え中も照合を止めない
+ */
+template<typename T> class SnapshotCell {
+public:
+	explicit SnapshotCell(std::shared_ptr<const T> initial = std::make_shared<const T>()) : value_(std::move(initial))
+	{
+	}
+
+	SnapshotCell(const SnapshotCell &) = delete;
+	SnapshotCell &operator=(const SnapshotCell &) = delete;
+
+	std::shared_ptr<const T> load() const { return std::atomic_load_explicit(&value_, std::memory_order_acquire); }
+
+	void store(std::shared_ptr<const T> next)
+	{
+		std::atomic_store_explicit(&value_, std::move(next), std::memory_order_release);
+	}
+
+private:
+	std::shared_ptr<const T> value_;
+};
+
+// 照合に使うルール一覧（トランジション・発火条件を解決済み。公開後は変更しない）
+struct CompiledRuleSet {
+	std::vector<RewardRule> rules;
+	uint64_t version = 0;  // 公開ごとに増える（ログ用）
+};
+
+using RuleSetPtr = std::shared_ptr<const CompiledRuleSet>;
@@ -0,0 +1,133 @@
+// obs-scene-switcher plugin
+// Copyright (C) 2025 ksmksks
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "server_clock.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+namespace {
+
+// 固定桁の数字（桁数が足りなければ false）
+bool readDigits(std::string_view text, size_t pos, size_t digits, int &out)
+{
+	if (pos + digits > text.size())
+		return false;
+
+	int value = 0;
+	for (size_t i = pos; i < pos + digits; ++i) {
+		if (text[i] < '0' || text[i] > '9')
+			return false;
+		value = value * 10 + (text[i] - '0');
+	}
+	out = value;
+	return true;
+}
+
+// 1970-01-01 からの日数（proleptic グレゴリオ暦）
+int64_t daysFromCivil(int y, int m, int d)
+{
+	y -= m <= 2;
+	const int64_t era = (y >= 0 ? y : y - 399) / 400;
+	const int64_t yoe = y - era * 400;
+	const int64_t doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+	const int64_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+	return era * 146097 + doe - 719468;
+}
+
+} // namespace
+
+std::optional<int64_t> parseRfc3339Micros(std::string_view text)
+{
+	// YYYY-MM-DDTHH:MM:SS[.fraction](Z|±HH:MM)
+	int year, month, day, hour, minute, second;
+	if (!readDigits(text, 0, 4, year) || text.size() < 19 || text[4] != '-' || !readDigits(text, 5, 2, month) ||
+	    text[7] != '-' || !readDigits(text, 8, 2, day) || (text[10] != 'T' && text[10] != 't') ||
+	    !readDigits(text, 11, 2, hour) || text[13] != ':' || !readDigits(text, 14, 2, minute) || text[16] != ':' ||
+	    !readDigits(text, 17, 2, second))
+		return std::nullopt;
+
+	if (month < 1 || month > 12 || day < 1 || day > 31 || hour > 23 || minute > 59 || second > 60)
+		return std::nullopt;
+
+	// 小数部はマイクロ秒まで使う（Twitch はナノ秒まで送ってくる）
+	size_t pos = 19;
+	int64_t micros = 0;
+	if (pos < text.size() && text[pos] == '.') {
+		++pos;
+		int digits = 0;
+		while (pos < text.size() && text[pos] >= '0' && text[pos] <= '9') {
+			if (digits < 6) {
+				micros = micros * 10 + (text[pos] - '0');
+				++digits;
+			}
+			++pos;
+		}
+		if (digits == 0)
+			return std::nullopt;
+		for (; digits < 6; ++digits)
+			micros *= 10;
+	}
+
+	int64_t offsetSeconds = 0;
+	if (pos < text.size() && (text[pos] == 'Z' || text[pos] == 'z')) {
+		++pos;
+	} else if (pos < text.size() && (text[pos] == '+' || text[pos] == '-')) {
+		int offsetHour, offsetMinute;
+		if (!readDigits(text, pos + 1, 2, offsetHour) || pos + 3 >= text.size() || text[pos + 3] != ':' ||
+		    !readDigits(text, pos + 4, 2, offsetMinute))
+			return std::nullopt;
+		offsetSeconds = (offsetHour * 60 + offsetMinute) * 60;
+		if (text[pos] == '-')
+			offsetSeconds = -offsetSeconds;
+		pos += 6;
+	} else {
+		return std::nullopt;
+	}
+
+	if (pos != text.size())
+		return std::nullopt;
+
+	const int64_t seconds =
+		daysFromCivil(year, month, day) * 86400 + hour * 3600 + minute * 60 + second - offsetSeconds;
+	return seconds * 1000000 + micros;
+}
+
+int64_t systemNowMicros()
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(
+		       std::chrono::system_clock::now().time_since_epoch())
+		.count();
+}
+
+void ServerClock::observe(int64_t serverMicros, int64_t localMicros)
+{
+	samples_[next_] = localMicros - serverMicros;
+	next_ = (next_ + 1) % kSamples;
+	if (count_ < kSamples)
+		++count_;
+}
+
+void ServerClock::reset()
+{
+	next_ = 0;
+	count_ = 0;
+}
+
+std::optional<int64_t> ServerClock::offsetMicros() const
+{
+	if (count_ == 0)
+		return std::nullopt;
+	return *std::min_element(samples_.begin(), samples_.begin() + count_);
+}
+
+std::optional<int64_t> ServerClock::ageMicros(int64_t originMicros, int64_t localMicros) const
+{
+	const auto offset = offsetMicros();
+	if (!offset)
+		return std::nullopt;
+
+	// 最小値の標本より速く届いた通知は経過 0 とする
+	return std::max<int64_t>(0, localMicros - *offset - originMicros);
+}
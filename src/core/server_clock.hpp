@@ -0,0 +1,43 @@
+// obs-scene-switcher plugin
+// Copyright (C) 2025 ksmksks
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+// RFC 3339 の UTC 時刻（"2023-07-19T10:11:12.634234626Z"）→ Unix 時刻のマイクロ秒（不正なら nullopt）
+std::optional<int64_t> parseRfc3339Micros(std::string_view text);
+
+// ローカルの現在時刻（Unix 時刻のマイクロ秒）
+int64_t systemNowMicros();
+
+/**
+ * Twitch サーバーとローカル時計のずれの推定
+ *
+ * - session_welcome / session_keepalive の message_timestamp と受信時刻の差を直近 kSamples 件だけ持つ
+ * - 差の最小値をずれとみなす（ネットワーク遅延は常に正なので、最も速く届いたものが真のずれに近い）
+ * - 通知の経過時間は「最も速い経路で届いた場合より何秒遅れたか」になる（時計のずれを含まない）
+ * - スレッドセーフではない（WebSocket のスレッドからのみ使う）
+ */
+class ServerClock {
+public:
+	static constexpr size_t kSamples = 16;
+
+	void observe(int64_t serverMicros, int64_t localMicros);
+	void reset();
+
+	// 推定したずれ（ローカル − サーバー）。まだ標本がなければ nullopt
+	std::optional<int64_t> offsetMicros() const;
+
+	// サーバー時刻 originMicros に発生した通知の、localMicros 時点での経過時間（推定できなければ nullopt）
+	std::optional<int64_t> ageMicros(int64_t originMicros, int64_t localMicros) const;
+
+private:
+	std::array<int64_t, kSamples> samples_{};
+	size_t next_ = 0;
+	size_t count_ = 0;
+};
@@ -0,0 +1,201 @@
+// obs-scene-switcher plugin
+// Copyright (C) 2025 ksmksks
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "startup_profiler.hpp"
+#include "executor.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <thread>
+#include <unordered_map>
+
+namespace startup {
+
+namespace {
+
+int64_t toUs(Clock::duration d)
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(d).count();
+}
+
+// std::thread::id をログで読める小さな番号に変換する（初出順に 0, 1, 2, ...）
+size_t shortThreadId()
+{
+	static std::mutex mutex;
+	static std::unordered_map<std::thread::id, size_t> ids;
+
+	std::lock_guard<std::mutex> lock(mutex);
+	auto it = ids.find(std::this_thread::get_id());
+	if (it != ids.end())
+		return it->second;
+	const size_t id = ids.size();
+	ids.emplace(std::this_thread::get_id(), id);
+	return id;
+}
+
+} // namespace
+
+Profiler &Profiler::instance()
+{
+	static Profiler inst;
+	return inst;
+}
+
+Profiler::Profiler() : origin_(Clock::now()) {}
+
+void Profiler::reset()
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	origin_ = Clock::now();
+	blockingUs_ = -1;
+	phases_.clear();
+}
+
+void Profiler::record(const std::string &name, Clock::time_point start, Clock::time_point end, bool blocking)
+{
+	const size_t thread = shortThreadId();
+
+	std::lock_guard<std::mutex> lock(mutex_);
+	Phase p;
+	p.name = name;
+	p.startUs = toUs(start - origin_);
+	p.durationUs = toUs(end - start);
+	p.thread = thread;
+	p.blocking = blocking;
+	phases_.push_back(std::move(p));
+}
+
+void Profiler::markBlockingDone()
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	blockingUs_ = toUs(Clock::now() - origin_);
+}
+
+int64_t Profiler::blockingUs() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return blockingUs_;
+}
+
+std::vector<Phase> Profiler::phases() const
+{
+	std::vector<Phase> out;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		out = phases_;
+	}
+	std::stable_sort(out.begin(), out.end(),
+			 [](const Phase &a, const Phase &b) { return a.startUs < b.startUs; });
+	return out;
+}
+
+std::string Profiler::summary() const
+{
+	std::string out;
+	char line[160];
+
+	for (const auto &p : phases()) {
+		std::snprintf(line, sizeof(line), "  %-20s %9.2f ms  (+%.2f ms, thread %zu%s)\n", p.name.c_str(),
+			      p.durationUs / 1000.0, p.startUs / 1000.0, p.thread, p.blocking ? ", blocking" : "");
+		out += line;
+	}
+
+	const int64_t blocking = blockingUs();
+	if (blocking >= 0) {
+		std::snprintf(line, sizeof(line), "  %-20s %9.2f ms\n", "blocking total", blocking / 1000.0);
+		out += line;
+	}
+	return out;
+}
+
+TaskGraph::TaskId TaskGraph::add(std::string name, Affinity affinity, std::function<void()> fn,
+				 std::vector<TaskId> deps)
+{
+	const TaskId id = tasks_.size();
+
+	Task task;
+	task.name = std::move(name);
+	task.affinity = affinity;
+	task.fn = std::move(fn);
+	task.pendingDeps = deps.size();
+	tasks_.push_back(std::move(task));
+
+	// 依存先は add 済みのタスクに限る（循環は作れない）
+	for (TaskId dep : deps)
+		tasks_.at(dep).dependents.push_back(id);
+
+	return id;
+}
+
+void TaskGraph::run(Executor &pool)
+{
+	std::mutex mutex;
+	std::condition_variable cv;
+	std::deque<TaskId> callerReady;
+	size_t remaining = tasks_.size();
+
+	std::function<void(TaskId)> schedule;
+
+	// タスク完了時に依存元の残り依存数を減らし、実行可能になったものをスケジュールする
+	auto complete = [&](TaskId id) {
+		std::vector<TaskId> ready;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			for (TaskId next : tasks_[id].dependents) {
+				if (--tasks_[next].pendingDeps == 0)
+					ready.push_back(next);
+			}
+		}
+		for (TaskId next : ready)
+			schedule(next);
+
+		// remaining が 0 になると run() はローカル変数ごと戻るため、通知はロック中に行う
+		std::lock_guard<std::mutex> lock(mutex);
+		--remaining;
+		cv.notify_all();
+	};
+
+	auto execute = [&](TaskId id) {
+		{
+			Profiler::Scope phase(tasks_[id].name, true);
+			tasks_[id].fn();
+		}
+		complete(id);
+	};
+
+	schedule = [&](TaskId id) {
+		if (tasks_[id].affinity == Affinity::Pool && pool.post([&execute, id]() { execute(id); }))
+			return;
+
+		std::lock_guard<std::mutex> lock(mutex);
+		callerReady.push_back(id);
+		cv.notify_all();
+	};
+
+	// 先に根を確定させる（スケジュール後は Pool タスクが pendingDeps を書き換えるため）
+	std::vector<TaskId> roots;
+	for (TaskId id = 0; id < tasks_.size(); ++id) {
+		if (tasks_[id].pendingDeps == 0)
+			roots.push_back(id);
+	}
+	for (TaskId id : roots)
+		schedule(id);
+
+	while (true) {
+		TaskId id;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			cv.wait(lock, [&]() { return remaining == 0 || !callerReady.empty(); });
+			if (callerReady.empty())
+				break;
+			id = callerReady.front();
+			callerReady.pop_front();
+		}
+		execute(id);
+	}
+}
+
+} // namespace startup
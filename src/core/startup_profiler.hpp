@@ -0,0 +1,112 @@
+// obs-scene-switcher plugin
+// Copyright (C) 2025 ksmksks
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class Executor;
+
+namespace startup {
+
+using Clock = std::chrono::steady_clock;
+
+// 起動フェーズ 1 件分の計測結果（時刻は reset() からの相対値）
+struct Phase {
+	std::string name;
+	int64_t startUs = 0;
+	int64_t durationUs = 0;
+	size_t thread = 0;     // 実行スレッド（ログ表示用の短い ID）
+	bool blocking = false; // OBS の起動をブロックしたか
+};
+
+/**
+ * 起動フェーズのプロファイラ
+ *
+ * - record() / Scope は任意のスレッドから呼べる
+ * - markBlockingDone() で obs_module_load から戻った時点を記録する
+ * - バックグラウンドのフェーズは markBlockingDone() 後も記録できる
+ */
+class Profiler {
+public:
+	static Profiler &instance();
+
+	void reset();
+	void record(const std::string &name, Clock::time_point start, Clock::time_point end, bool blocking);
+
+	// スコープの経過時間を 1 フェーズとして記録する
+	class Scope {
+	public:
+		Scope(std::string name, bool blocking)
+			: name_(std::move(name)),
+			  blocking_(blocking),
+			  start_(Clock::now())
+		{
+		}
+		~Scope() { Profiler::instance().record(name_, start_, Clock::now(), blocking_); }
+
+		Scope(const Scope &) = delete;
+		Scope &operator=(const Scope &) = delete;
+
+	private:
+		std::string name_;
+		bool blocking_;
+		Clock::time_point start_;
+	};
+
+	void markBlockingDone();
+
+	// OBS 起動をブロックした時間（markBlockingDone() 前は -1）
+	int64_t blockingUs() const;
+
+	std::vector<Phase> phases() const;
+
+	// 1 行 1 フェーズの一覧（開始時刻順）
+	std::string summary() const;
+
+private:
+	Profiler();
+
+	mutable std::mutex mutex_;
+	Clock::time_point origin_;
+	int64_t blockingUs_ = -1;
+	std::vector<Phase> phases_;
+};
+
+/**
+ * 起動時のタスクグラフ
+ *
+ * - 依存関係のないタスクは Executor 上で並行に実行する
+ * - Caller タスクは run() を呼んだスレッド（OBS の UI スレッド）で実行する（Qt / OBS frontend API 用）
+ * - run() は全タスクの完了まで戻らない。各タスクは blocking フェーズとして Profiler に記録する
+ */
+class TaskGraph {
+public:
+	using TaskId = size_t;
+
+	enum class Affinity { Caller, Pool };
+
+	TaskId add(std::string name, Affinity affinity, std::function<void()> fn, std::vector<TaskId> deps = {});
+
+	// Executor が停止済みなら Pool タスクも呼び出しスレッドで実行する
+	void run(Executor &pool);
+
+private:
+	struct Task {
+		std::string name;
+		Affinity affinity;
+		std::function<void()> fn;
+		std::vector<TaskId> dependents;
+		size_t pendingDeps = 0;
+	};
+
+	std::vector<Task> tasks_;
+};
+
+} // namespace startup
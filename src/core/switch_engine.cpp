@@ -0,0 +1,421 @@
+// obs-scene-switcher plugin
+// Copyright (C) 2025 ksmksks
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "switch_engine.hpp"
+#include "core/log.hpp"
+#include "core/metrics.hpp"
+#include "core/trace.hpp"
+
+// 遷移時間に加えて着地確認を待つ猶予
+static constexpr int kConfirmGraceMs = 1500;
+// 着地しなかった切替の最大試行回数（初回を含む）
+static constexpr int kMaxSwitchAttempts = 2;
+// 抑制状態を UI に表示しておく時間
+static constexpr int kSuppressedDisplayMs = 1000;
+
+SwitchEngine::SwitchEngine(FrontendPort &frontend) : frontend_(frontend) {}
+
+SwitchEngine::~SwitchEngine()
+{
+	clearPendingSwitch();
+	frontend_.restoreTransitionOverride();
+}
+
+void SwitchEngine::setState(State state, int remainingSeconds, const std::string &targetScene,
+			    const std::string &originalScene)
+{
+	if (stateCallback_)
+		stateCallback_(state, remainingSeconds, targetScene, originalScene);
+}
+
+void SwitchEngine::switchScene(const std::string &sceneName, const std::string &label)
+{
+	SS_TRACE_DEBUG(trace::Event::SwitchRequested, 0, 0, 0, sceneName);
+
+	// すでにオンエア中のシーンならイベントは発生しないため確認不要
+	const bool needsConfirmation = frontend_.currentScene() != sceneName;
+	if (needsConfirmation)
+		beginConfirmation(sceneName, label.empty() ? sceneName : label);
+
+	if (!frontend_.setCurrentScene(sceneName)) {
+		if (needsConfirmation)
+			clearPendingSwitch();
+		corelog::write(corelog::Warning, "[obs-scene-switcher] Scene not found: %s", sceneName.c_str());
+	}
+}
+
+void SwitchEngine::switchWithRevert(const RewardRule &rule)
+{
+	const bool hasRevert = rule.revertSeconds > 0;
+
+	switch (state_) {
+	case State::Idle:
+		break;
+
+	case State::Switched:
+	case State::Reverting:
+		// 抑制状態を一時的に表示するが、タイマーは継続
+		SS_TRACE_INFO(trace::Event::SwitchSuppressed, remainingRevertSeconds());
+		metrics::Registry::instance().redemptionsSuppressed.inc();
+		setState(State::Suppressed, remainingRevertSeconds(), currentTargetScene_, originalScene_);
+
+		// 一定時間後に Switched 状態に戻す（UI表示のため）
+		cancelTimer(suppressedDisplayTimer_);
+		suppressedDisplayTimer_ = scheduleAfter(std::chrono::milliseconds(kSuppressedDisplayMs), [this]() {
+			suppressedDisplayTimer_ = TimerWheel::kInvalidTimer;
+			if (state_ == State::Switched)
+				setState(State::Switched, remainingRevertSeconds(), currentTargetScene_, originalScene_);
+		});
+		return;
+
+	case State::Suppressed:
+		// 既に抑制中なら何もしない
+		return;
+	}
+
+	originalScene_ = frontend_.currentScene();
+	currentTargetScene_ = rule.targetScene;
+
+	corelog::write(corelog::Debug, "[obs-scene-switcher] Switching to '%s'%s", rule.targetScene.c_str(),
+		       hasRevert ? "" : " (no revert)");
+
+	frontend_.applyTransitionOverride(rule);
+	switchScene(rule.targetScene, ruleLabel(rule));
+
+	// 着地確認が不要（すでに表示中・シーンなし）なら遷移は発生しない
+	if (!pendingSwitch_)
+		frontend_.restoreTransitionOverride();
+
+	if (!hasRevert) {
+		state_ = State::Idle;
+		setState(State::Idle);
+		return;
+	}
+
+	state_ = State::Switched;
+	setState(State::Switched, rule.revertSeconds, currentTargetScene_, originalScene_);
+
+	revertTimerId_ = scheduleAfter(std::chrono::seconds(rule.revertSeconds), [this]() {
+		revertTimerId_ = TimerWheel::kInvalidTimer;
+		onRevertTimeout();
+	});
+}
+
+void SwitchEngine::runActions(const RewardRule &rule)
+{
+	// 2 つ目の切替は 1 つ目の「切替中」に抑制されるだけなので、最初の切替だけを行う（保存時にも弾いている）
+	bool switched = !rule.targetScene.empty();
+	if (switched)
+		switchWithRevert(rule);
+
+	for (const auto &action : rule.actions) {
+		if (std::holds_alternative<SwitchSceneAction>(action)) {
+			if (switched) {
+				corelog::write(corelog::Warning,
+					       "[obs-scene-switcher] Rule '%s' has more than one scene switch; skipping '%s'",
+					       ruleLabel(rule).c_str(), std::get<SwitchSceneAction>(action).scene.c_str());
+				continue;
+			}
+			switched = true;
+		}
+		std::visit([&](const auto &a) { applyAction(a, rule); }, action);
+	}
+}
+
+void SwitchEngine::applyAction(const SwitchSceneAction &action, const RewardRule &rule)
+{
+	// シーン切替は State Machine を経由させる（抑制・復帰を共通化）
+	RewardRule switchRule = rule;
+	switchRule.targetScene = action.scene;
+	switchRule.revertSeconds = action.revertSeconds;
+	switchRule.actions.clear();
+	switchWithRevert(switchRule);
+}
+
+void SwitchEngine::applyAction(const SceneItemVisibilityAction &action, const RewardRule &)
+{
+	const auto current = frontend_.setSceneItemVisible(action.scene, action.source, action.visible);
+	if (!current) {
+		corelog::write(corelog::Warning, "[obs-scene-switcher] Scene item not found: %s / %s",
+			       action.scene.c_str(), action.source.c_str());
+		return;
+	}
+
+	corelog::write(corelog::Debug, "[obs-scene-switcher] Scene item '%s' in '%s' -> %s", action.source.c_str(),
+		       action.scene.c_str(), action.visible ? "visible" : "hidden");
+
+	const std::string sceneName = action.scene;
+	const std::string sourceName = action.source;
+	scheduleActionRevert("item:" + action.scene + "/" + action.source, *current, action.revertSeconds,
+			     [this, sceneName, sourceName](bool original) {
+				     // 復帰時点で再度解決する（その間に削除されている可能性がある）
+				     frontend_.setSceneItemVisible(sceneName, sourceName, original);
+			     });
+}
+
+void SwitchEngine::applyAction(const FilterToggleAction &action, const RewardRule &)
+{
+	const auto current = frontend_.setFilterEnabled(action.source, action.filter, action.enabled);
+	if (!current) {
+		corelog::write(corelog::Warning, "[obs-scene-switcher] Filter not found: %s / %s", action.source.c_str(),
+			       action.filter.c_str());
+		return;
+	}
+
+	corelog::write(corelog::Debug, "[obs-scene-switcher] Filter '%s' on '%s' -> %s", action.filter.c_str(),
+		       action.source.c_str(), action.enabled ? "enabled" : "disabled");
+
+	const std::string sourceName = action.source;
+	const std::string filterName = action.filter;
+	scheduleActionRevert("filter:" + action.source + "/" + action.filter, *current, action.revertSeconds,
+			     [this, sourceName, filterName](bool original) {
+				     frontend_.setFilterEnabled(sourceName, filterName, original);
+			     });
+}
+
+void SwitchEngine::applyAction(const MediaRestartAction &action, const RewardRule &)
+{
+	if (!frontend_.restartMedia(action.source)) {
+		corelog::write(corelog::Warning, "[obs-scene-switcher] Media source not found: %s",
+			       action.source.c_str());
+		return;
+	}
+
+	corelog::write(corelog::Debug, "[obs-scene-switcher] Media restarted: %s", action.source.c_str());
+
+	const std::string sourceName = action.source;
+	scheduleActionRevert("media:" + action.source, true, action.revertSeconds,
+			     [this, sourceName](bool) { frontend_.stopMedia(sourceName); });
+}
+
+void SwitchEngine::scheduleActionRevert(const std::string &key, bool originalState, int revertSeconds,
+					std::function<void(bool originalState)> revert)
+{
+	auto it = activeActions_.find(key);
+	if (it != activeActions_.end()) {
+		// 復帰待ち中の再トリガーは、最初に記録した元の状態へ戻す
+		originalState = it->second.originalState;
+		cancelTimer(it->second.timer);
+		activeActions_.erase(it);
+	}
+
+	if (revertSeconds <= 0)
+		return;
+
+	ActiveAction active;
+	active.originalState = originalState;
+	active.timer = scheduleAfter(std::chrono::seconds(revertSeconds), [this, key, revert = std::move(revert)]() {
+		auto found = activeActions_.find(key);
+		if (found == activeActions_.end())
+			return;
+
+		const bool original = found->second.originalState;
+		activeActions_.erase(found);
+
+		corelog::write(corelog::Debug, "[obs-scene-switcher] Action reverted: %s", key.c_str());
+		revert(original);
+	});
+	activeActions_[key] = active;
+}
+
+void SwitchEngine::onRevertTimeout()
+{
+	// タイマーが終了した時に Switched 状態でない場合は Idle に戻す
+	if (state_ != State::Switched && state_ != State::Suppressed) {
+		state_ = State::Idle;
+		setState(State::Idle);
+		return;
+	}
+
+	state_ = State::Reverting;
+	setState(State::Reverting, -1, originalScene_);
+
+	corelog::write(corelog::Debug, "[obs-scene-switcher] Reverting to previous scene: %s", originalScene_.c_str());
+
+	switchScene(originalScene_, "revert");
+
+	state_ = State::Idle;
+	setState(State::Idle);
+}
+
+void SwitchEngine::revertNow()
+{
+	// Manual revert: only valid in Switched state
+	if (state_ != State::Switched) {
+		corelog::write(corelog::Debug, "[obs-scene-switcher] revertNow() called but not in Switched state");
+		return;
+	}
+
+	corelog::write(corelog::Debug, "[obs-scene-switcher] Manual revert requested");
+
+	cancelTimer(revertTimerId_);
+	revertTimerId_ = TimerWheel::kInvalidTimer;
+
+	state_ = State::Reverting;
+	setState(State::Reverting, -1, originalScene_);
+
+	switchScene(originalScene_, "revert");
+
+	state_ = State::Idle;
+	setState(State::Idle);
+}
+
+TimerWheel::TimerId SwitchEngine::scheduleAfter(std::chrono::milliseconds delay, TimerWheel::Callback callback)
+{
+	const TimerWheel::TimerId id = timers_.scheduleAfter(delay, std::move(callback));
+	notifyWakeup();
+	return id;
+}
+
+bool SwitchEngine::cancelTimer(TimerWheel::TimerId id)
+{
+	if (!timers_.cancel(id))
+		return false;
+
+	notifyWakeup();
+	return true;
+}
+
+void SwitchEngine::advanceTimers(TimerWheel::Clock::time_point now)
+{
+	timers_.advance(now);
+	notifyWakeup();
+}
+
+void SwitchEngine::notifyWakeup()
+{
+	if (wakeupCallback_)
+		wakeupCallback_(timers_.nextWakeup());
+}
+
+int SwitchEngine::remainingRevertSeconds() const
+{
+	const auto remaining = timers_.remaining(revertTimerId_);
+	if (!remaining)
+		return -1;
+
+	return static_cast<int>(remaining->count() / 1000);
+}
+
+void SwitchEngine::compileTransitions(std::vector<RewardRule> &rules)
+{
+	frontend_.compileTransitions(rules);
+}
+
+void SwitchEngine::onSceneChanged()
+{
+	if (!pendingSwitch_ || frontend_.currentScene() != pendingSwitch_->sceneName)
+		return;
+
+	// カット遷移は TRANSITION_STOPPED を待たずに確定する
+	if (frontend_.isCutTransition())
+		confirmSwitch();
+}
+
+void SwitchEngine::onTransitionStopped()
+{
+	if (pendingSwitch_ && frontend_.currentScene() == pendingSwitch_->sceneName)
+		confirmSwitch();
+}
+
+void SwitchEngine::beginConfirmation(const std::string &sceneName, const std::string &label)
+{
+	if (pendingSwitch_) {
+		corelog::write(corelog::Debug, "[obs-scene-switcher] Pending switch to '%s' superseded by '%s'",
+			       pendingSwitch_->sceneName.c_str(), sceneName.c_str());
+		clearPendingSwitch();
+	}
+
+	PendingSwitch pending;
+	pending.sceneName = sceneName;
+	pending.fromScene = frontend_.currentScene();
+	pending.label = label;
+	pending.requestedAt = TimerWheel::Clock::now();
+	pending.requestedFrameNs = frontend_.videoFrameTimeNs();
+	pendingSwitch_ = std::move(pending);
+
+	armConfirmDeadline();
+}
+
+void SwitchEngine::confirmSwitch()
+{
+	// 遷移完了後に描画される次のフレームをオンエア時刻とみなす
+	const uint64_t onAirNs = frontend_.videoFrameTimeNs() + frontend_.frameIntervalNs();
+	const uint64_t latencyUs =
+		onAirNs > pendingSwitch_->requestedFrameNs ? (onAirNs - pendingSwitch_->requestedFrameNs) / 1000 : 0;
+	const auto wallUs = std::chrono::duration_cast<std::chrono::microseconds>(TimerWheel::Clock::now() -
+										   pendingSwitch_->requestedAt)
+				    .count();
+
+	auto &stats = switchLatency_[pendingSwitch_->label];
+	stats.onAir.record(latencyUs);
+	metrics::Registry::instance().switchOnAir.record(latencyUs);
+
+	SS_TRACE_INFO(trace::Event::SwitchOnAir, static_cast<int64_t>(latencyUs), pendingSwitch_->attempts,
+		      static_cast<int64_t>(wallUs), pendingSwitch_->label);
+
+	clearPendingSwitch();
+	frontend_.restoreTransitionOverride();
+}
+
+void SwitchEngine::clearPendingSwitch()
+{
+	if (!pendingSwitch_)
+		return;
+
+	cancelTimer(pendingSwitch_->deadlineTimer);
+	pendingSwitch_.reset();
+}
+
+void SwitchEngine::armConfirmDeadline()
+{
+	const int deadlineMs = frontend_.transitionDurationMs() + kConfirmGraceMs;
+
+	pendingSwitch_->deadlineTimer = scheduleAfter(std::chrono::milliseconds(deadlineMs), [this]() {
+		if (!pendingSwitch_)
+			return;
+		pendingSwitch_->deadlineTimer = TimerWheel::kInvalidTimer;
+		onConfirmDeadline();
+	});
+}
+
+void SwitchEngine::onConfirmDeadline()
+{
+	auto &stats = switchLatency_[pendingSwitch_->label];
+
+	// 手動切替・スタジオモードの移行などで別のシーンに移っていれば、それを上書きしない
+	const std::string current = frontend_.currentScene();
+	if (current != pendingSwitch_->fromScene && current != pendingSwitch_->sceneName) {
+		stats.superseded.fetch_add(1, std::memory_order_relaxed);
+		SS_TRACE_INFO(trace::Event::SwitchSuperseded, pendingSwitch_->attempts, 0, 0, current);
+		corelog::write(corelog::Debug, "[obs-scene-switcher] Pending switch to '%s' superseded by '%s' on air",
+			       pendingSwitch_->sceneName.c_str(), current.c_str());
+
+		clearPendingSwitch();
+		frontend_.restoreTransitionOverride();
+		return;
+	}
+
+	if (pendingSwitch_->attempts < kMaxSwitchAttempts) {
+		pendingSwitch_->attempts++;
+		stats.retries.fetch_add(1, std::memory_order_relaxed);
+
+		corelog::write(corelog::Warning,
+			       "[obs-scene-switcher] Switch to '%s' not on air after deadline, retrying (attempt %d)",
+			       pendingSwitch_->sceneName.c_str(), pendingSwitch_->attempts);
+
+		// 着地通知が同期的に届いても pendingSwitch_ を参照しないよう、期限を先に張る
+		const std::string sceneName = pendingSwitch_->sceneName;
+		armConfirmDeadline();
+		frontend_.setCurrentScene(sceneName);
+		return;
+	}
+
+	stats.failures.fetch_add(1, std::memory_order_relaxed);
+	corelog::write(corelog::Warning, "[obs-scene-switcher] Switch to '%s' never went on air (%d attempts)",
+		       pendingSwitch_->sceneName.c_str(), pendingSwitch_->attempts);
+
+	clearPendingSwitch();
+	frontend_.restoreTransitionOverride();
+}
@@ -0,0 +1,135 @@
+// obs-scene-switcher plugin
+// Copyright (C) 2025 ksmksks
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+#include "core/frontend_port.hpp"
+#include "core/latency_histogram.hpp"
+#include "core/reward_rule.hpp"
+#include "core/timer_wheel.hpp"
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+/**
+ * シーン切替の State Machine（OBS・Qt 非依存）
+ *
+ * - OBS への操作はすべて FrontendPort 経由で行う
+ * - 遅延処理は内部の TimerWheel に登録する。ドライバ（Qt のタイマーなど）は
+ *   WakeupCallback で通知された時刻に advanceTimers() を呼ぶ
+ * - スレッドセーフではない（UI スレッドからのみ操作すること）
+ */
+class SwitchEngine {
+public:
+	enum class State {
+		Idle,
+		Switched,
+		Reverting,
+		Suppressed
+	};
+
+	// 切替ごとのオンエア確認結果（ルール単位）
+	struct SwitchLatency {
+		LatencyHistogram onAir;  // 要求からオンエア（遷移完了後の最初のフレーム）まで
+		std::atomic<uint64_t> retries{0};
+		std::atomic<uint64_t> failures{0};
+		std::atomic<uint64_t> superseded{0};  // 確認中に手動切替などで別のシーンに移った
+	};
+
+	// remainingSeconds は不明・対象外なら -1
+	using StateCallback = std::function<void(State state, int remainingSeconds, const std::string &targetScene,
+						 const std::string &originalScene)>;
+	// 次に advanceTimers() を呼ぶべき時刻（タイマーがなければ nullopt）
+	using WakeupCallback = std::function<void(std::optional<TimerWheel::Clock::time_point>)>;
+
+	explicit SwitchEngine(FrontendPort &frontend);
+	~SwitchEngine();
+
+	SwitchEngine(const SwitchEngine &) = delete;
+	SwitchEngine &operator=(const SwitchEngine &) = delete;
+
+	void setStateCallback(StateCallback callback) { stateCallback_ = std::move(callback); }
+	void setWakeupCallback(WakeupCallback callback) { wakeupCallback_ = std::move(callback); }
+
+	void switchScene(const std::string &sceneName, const std::string &label = {});
+	void switchWithRevert(const RewardRule &rule);
+	// ルールの切替先シーンと追加アクションを実行
+	void runActions(const RewardRule &rule);
+	void revertNow();
+
+	State state() const { return state_; }
+	const std::string &targetScene() const { return currentTargetScene_; }
+	const std::string &originalScene() const { return originalScene_; }
+	int remainingRevertSeconds() const;
+
+	// 単調時計ベースのタイマー（復帰以外の遅延処理もここに登録する）
+	TimerWheel::TimerId scheduleAfter(std::chrono::milliseconds delay, TimerWheel::Callback callback);
+	bool cancelTimer(TimerWheel::TimerId id);
+	void advanceTimers(TimerWheel::Clock::time_point now = TimerWheel::Clock::now());
+
+	// ルールのトランジション指定を解決（ルール更新時・トランジション一覧の変更時）
+	void compileTransitions(std::vector<RewardRule> &rules);
+
+	// フロントエンドイベント（シーン切替の着地確認）
+	void onSceneChanged();
+	void onTransitionStopped();
+
+	const std::unordered_map<std::string, SwitchLatency> &switchLatency() const { return switchLatency_; }
+
+private:
+	void setState(State state, int remainingSeconds = -1, const std::string &targetScene = {},
+		      const std::string &originalScene = {});
+	void notifyWakeup();
+	void onRevertTimeout();
+
+	// 切替要求がオンエアに到達したかを追跡する
+	struct PendingSwitch {
+		std::string sceneName;
+		std::string fromScene;  // 切替要求時のシーン（再試行はここに留まっている場合だけ）
+		std::string label;
+		TimerWheel::Clock::time_point requestedAt;
+		uint64_t requestedFrameNs = 0;
+		TimerWheel::TimerId deadlineTimer = TimerWheel::kInvalidTimer;
+		int attempts = 1;
+	};
+
+	void beginConfirmation(const std::string &sceneName, const std::string &label);
+	void confirmSwitch();
+	void clearPendingSwitch();
+	void armConfirmDeadline();
+	void onConfirmDeadline();
+
+	// アクション種別ごとの実行（std::visit から呼び分ける）
+	void applyAction(const SwitchSceneAction &action, const RewardRule &rule);
+	void applyAction(const SceneItemVisibilityAction &action, const RewardRule &rule);
+	void applyAction(const FilterToggleAction &action, const RewardRule &rule);
+	void applyAction(const MediaRestartAction &action, const RewardRule &rule);
+
+	// 復帰待ちのアクション（再トリガー時は元の状態を保持したまま期限だけ延長）
+	struct ActiveAction {
+		TimerWheel::TimerId timer = TimerWheel::kInvalidTimer;
+		bool originalState = false;
+	};
+
+	// 復帰タイマーを張り直す。revertSeconds <= 0 なら復帰待ちを破棄する
+	void scheduleActionRevert(const std::string &key, bool originalState, int revertSeconds,
+				  std::function<void(bool originalState)> revert);
+
+	FrontendPort &frontend_;
+	StateCallback stateCallback_;
+	WakeupCallback wakeupCallback_;
+
+	State state_ = State::Idle;
+	std::string originalScene_;
+	std::string currentTargetScene_;
+	TimerWheel timers_;
+	TimerWheel::TimerId revertTimerId_ = TimerWheel::kInvalidTimer;
+	TimerWheel::TimerId suppressedDisplayTimer_ = TimerWheel::kInvalidTimer;
+
+	std::optional<PendingSwitch> pendingSwitch_;
+	std::unordered_map<std::string, SwitchLatency> switchLatency_;
+	std::unordered_map<std::string, ActiveAction> activeActions_;  // キー: 種別:対象
+};
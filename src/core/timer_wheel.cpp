@@ -0,0 +1,282 @@
+// obs-scene-switcher plugin
+// Copyright (C) 2025 ksmksks
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "timer_wheel.hpp"
+
+#include <algorithm>
+#include <utility>
+
+namespace {
+
+int countTrailingZeros(uint64_t v)
+{
+	int n = 0;
+	while ((v & 1) == 0) {
+		v >>= 1;
+		++n;
+	}
+	return n;
+}
+
+uint64_t rotateRight(uint64_t v, int shift)
+{
+	shift &= 63;
+	if (shift == 0)
+		return v;
+	return (v >> shift) | (v << (64 - shift));
+}
+
+} // namespace
+
+TimerWheel::TimerWheel() : origin_(Clock::now())
+{
+	for (auto &level : heads_)
+		level.fill(kNil);
+}
+
+uint64_t TimerWheel::toTick(Clock::time_point tp) const
+{
+	if (tp <= origin_)
+		return 0;
+
+	// 期限は切り上げ（早すぎる発火を防ぐ）
+	const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(tp - origin_).count();
+	return static_cast<uint64_t>((ns + 999999) / 1000000);
+}
+
+TimerWheel::Clock::time_point TimerWheel::toTimePoint(uint64_t tick) const
+{
+	return origin_ + std::chrono::milliseconds(tick);
+}
+
+TimerWheel::TimerId TimerWheel::schedule(Clock::time_point deadline, Callback callback)
+{
+	// アイドル中のホイールは現在時刻に追従させる（不要な空回りを防ぐ）
+	if (activeCount_ == 0) {
+		const auto now = Clock::now();
+		if (now > origin_) {
+			const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - origin_).count();
+			currentTick_ = std::max(currentTick_, static_cast<uint64_t>(elapsed));
+		}
+	}
+
+	const int32_t index = allocNode();
+	Node &node = nodes_[index];
+	node.deadline = deadline;
+	node.expiresTick = std::max(toTick(deadline), currentTick_ + 1);
+	node.callback = std::move(callback);
+	node.active = true;
+
+	link(index);
+	++activeCount_;
+
+	return (static_cast<uint64_t>(node.generation) << 32) | static_cast<uint64_t>(index + 1);
+}
+
+TimerWheel::TimerId TimerWheel::scheduleAfter(std::chrono::milliseconds delay, Callback callback)
+{
+	return schedule(Clock::now() + delay, std::move(callback));
+}
+
+bool TimerWheel::cancel(TimerId id)
+{
+	const int32_t index = nodeIndex(id);
+	if (index == kNil)
+		return false;
+
+	unlink(index);
+	freeNode(index);
+	--activeCount_;
+	return true;
+}
+
+bool TimerWheel::isPending(TimerId id) const
+{
+	return nodeIndex(id) != kNil;
+}
+
+std::optional<std::chrono::milliseconds> TimerWheel::remaining(TimerId id, Clock::time_point now) const
+{
+	const int32_t index = nodeIndex(id);
+	if (index == kNil)
+		return std::nullopt;
+
+	const auto deadline = nodes_[index].deadline;
+	if (deadline <= now)
+		return std::chrono::milliseconds(0);
+
+	return std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now);
+}
+
+void TimerWheel::advance(Clock::time_point now)
+{
+	uint64_t target = 0;
+	if (now > origin_)
+		target = static_cast<uint64_t>(
+			std::chrono::duration_cast<std::chrono::milliseconds>(now - origin_).count());
+
+	while (true) {
+		// 空スロットは飛ばして、次に処理が必要な tick まで一気に進める
+		const auto next = nextPendingTick();
+		if (!next || *next > target) {
+			currentTick_ = std::max(currentTick_, target);
+			return;
+		}
+
+		currentTick_ = *next;
+
+		// 上位階層から順にカスケード（下位階層へ振り直す）
+		for (int level = kLevels - 1; level >= 1; --level) {
+			const uint64_t mask = (uint64_t(1) << (kSlotBits * level)) - 1;
+			if ((currentTick_ & mask) == 0)
+				cascade(level);
+		}
+
+		// 最下位階層の該当スロットを発火
+		const int slot = static_cast<int>(currentTick_ & (kSlots - 1));
+		std::vector<Callback> expired;
+		int32_t index = heads_[0][slot];
+		while (index != kNil) {
+			const int32_t next = nodes_[index].next;
+			unlink(index);
+			expired.push_back(std::move(nodes_[index].callback));
+			freeNode(index);
+			--activeCount_;
+			index = next;
+		}
+
+		// コールバック内での schedule / cancel を許容するため、切り離してから実行
+		for (auto &cb : expired) {
+			if (cb)
+				cb();
+		}
+	}
+}
+
+std::optional<TimerWheel::Clock::time_point> TimerWheel::nextWakeup() const
+{
+	const auto tick = nextPendingTick();
+	if (!tick)
+		return std::nullopt;
+
+	return toTimePoint(*tick);
+}
+
+std::optional<uint64_t> TimerWheel::nextPendingTick() const
+{
+	std::optional<uint64_t> best;
+
+	for (int level = 0; level < kLevels; ++level) {
+		if (occupied_[level] == 0)
+			continue;
+
+		const int shift = kSlotBits * level;
+		const uint64_t block = currentTick_ >> shift;
+		const int current = static_cast<int>(block & (kSlots - 1));
+
+		// current の次のスロットから一周（current 自身は 64 ブロック先）
+		const uint64_t rotated = rotateRight(occupied_[level], current + 1);
+		const uint64_t offset = static_cast<uint64_t>(countTrailingZeros(rotated)) + 1;
+		const uint64_t tick = (block + offset) << shift;
+
+		if (!best || tick < *best)
+			best = tick;
+	}
+
+	return best;
+}
+
+int32_t TimerWheel::nodeIndex(TimerId id) const
+{
+	const uint64_t raw = id & 0xffffffffu;
+	if (raw == 0 || raw > nodes_.size())
+		return kNil;
+
+	const int32_t index = static_cast<int32_t>(raw - 1);
+	const Node &node = nodes_[index];
+	if (!node.active || node.generation != static_cast<uint32_t>(id >> 32))
+		return kNil;
+
+	return index;
+}
+
+int32_t TimerWheel::allocNode()
+{
+	if (!freeList_.empty()) {
+		const int32_t index = freeList_.back();
+		freeList_.pop_back();
+		return index;
+	}
+
+	nodes_.emplace_back();
+	return static_cast<int32_t>(nodes_.size() - 1);
+}
+
+void TimerWheel::freeNode(int32_t index)
+{
+	Node &node = nodes_[index];
+	node.active = false;
+	node.callback = nullptr;
+	node.prev = kNil;
+	node.next = kNil;
+	++node.generation; // 古い TimerId を無効化
+	freeList_.push_back(index);
+}
+
+void TimerWheel::link(int32_t index)
+{
+	Node &node = nodes_[index];
+	const uint64_t delta = node.expiresTick > currentTick_ ? node.expiresTick - currentTick_ : 0;
+
+	int level = 0;
+	while (level < kLevels - 1 && delta >= (uint64_t(1) << (kSlotBits * (level + 1))))
+		++level;
+
+	// 期限切れ（カスケード時の delta == 0）は現在 tick のスロットへ
+	const uint64_t tick = delta == 0 ? currentTick_ : node.expiresTick;
+	const int slot = static_cast<int>((tick >> (kSlotBits * level)) & (kSlots - 1));
+
+	node.level = static_cast<uint8_t>(level);
+	node.slot = static_cast<uint8_t>(slot);
+	node.prev = kNil;
+	node.next = heads_[level][slot];
+	if (node.next != kNil)
+		nodes_[node.next].prev = index;
+	heads_[level][slot] = index;
+	occupied_[level] |= uint64_t(1) << slot;
+}
+
+void TimerWheel::unlink(int32_t index)
+{
+	Node &node = nodes_[index];
+
+	if (node.prev != kNil)
+		nodes_[node.prev].next = node.next;
+	else
+		heads_[node.level][node.slot] = node.next;
+
+	if (node.next != kNil)
+		nodes_[node.next].prev = node.prev;
+
+	if (heads_[node.level][node.slot] == kNil)
+		occupied_[node.level] &= ~(uint64_t(1) << node.slot);
+
+	node.prev = kNil;
+	node.next = kNil;
+}
+
+void TimerWheel::cascade(int level)
+{
+	const int slot = static_cast<int>((currentTick_ >> (kSlotBits * level)) & (kSlots - 1));
+
+	int32_t index = heads_[level][slot];
+	heads_[level][slot] = kNil;
+	occupied_[level] &= ~(uint64_t(1) << slot);
+
+	while (index != kNil) {
+		const int32_t next = nodes_[index].next;
+		link(index);
+		index = next;
+	}
+}
@@ -0,0 +1,92 @@
+// obs-scene-switcher plugin
+// Copyright (C) 2025 ksmksks
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <vector>
+
+/**
+ * 単調時計（steady_clock）ベースの階層タイマーホイール
+ *
+ * - 分解能 1ms、64 スロット × 5 階層（約 12 日まで）
+ * - schedule / cancel は O(1)
+ * - advance() で期限到来分のコールバックを実行する
+ * - スレッドセーフではない（所有スレッドからのみ操作すること）
+ */
+class TimerWheel {
+public:
+	using Clock = std::chrono::steady_clock;
+	using TimerId = uint64_t;
+	using Callback = std::function<void()>;
+
+	static constexpr TimerId kInvalidTimer = 0;
+
+	TimerWheel();
+
+	// deadline に到達したら callback を実行するタイマーを登録
+	TimerId schedule(Clock::time_point deadline, Callback callback);
+	TimerId scheduleAfter(std::chrono::milliseconds delay, Callback callback);
+
+	// 未発火のタイマーを取り消す（発火済み・無効 ID の場合は false）
+	bool cancel(TimerId id);
+
+	bool isPending(TimerId id) const;
+
+	// 残り時間（未登録の場合は std::nullopt）
+	std::optional<std::chrono::milliseconds> remaining(TimerId id, Clock::time_point now = Clock::now()) const;
+
+	// now までに期限が到来したタイマーを発火する
+	void advance(Clock::time_point now = Clock::now());
+
+	// 次にホイールを進める必要がある時刻（タイマーがなければ std::nullopt）
+	std::optional<Clock::time_point> nextWakeup() const;
+
+	size_t size() const { return activeCount_; }
+	bool empty() const { return activeCount_ == 0; }
+
+private:
+	static constexpr int kSlotBits = 6;
+	static constexpr int kSlots = 1 << kSlotBits;
+	static constexpr int kLevels = 5;
+	static constexpr int32_t kNil = -1;
+
+	struct Node {
+		uint64_t expiresTick = 0;
+		Clock::time_point deadline;
+		Callback callback;
+		int32_t prev = kNil;
+		int32_t next = kNil;
+		uint32_t generation = 1;
+		uint8_t level = 0;
+		uint8_t slot = 0;
+		bool active = false;
+	};
+
+	uint64_t toTick(Clock::time_point tp) const;
+	Clock::time_point toTimePoint(uint64_t tick) const;
+
+	int32_t nodeIndex(TimerId id) const;
+	int32_t allocNode();
+	void freeNode(int32_t index);
+
+	void link(int32_t index);
+	void unlink(int32_t index);
+	void cascade(int level);
+
+	std::optional<uint64_t> nextPendingTick() const;
+
+	Clock::time_point origin_;
+	uint64_t currentTick_ = 0;
+
+	std::vector<Node> nodes_;
+	std::vector<int32_t> freeList_;
+	size_t activeCount_ = 0;
+
+	std::array<std::array<int32_t, kSlots>, kLevels> heads_;
+	std::array<uint64_t, kLevels> occupied_{};
+};
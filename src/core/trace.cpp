@@ -0,0 +1,196 @@
+// obs-scene-switcher plugin
+// Copyright (C) 2025 ksmksks
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "trace.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <thread>
+
+namespace trace {
+
+namespace {
+
+constexpr size_t kCapacity = 4096;  // 2 のべき乗
+constexpr size_t kTextWords = 3;    // text を 8 バイト単位で格納
+
+// 各スロットは seqlock で保護する（書き込み中は seq が奇数）
+struct Slot {
+	std::atomic<uint64_t> seq{0};
+	std::atomic<uint64_t> timestampNs{0};
+	std::atomic<uint64_t> meta{0};  // event(16) | threadId(32)
+	std::array<std::atomic<int64_t>, 3> args{};
+	std::array<std::atomic<uint64_t>, kTextWords> text{};
+};
+
+struct Ring {
+	std::atomic<uint64_t> head{0};
+	std::array<Slot, kCapacity> slots;
+};
+
+Ring &ring()
+{
+	static Ring instance;
+	return instance;
+}
+
+uint64_t nowNs()
+{
+	return static_cast<uint64_t>(
+		std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+			.count());
+}
+
+uint32_t currentThreadId()
+{
+	thread_local const uint32_t id = static_cast<uint32_t>(std::hash<std::thread::id>{}(std::this_thread::get_id()));
+	return id;
+}
+
+struct EventInfo {
+	const char *name;
+	std::array<const char *, 3> argNames;
+};
+
+constexpr EventInfo kEventInfo[] = {
+	{"redemption_received", {"kind", nullptr, nullptr}},
+	{"redemption_ignored", {"kind", nullptr, nullptr}},
+	{"rule_skipped_disabled", {"rule", nullptr, nullptr}},
+	{"rule_skipped_scene", {"rule", nullptr, nullptr}},
+	{"rule_skipped_predicate", {"rule", nullptr, nullptr}},
+	{"rule_matched", {"rule", "revert_s", nullptr}},
+	{"rule_not_found", {"rules", nullptr, nullptr}},
+	{"rule_cooldown", {"rule", "scope", "remaining_ms"}},
+	{"rule_combo", {"rule", "completed", nullptr}},
+	{"rule_stale", {"rule", "age_ms", "budget_ms"}},
+	{"switch_requested", {nullptr, nullptr, nullptr}},
+	{"switch_suppressed", {"remaining_s", nullptr, nullptr}},
+	{"switch_on_air", {"latency_us", "attempts", "wall_us"}},
+	{"switch_superseded", {"attempts", nullptr, nullptr}},
+	{"eventsub_message", {"type", "bytes", nullptr}},
+	{"eventsub_notification", {"kind", "amount", nullptr}},
+};
+static_assert(sizeof(kEventInfo) / sizeof(kEventInfo[0]) == static_cast<size_t>(Event::Count),
+	      "kEventInfo must cover every trace::Event");
+
+} // namespace
+
+void record(Event event, int64_t a0, int64_t a1, int64_t a2, const char *text, size_t textLength)
+{
+	Ring &r = ring();
+	const uint64_t index = r.head.fetch_add(1, std::memory_order_relaxed);
+	Slot &slot = r.slots[index & (kCapacity - 1)];
+
+	// 書き込み開始（奇数）
+	slot.seq.store(index * 2 + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	slot.timestampNs.store(nowNs(), std::memory_order_relaxed);
+	slot.meta.store((static_cast<uint64_t>(event) << 32) | currentThreadId(), std::memory_order_relaxed);
+	slot.args[0].store(a0, std::memory_order_relaxed);
+	slot.args[1].store(a1, std::memory_order_relaxed);
+	slot.args[2].store(a2, std::memory_order_relaxed);
+
+	std::array<uint64_t, kTextWords> words{};
+	if (text)
+		std::memcpy(words.data(), text, std::min(textLength, sizeof(words)));
+	for (size_t i = 0; i < kTextWords; ++i)
+		slot.text[i].store(words[i], std::memory_order_relaxed);
+
+	// 書き込み完了（偶数）
+	slot.seq.store(index * 2 + 2, std::memory_order_release);
+}
+
+std::vector<Record> snapshot()
+{
+	Ring &r = ring();
+	const uint64_t head = r.head.load(std::memory_order_acquire);
+	const uint64_t begin = head > kCapacity ? head - kCapacity : 0;
+
+	std::vector<Record> records;
+	records.reserve(static_cast<size_t>(head - begin));
+
+	for (uint64_t index = begin; index < head; ++index) {
+		const Slot &slot = r.slots[index & (kCapacity - 1)];
+
+		const uint64_t seq = slot.seq.load(std::memory_order_acquire);
+		if (seq != index * 2 + 2)
+			continue;  // 書き込み中、または既に上書き済み
+
+		Record rec;
+		rec.seq = index;
+		rec.timestampNs = slot.timestampNs.load(std::memory_order_relaxed);
+		const uint64_t meta = slot.meta.load(std::memory_order_relaxed);
+		rec.event = static_cast<Event>(meta >> 32);
+		rec.threadId = static_cast<uint32_t>(meta);
+		for (size_t i = 0; i < rec.args.size(); ++i)
+			rec.args[i] = slot.args[i].load(std::memory_order_relaxed);
+
+		std::array<uint64_t, kTextWords> words{};
+		for (size_t i = 0; i < kTextWords; ++i)
+			words[i] = slot.text[i].load(std::memory_order_relaxed);
+		std::memcpy(rec.text.data(), words.data(), rec.text.size());
+
+		// 読み取り中に上書きされていないことを確認
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (slot.seq.load(std::memory_order_relaxed) != seq)
+			continue;
+
+		records.push_back(rec);
+	}
+
+	return records;
+}
+
+const char *eventName(Event event)
+{
+	const auto i = static_cast<size_t>(event);
+	return i < static_cast<size_t>(Event::Count) ? kEventInfo[i].name : "unknown";
+}
+
+std::string format(const Record &rec, uint64_t originNs)
+{
+	const double ms = rec.timestampNs >= originNs ? (rec.timestampNs - originNs) / 1e6 : 0.0;
+
+	char buf[256];
+	int n = std::snprintf(buf, sizeof(buf), "#%llu +%.3f ms tid=%08x %s", (unsigned long long)rec.seq, ms,
+			      rec.threadId, eventName(rec.event));
+	std::string line(buf, n > 0 ? static_cast<size_t>(n) : 0);
+
+	const auto i = static_cast<size_t>(rec.event);
+	if (i < static_cast<size_t>(Event::Count)) {
+		for (size_t a = 0; a < rec.args.size(); ++a) {
+			const char *argName = kEventInfo[i].argNames[a];
+			if (!argName)
+				continue;
+			n = std::snprintf(buf, sizeof(buf), " %s=%lld", argName, (long long)rec.args[a]);
+			line.append(buf, n > 0 ? static_cast<size_t>(n) : 0);
+		}
+	}
+
+	const size_t textLength = strnlen(rec.text.data(), rec.text.size());
+	if (textLength > 0) {
+		line += " '";
+		line.append(rec.text.data(), textLength);
+		line += "'";
+	}
+
+	return line;
+}
+
+size_t dump(std::ostream &out)
+{
+	const std::vector<Record> records = snapshot();
+	const uint64_t originNs = records.empty() ? 0 : records.front().timestampNs;
+
+	for (const auto &rec : records)
+		out << format(rec, originNs) << '\n';
+
+	return records.size();
+}
+
+} // namespace trace
@@ -0,0 +1,90 @@
+// obs-scene-switcher plugin
+// Copyright (C) 2025 ksmksks
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+ * ホットパス用のバイナリトレース
+ *
+ * - 固定長レコードのリングバッファに、任意のスレッドからロックフリーで書き込む
+ * - 書き込み時は整数と短い文字列のコピーのみで、書式化はダンプ時に遅延して行う
+ * - SS_TRACE_LEVEL より詳細なレベルのトレースはコンパイル時に取り除かれる
+ */
+
+// トレースレベル（0: 無効, 1: info, 2: debug）
+#ifndef SS_TRACE_LEVEL
+#define SS_TRACE_LEVEL 2
+#endif
+
+namespace trace {
+
+enum class Event : uint16_t {
+	RedemptionReceived,   // a0=event kind, text=reward_id
+	RedemptionIgnored,    // a0=event kind, text=reward_id
+	RuleSkippedDisabled,  // a0=rule index
+	RuleSkippedScene,     // a0=rule index
+	RuleSkippedPredicate, // a0=rule index
+	RuleMatched,          // a0=rule index, a1=revert seconds, text=target
+	RuleNotFound,         // a0=rule count, a1=event kind, text=reward_id
+	RuleCooldown,         // a0=rule index, a1=cooldown scope, a2=remaining ms
+	RuleCombo,            // a0=rule index, a1=1 if completed
+	RuleStale,            // a0=rule index, a1=event age ms, a2=budget ms
+	SwitchRequested,      // text=scene
+	SwitchSuppressed,     // a0=remaining seconds
+	SwitchOnAir,          // a0=latency us, a1=attempts, a2=wall us, text=label
+	SwitchSuperseded,     // a0=attempts, text=scene on air instead
+	EventSubMessage,      // a0=message type (0:welcome 1:reconnect 2:notification 3:keepalive 4:revocation), a1=bytes
+	EventSubNotification, // a0=event kind, a1=user input length / bits / viewers, text=reward_id or user
+	Count
+};
+
+struct Record {
+	uint64_t seq = 0;
+	uint64_t timestampNs = 0;  // steady_clock
+	uint32_t threadId = 0;
+	Event event = Event::Count;
+	std::array<int64_t, 3> args{};
+	std::array<char, 24> text{};  // 終端なしで切り詰め
+};
+
+// 書き込み（ロックフリー・wait-free）
+void record(Event event, int64_t a0 = 0, int64_t a1 = 0, int64_t a2 = 0, const char *text = nullptr,
+	    size_t textLength = 0);
+
+inline void record(Event event, int64_t a0, int64_t a1, int64_t a2, const std::string &text)
+{
+	record(event, a0, a1, a2, text.data(), text.size());
+}
+
+// 現在リングに残っている完全なレコードを古い順に取得
+std::vector<Record> snapshot();
+
+// 1 レコードを 1 行に書式化
+std::string format(const Record &record, uint64_t originNs);
+
+// リングの内容をすべて書き出す（書き出した件数を返す）
+size_t dump(std::ostream &out);
+
+const char *eventName(Event event);
+
+} // namespace trace
+
+#if SS_TRACE_LEVEL >= 1
+#define SS_TRACE_INFO(...) ::trace::record(__VA_ARGS__)
+#else
+#define SS_TRACE_INFO(...) ((void)0)
+#endif
+
+#if SS_TRACE_LEVEL >= 2
+#define SS_TRACE_DEBUG(...) ::trace::record(__VA_ARGS__)
+#else
+#define SS_TRACE_DEBUG(...) ((void)0)
+#endif
@@ -0,0 +1,100 @@
+// obs-scene-switcher plugin
+// Copyright (C) 2025 ksmksks
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <variant>
+
+// ルールのトリガーになるイベントの種類（TwitchEvent の並びと同じ）
+enum class EventKind : int {
+	Redemption = 0,
+	Cheer,
+	Subscribe,
+	Raid,
+	Follow,
+};
+
+constexpr size_t kEventKindCount = 5;
+
+// チャンネルポイントの引き換え（channel.channel_points_custom_reward_redemption.add）
+struct RedemptionEvent {
+	std::string id;  // 引き換え ID（状態更新に使う）
+	std::string rewardId;
+	std::string userId;
+	std::string userLogin;
+	std::string userName;
+	std::string userInput;
+};
+
+// Bits（channel.cheer）
+struct CheerEvent {
+	std::string userId;  // 匿名なら空
+	std::string userLogin;
+	std::string userName;
+	std::string message;
+	int bits = 0;
+	bool anonymous = false;
+};
+
+// サブスク（channel.subscribe）
+struct SubscribeEvent {
+	std::string userId;
+	std::string userLogin;
+	std::string userName;
+	std::string tier;  // "1000" / "2000" / "3000"
+	bool isGift = false;
+};
+
+// レイド（channel.raid、このチャンネルへのレイドのみ）
+struct RaidEvent {
+	std::string fromUserId;
+	std::string fromUserLogin;
+	std::string fromUserName;
+	int viewers = 0;
+};
+
+// フォロー（channel.follow）
+struct FollowEvent {
+	std::string userId;
+	std::string userLogin;
+	std::string userName;
+};
+
+// 1 本の WebSocket で受ける通知（仮想関数ではなく std::visit で振り分ける）
+using TwitchEvent = std::variant<RedemptionEvent, CheerEvent, SubscribeEvent, RaidEvent, FollowEvent>;
+
+inline EventKind eventKind(const TwitchEvent &event)
+{
+	return static_cast<EventKind>(event.index());
+}
+
+// EventSub の購読条件と設定ファイル上の名前
+struct EventTypeInfo {
+	EventKind kind;
+	const char *subscriptionType;
+	const char *version;
+	const char *name;  // 設定ファイル・ログ用
+	// 配信者 ID を入れる condition のキー（2 つ目は不要なら nullptr）
+	const char *conditionKeys[2];
+};
+
+constexpr EventTypeInfo kEventTypes[kEventKindCount] = {
+	{EventKind::Redemption, "channel.channel_points_custom_reward_redemption.add", "1", "redemption",
+	 {"broadcaster_user_id", nullptr}},
+	{EventKind::Cheer, "channel.cheer", "1", "cheer", {"broadcaster_user_id", nullptr}},
+	{EventKind::Subscribe, "channel.subscribe", "1", "subscribe", {"broadcaster_user_id", nullptr}},
+	{EventKind::Raid, "channel.raid", "1", "raid", {"to_broadcaster_user_id", nullptr}},
+	{EventKind::Follow, "channel.follow", "2", "follow", {"broadcaster_user_id", "moderator_user_id"}},
+};
+
+inline const EventTypeInfo &eventTypeInfo(EventKind kind)
+{
+	return kEventTypes[static_cast<size_t>(kind)];
+}
+
+// 設定ファイル上の名前 → 種類（不明なら nullopt）
+std::optional<EventKind> eventKindFromName(std::string_view name);
@@ -4,24 +4,46 @@
 
 #include "eventsub_client.hpp"
 #include "obs_scene_switcher.hpp"
+#include "core/trace.hpp"
+#include "core/metrics.hpp"
+#include "net/network.hpp"
 #include <obs-module.h>
-#include <wininet.h>
-
-#pragma comment(lib, "Wininet.lib")
+#include <algorithm>
+#include <type_traits>
 
 using json = nlohmann::json;
 
 static constexpr const char *kDefaultWsUrl = "wss://eventsub.wss.twitch.tv/ws";
 
+// 重複判定のために保持する message_id の数
+static constexpr size_t kRecentMessageIds = 256;
+
+static std::vector<SubscriptionManager::Spec> subscriptionSpecs(const std::vector<EventKind> &kinds)
+{
+	std::vector<SubscriptionManager::Spec> specs;
+	for (EventKind kind : kinds) {
+		const EventTypeInfo &info = eventTypeInfo(kind);
+		SubscriptionManager::Spec spec{info.subscriptionType, info.version, {}};
+		for (const char *key : info.conditionKeys) {
+			if (key)
+				spec.conditionKeys.push_back(key);
+		}
+		specs.push_back(std::move(spec));
+	}
+	return specs;
+}
+
 EventSubClient &EventSubClient::instance()
 {
 	static EventSubClient s_instance;
 	return s_instance;
 }
 
-EventSubClient::EventSubClient()
+EventSubClient::EventSubClient() : subscriptions_(subscriptionSpecs({EventKind::Redemption}))
 {
 	ix::initNetSystem();
+
+	subscriptions_.setArmedCallback([this]() { emit subscriptionsArmed(); });
 }
 
 std::string EventSubClient::defaultWebSocketUrl() const
@@ -29,6 +51,17 @@ std::string EventSubClient::defaultWebSocketUrl() const
 	return kDefaultWsUrl;
 }
 
+void EventSubClient::setEventKinds(const std::vector<EventKind> &kinds)
+{
+	std::vector<EventKind> wanted{EventKind::Redemption};
+	for (EventKind kind : kinds) {
+		if (std::find(wanted.begin(), wanted.end(), kind) == wanted.end())
+			wanted.push_back(kind);
+	}
+
+	subscriptions_.setSpecs(subscriptionSpecs(wanted));
+}
+
 void EventSubClient::start(const std::string &accessToken, const std::string &broadcasterUserId,
 			   const std::string &clientId)
 {
@@ -43,6 +76,10 @@ void EventSubClient::start(const std::string &accessToken, const std::string &br
 
 	running_ = true;
 	connected_ = false;
+	migrating_ = false;
+
+	// サブスクリプションは session_welcome を受けてから作る
+	subscriptions_.configure(clientId, accessToken, broadcasterUserId);
 
 	blog(LOG_INFO, "[obs-scene-switcher] Starting EventSub WebSocket connection");
 	connectSocket(); // default URL
@@ -64,6 +101,8 @@ void EventSubClient::stop()
 		pendingReconnectUrl_.clear();
 		reconnectRequested_ = false;
 	}
+	migrating_ = false;
+	subscriptions_.reset();
 
 	try {
 		websocket_.stop();
@@ -88,88 +127,6 @@ void EventSubClient::connectSocket(const std::string &url)
 	websocket_.setPingInterval(25); // twitch keepalive より少し短めに ping
 }
 
-json EventSubClient::httpGet(const std::string &url)
-{
-	HINTERNET hInet = InternetOpenA("EventSubClient", INTERNET_OPEN_TYPE_DIRECT, NULL, NULL, 0);
-	HINTERNET hConn = InternetConnectA(hInet, "api.twitch.tv", 443, NULL, NULL, INTERNET_SERVICE_HTTP, 0, 0);
-
-	HINTERNET hReq = HttpOpenRequestA(hConn, "GET", url.c_str(), NULL, NULL, NULL, INTERNET_FLAG_SECURE, 0);
-
-	std::string headers = "Client-ID: " + clientId_ + "\r\nAuthorization: Bearer " + accessToken_ + "\r\n";
-
-	HttpSendRequestA(hReq, headers.c_str(), (DWORD)headers.size(), NULL, 0);
-
-	char buf[8192];
-	DWORD read = 0;
-	std::string response;
-
-	while (InternetReadFile(hReq, buf, sizeof(buf), &read) && read > 0)
-		response.append(buf, read);
-
-	InternetCloseHandle(hReq);
-	InternetCloseHandle(hConn);
-	InternetCloseHandle(hInet);
-
-	auto json = json::parse(response, nullptr, false);
-	if (json.is_discarded())
-		return {};
-
-	return json;
-}
-
-bool EventSubClient::httpPost(const std::string &body)
-{
-	HINTERNET hInet = InternetOpenA("EventSubClient", INTERNET_OPEN_TYPE_DIRECT, NULL, NULL, 0);
-	HINTERNET hConn = InternetConnectA(hInet, "api.twitch.tv", 443, NULL, NULL, INTERNET_SERVICE_HTTP, 0, 0);
-
-	HINTERNET hReq = HttpOpenRequestA(hConn, "POST", "/helix/eventsub/subscriptions", NULL, NULL, NULL,
-					  INTERNET_FLAG_SECURE, 0);
-
-	std::string headers = "Client-ID: " + clientId_ + "\r\nAuthorization: Bearer " + accessToken_ +
-			      "\r\nContent-Type: application/json\r\n";
-
-	HttpSendRequestA(hReq, headers.c_str(), (DWORD)headers.size(), (LPVOID)body.c_str(), (DWORD)body.size());
-
-	char buf[8192];
-	DWORD read = 0;
-	std::string response;
-
-	while (InternetReadFile(hReq, buf, sizeof(buf), &read) && read > 0)
-		response.append(buf, read);
-
-	InternetCloseHandle(hReq);
-	InternetCloseHandle(hConn);
-	InternetCloseHandle(hInet);
-
-	auto json = json::parse(response, nullptr, false);
-	if (json.is_discarded())
-		return false;
-
-	blog(LOG_DEBUG, "[obs-scene-switcher][EventSub] POST /subscriptions response: %s", response.c_str());
-	return true;
-}
-
-void EventSubClient::ensureSubscription(const std::string &sessionId)
-{
-	blog(LOG_DEBUG, "[obs-scene-switcher][EventSub] Checking subscriptions...");
-
-	json body = {{"type", "channel.channel_points_custom_reward_redemption.add"},
-			       {"version", "1"},
-			       {"condition",
-				{
-					{"broadcaster_user_id", broadcasterUserId_},
-				}},
-			       {"transport",
-				{
-					{"method", "websocket"},
-					{"session_id", sessionId},
-				}}};
-
-	if (!httpPost(body.dump())) {
-		blog(LOG_ERROR, "[obs-scene-switcher] Failed to create EventSub subscription");
-	}
-}
-
 void EventSubClient::setupHandlers()
 {
 	websocket_.setOnMessageCallback([this](const ix::WebSocketMessagePtr &msg) {
@@ -203,6 +160,9 @@ void EventSubClient::setupHandlers()
 					}
 				}
 
+				// reconnect_url 以外の再接続では新しいセッションで作り直しになる
+				migrating_ = !nextUrl.empty();
+
 				if (nextUrl.empty()) {
 					blog(LOG_DEBUG, "[obs-scene-switcher][EventSub] Attempting reconnect...");
 					std::lock_guard<std::mutex> lk(urlMutex_);
@@ -216,6 +176,7 @@ void EventSubClient::setupHandlers()
 				// 指数バックオフで再接続（レート制限回避）
 				int backoffMs = calculateBackoffMs();
 				reconnectAttempts_++;
+				metrics::Registry::instance().eventsubReconnects.inc();
 				blog(LOG_DEBUG, "[obs-scene-switcher][EventSub] Reconnecting in %d ms (attempt %d)", backoffMs, reconnectAttempts_.load());
 
 				std::thread([this, backoffMs]() {
@@ -246,49 +207,68 @@ void EventSubClient::setupHandlers()
 
 void EventSubClient::handleMessage(const std::string &msg)
 {
-	try {
-		auto json = json::parse(msg);
+	const int64_t receivedMicros = systemNowMicros();
 
-		const std::string type = json["metadata"].value("message_type", "");
-		if (type.empty())
-			return;
+	EventSubMessage message;
+	std::string error;
+	if (!parseEventSubMessage(msg, message, error)) {
+		blog(LOG_ERROR, "[obs-scene-switcher] EventSub JSON parse error: %s", error.c_str());
+		return;
+	}
 
-		if (type == "session_welcome") {
-			blog(LOG_DEBUG, "[obs-scene-switcher][EventSub] Received session_welcome");
-			handleSessionWelcome(json);
-		} else if (type == "session_reconnect") {
-			// ここで start/stop しない（フラグ立てて close 側で繋ぎ直す）
-			blog(LOG_WARNING, "[obs-scene-switcher] EventSub session reconnect requested");
-			handleSessionReconnect(json);
-		} else if (type == "notification") {
-			handleNotification(json);
-		} else if (type == "session_keepalive") {
-			// 必要ならログ
-		} else if (type == "revocation") {
-			blog(LOG_WARNING, "[obs-scene-switcher] EventSub subscription revoked");
-		} else {
-			// 他の message_type は無視
+	// メッセージ種別ごとに書式化せずトレースへ記録（keepalive を含め毎回通る）
+	SS_TRACE_DEBUG(trace::Event::EventSubMessage, static_cast<int64_t>(message.type),
+		       static_cast<int64_t>(msg.size()));
+
+	switch (message.type) {
+	case EventSubMessage::Type::SessionWelcome:
+		blog(LOG_DEBUG, "[obs-scene-switcher][EventSub] Received session_welcome");
+		if (const auto sent = parseRfc3339Micros(message.messageTimestamp))
+			serverClock_.observe(*sent, receivedMicros);
+		handleSessionWelcome(message);
+		break;
+
+	case EventSubMessage::Type::SessionReconnect:
+		// ここで start/stop しない（フラグ立てて close 側で繋ぎ直す）
+		blog(LOG_WARNING, "[obs-scene-switcher] EventSub session reconnect requested");
+		handleSessionReconnect(message);
+		break;
+
+	case EventSubMessage::Type::Notification:
+		// 再接続・再送で同じ通知が届くことがあるため message_id で重複を除く
+		if (!message.messageId.empty() && !rememberMessageId(message.messageId)) {
+			metrics::Registry::instance().redemptionsDeduplicated.inc();
+			return;
 		}
-
-	} catch (const json::parse_error &e) {
-		// "JSON parse error"の理由が分かるようにログ改善
-		blog(LOG_ERROR, "[obs-scene-switcher] EventSub JSON parse error: %s", e.what());
-	} catch (const std::exception &e) {
-		blog(LOG_ERROR, "[obs-scene-switcher] EventSub exception while handling message: %s", e.what());
+		handleNotification(message, receivedMicros);
+		break;
+
+	case EventSubMessage::Type::SessionKeepalive:
+		// 時計のずれの標本にする（通知がなくても約 10 秒ごとに届く）
+		if (const auto sent = parseRfc3339Micros(message.messageTimestamp))
+			serverClock_.observe(*sent, receivedMicros);
+		break;
+
+	case EventSubMessage::Type::Revocation:
+		subscriptions_.onRevoked(message);
+		break;
+
+	default:
+		// 他の message_type は無視
+		break;
 	}
 }
 
-void EventSubClient::handleSessionWelcome(const json &json)
+void EventSubClient::handleSessionWelcome(const EventSubMessage &message)
 {
-	const std::string sessionId = json["payload"]["session"].value("id", "");
-	blog(LOG_DEBUG, "[obs-scene-switcher][EventSub] session_id = %s", sessionId.c_str());
+	blog(LOG_DEBUG, "[obs-scene-switcher][EventSub] session_id = %s", message.sessionId.c_str());
 
-	ensureSubscription(sessionId);
+	subscriptions_.arm(message.sessionId, migrating_.exchange(false));
 }
 
-void EventSubClient::handleSessionReconnect(const json &json)
+void EventSubClient::handleSessionReconnect(const EventSubMessage &message)
 {
-	const std::string reconnectUrl = json["payload"]["session"].value("reconnect_url", "");
+	const std::string &reconnectUrl = message.reconnectUrl;
 	if (reconnectUrl.empty()) {
 		blog(LOG_ERROR, "[obs-scene-switcher] EventSub session_reconnect missing reconnect_url");
 		return;
@@ -305,24 +285,79 @@ void EventSubClient::handleSessionReconnect(const json &json)
 	websocket_.close();
 }
 
-void EventSubClient::handleNotification(const json &json)
+void EventSubClient::handleNotification(const EventSubMessage &message, int64_t receivedMicros)
 {
-	// redemption 通知の取り出し
-	try {
-		const auto &event = json["payload"]["event"];
+	if (!message.event) {
+		blog(LOG_DEBUG, "[obs-scene-switcher][EventSub] Ignoring notification of type %s",
+		     message.subscriptionType.c_str());
+		return;
+	}
+
+	const TwitchEvent &event = *message.event;
+	const int64_t kind = static_cast<int64_t>(event.index());
+
+	std::visit(
+		[kind](const auto &e) {
+			using T = std::decay_t<decltype(e)>;
+			if constexpr (std::is_same_v<T, RedemptionEvent>) {
+				blog(LOG_INFO, "[obs-scene-switcher] Channel point redeemed: reward_id=%s user=%s",
+				     e.rewardId.c_str(), e.userName.c_str());
+				SS_TRACE_INFO(trace::Event::EventSubNotification, kind,
+					      static_cast<int64_t>(e.userInput.size()), 0, e.rewardId);
+			} else if constexpr (std::is_same_v<T, CheerEvent>) {
+				blog(LOG_INFO, "[obs-scene-switcher] Cheer: %d bits from %s", e.bits,
+				     e.anonymous ? "(anonymous)" : e.userName.c_str());
+				SS_TRACE_INFO(trace::Event::EventSubNotification, kind, e.bits, 0, e.userName);
+			} else if constexpr (std::is_same_v<T, SubscribeEvent>) {
+				blog(LOG_INFO, "[obs-scene-switcher] Subscription: %s (tier %s%s)", e.userName.c_str(),
+				     e.tier.c_str(), e.isGift ? ", gift" : "");
+				SS_TRACE_INFO(trace::Event::EventSubNotification, kind, 0, 0, e.userName);
+			} else if constexpr (std::is_same_v<T, RaidEvent>) {
+				blog(LOG_INFO, "[obs-scene-switcher] Raid from %s with %d viewers", e.fromUserName.c_str(),
+				     e.viewers);
+				SS_TRACE_INFO(trace::Event::EventSubNotification, kind, e.viewers, 0, e.fromUserName);
+			} else if constexpr (std::is_same_v<T, FollowEvent>) {
+				blog(LOG_INFO, "[obs-scene-switcher] Follow: %s", e.userName.c_str());
+				SS_TRACE_INFO(trace::Event::EventSubNotification, kind, 0, 0, e.userName);
+			}
+		},
+		event);
+
+	const qint64 ageMs = eventAgeMs(message, receivedMicros);
+	if (ageMs >= 0)
+		metrics::Registry::instance().eventAge.record(static_cast<uint64_t>(ageMs) * 1000);
 
-		const std::string rewardId = event["reward"].value("id", "");
-		const std::string userName = event.value("user_name", "");
-		const std::string userInput = event.value("user_input", "");
+	emit eventReceived(event, ageMs);
+}
+
+qint64 EventSubClient::eventAgeMs(const EventSubMessage &message, int64_t receivedMicros) const
+{
+	// 発生時刻（redeemed_at など）と送信時刻のうち古いほうから数える（再送された通知は送信時刻が新しい）
+	std::optional<int64_t> origin = parseRfc3339Micros(message.eventTimestamp);
+	if (const auto sent = parseRfc3339Micros(message.messageTimestamp))
+		origin = origin ? std::min(*origin, *sent) : *sent;
+	if (!origin)
+		return -1;
+
+	const auto age = serverClock_.ageMicros(*origin, receivedMicros);
+	return age ? static_cast<qint64>(*age / 1000) : -1;
+}
 
-		blog(LOG_INFO, "[obs-scene-switcher] Channel point redeemed: reward_id=%s user=%s", 
-		     rewardId.c_str(), userName.c_str());
+bool EventSubClient::rememberMessageId(const std::string &messageId)
+{
+	// WebSocket のメッセージコールバック（単一スレッド）からのみ呼ばれる
+	if (recentMessageIdSet_.count(messageId))
+		return false;
 
-		emit redemptionReceived(rewardId, userName, userInput);
+	recentMessageIds_.push_back(messageId);
+	recentMessageIdSet_.insert(messageId);
 
-	} catch (const std::exception &e) {
-		blog(LOG_ERROR, "[obs-scene-switcher] Failed to parse EventSub notification payload: %s", e.what());
+	if (recentMessageIds_.size() > kRecentMessageIds) {
+		recentMessageIdSet_.erase(recentMessageIds_.front());
+		recentMessageIds_.pop_front();
 	}
+
+	return true;
 }
 
 int EventSubClient::calculateBackoffMs() const
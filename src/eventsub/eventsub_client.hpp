@@ -9,7 +9,12 @@
 #include <mutex>
 #include <thread>
 #include <chrono>
+#include <deque>
+#include <unordered_set>
 #include <nlohmann/json.hpp>
+#include "core/eventsub_parser.hpp"
+#include "core/server_clock.hpp"
+#include "subscription_manager.hpp"
 
 #include <ixwebsocket/IXWebSocket.h>
 #include <ixwebsocket/IXNetSystem.h>
@@ -26,9 +31,19 @@ public:
 	void stop();
 
 	bool isRunning() const { return running_; }
+	// 接続済みで、すべてのサブスクリプションが揃っている（通知を受けられる）
+	bool isArmed() const { return running_ && subscriptions_.isArmed(); }
+
+	// 購読するイベントの種類（引き換えは常に含める）。接続中なら同じセッションに追加で購読する
+	void setEventKinds(const std::vector<EventKind> &kinds);
 
 signals:
-	void redemptionReceived(const std::string &rewardId, const std::string &userName, const std::string &userInput);
+	// 引き換え・Bits・サブスク・レイド・フォローの通知（同じ WebSocket に多重化）。WebSocket のスレッドで emit する
+	// ageMs は発生から受信までの推定時間（推定できなければ -1）
+	void eventReceived(const TwitchEvent &event, qint64 ageMs);
+
+	// セッションのサブスクリプションがすべて揃った（ネットワークスレッドなどから emit する）
+	void subscriptionsArmed();
 
 private:
 	EventSubClient();
@@ -37,9 +52,6 @@ private:
 	EventSubClient(const EventSubClient &) = delete;
 	EventSubClient &operator=(const EventSubClient &) = delete;
 
-	nlohmann::json httpGet(const std::string &url);
-	bool httpPost(const std::string &body);
-
 	// 接続関連
 	void setupHandlers();
 	void connectSocket(const std::string &url = {});
@@ -47,12 +59,18 @@ private:
 
 	// 受信処理
 	void handleMessage(const std::string &msg);
-	void handleSessionWelcome(const nlohmann::json &j);
-	void handleSessionReconnect(const nlohmann::json &j);
-	void handleNotification(const nlohmann::json &j);
+	void handleSessionWelcome(const EventSubMessage &message);
+	void handleSessionReconnect(const EventSubMessage &message);
+	void handleNotification(const EventSubMessage &message, int64_t receivedMicros);
+
+	// 未処理の message_id なら記録して true を返す（重複なら false）
+	bool rememberMessageId(const std::string &messageId);
 
-	// Subscription
-	void ensureSubscription(const std::string &sessionId);
+	// 通知の発生から受信までの推定時間（推定できなければ -1）
+	qint64 eventAgeMs(const EventSubMessage &message, int64_t receivedMicros) const;
+
+	// Subscription（作成・revocation 後の作り直し）
+	SubscriptionManager subscriptions_;
 
 	// WebSocket
 	ix::WebSocket websocket_;
@@ -74,6 +92,15 @@ private:
 	std::mutex reconnectMutex_;
 	std::string pendingReconnectUrl_;
 	std::atomic<bool> reconnectRequested_{false};
+	// reconnect_url へ移った接続（次の session_welcome はサブスクリプションを引き継ぐ）
+	std::atomic<bool> migrating_{false};
+
+	// サーバーとの時計のずれ（welcome / keepalive の message_timestamp から推定）
+	ServerClock serverClock_;
+
+	// 重複通知の検出（直近の message_id のみ保持）
+	std::deque<std::string> recentMessageIds_;
+	std::unordered_set<std::string> recentMessageIdSet_;
 
 	// 再接続バックオフ制御
 	std::atomic<int> reconnectAttempts_{0};
@@ -0,0 +1,293 @@
+// obs-scene-switcher plugin
+// Copyright (C) 2025 ksmksks
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "subscription_manager.hpp"
+#include "core/metrics.hpp"
+#include "net/network.hpp"
+#include <obs-module.h>
+#include <nlohmann/json.hpp>
+#include <algorithm>
+
+using json = nlohmann::json;
+
+static constexpr const char *kHelixHost = "api.twitch.tv";
+static constexpr const char *kSubscriptionsPath = "/helix/eventsub/subscriptions";
+
+// 通信失敗・5xx の作成を再試行する回数
+static constexpr int kMaxCreateRetries = 1;
+
+// 作り直しても通らない revocation の理由
+static bool isPermanentRevocation(const std::string &status)
+{
+	return status == "authorization_revoked" || status == "user_removed" || status == "version_removed";
+}
+
+SubscriptionManager::SubscriptionManager(std::vector<Spec> specs) : specs_(std::move(specs)) {}
+
+void SubscriptionManager::setSpecs(std::vector<Spec> specs)
+{
+	std::vector<Spec> toCreate;
+	std::string sessionId;
+	uint64_t generation;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		specs_ = std::move(specs);
+
+		// 外した種類は数えない（サブスクリプション自体はセッション終了で消える）
+		for (auto it = active_.begin(); it != active_.end();) {
+			const bool wanted = std::any_of(specs_.begin(), specs_.end(),
+							[&](const Spec &spec) { return spec.type == it->first; });
+			it = wanted ? std::next(it) : active_.erase(it);
+		}
+
+		if (sessionId_.empty())
+			return;
+
+		armReported_ = active_.size() == specs_.size();
+		if (!armReported_) {
+			armStartedAt_ = Clock::now();
+			armRequests_ = 0;
+		}
+		toCreate = takeMissingLocked();
+		sessionId = sessionId_;
+		generation = generation_;
+	}
+
+	for (const auto &spec : toCreate)
+		create(spec, sessionId, generation, 0);
+}
+
+void SubscriptionManager::configure(const std::string &clientId, const std::string &accessToken,
+				    const std::string &broadcasterUserId)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	clientId_ = clientId;
+	accessToken_ = accessToken;
+	broadcasterUserId_ = broadcasterUserId;
+}
+
+HttpRequest SubscriptionManager::helixRequest(const std::string &method, const std::string &path) const
+{
+	HttpRequest req;
+	req.method = method;
+	req.host = kHelixHost;
+	req.path = path;
+	req.headers = {{"Client-ID", clientId_}, {"Authorization", "Bearer " + accessToken_}};
+	req.priority = RequestPriority::High;  // 遅れると通知を取りこぼすため、レート制限待ちでは最優先
+	req.latency = &metrics::Registry::instance().helixLatency;
+	return req;
+}
+
+void SubscriptionManager::arm(const std::string &sessionId, bool migrated)
+{
+	std::vector<Spec> toCreate;
+	uint64_t generation;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+
+		// session_reconnect 先のセッションにはサブスクリプションが引き継がれる
+		if (migrated && !sessionId_.empty() && active_.size() == specs_.size()) {
+			blog(LOG_INFO, "[obs-scene-switcher][EventSub] Session migrated, %zu subscriptions carried over",
+			     active_.size());
+			metrics::Registry::instance().eventsubSubscriptionsReused.inc(active_.size());
+			sessionId_ = sessionId;
+			generation_++;
+			return;
+		}
+
+		sessionId_ = sessionId;
+		generation_++;
+		active_.clear();
+		inFlight_.clear();
+		armStartedAt_ = Clock::now();
+		armRequests_ = 0;
+		armReported_ = false;
+
+		toCreate = takeMissingLocked();
+		generation = generation_;
+	}
+
+	for (const auto &spec : toCreate)
+		create(spec, sessionId, generation, 0);
+}
+
+std::vector<SubscriptionManager::Spec> SubscriptionManager::takeMissingLocked()
+{
+	std::vector<Spec> missing;
+
+	for (const auto &spec : specs_) {
+		if (active_.count(spec.type) || inFlight_.count(spec.type))
+			continue;
+
+		inFlight_.insert(spec.type);
+		missing.push_back(spec);
+	}
+
+	noteArmedLocked();
+	return missing;
+}
+
+void SubscriptionManager::create(const Spec &spec, const std::string &sessionId, uint64_t generation, int attempt)
+{
+	json body = {{"type", spec.type},
+		     {"version", spec.version},
+		     {"transport", {{"method", "websocket"}, {"session_id", sessionId}}}};
+
+	HttpRequest req;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		if (generation != generation_)
+			return;
+
+		json condition = json::object();
+		for (const auto &key : spec.conditionKeys)
+			condition[key] = broadcasterUserId_;
+		body["condition"] = condition;
+		req = helixRequest("POST", kSubscriptionsPath);
+		armRequests_++;
+	}
+	req.headers.emplace_back("Content-Type", "application/json");
+	req.body = body.dump();
+
+	// WebSocket のスレッドを止めないようにネットワークスレッドで送信する
+	Network::instance().request(std::move(req),
+				    [this, spec, sessionId, generation, attempt](const HttpResponse &res) {
+					    onCreated(spec, sessionId, generation, attempt, res);
+				    });
+}
+
+void SubscriptionManager::onCreated(const Spec &spec, const std::string &sessionId, uint64_t generation,
+				    int attempt, const HttpResponse &res)
+{
+	EventSubSubscriptionResponse response;
+	std::string error;
+	const bool parsed = res.error.empty() && parseSubscriptionResponse(res.body, response, error);
+
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		if (generation != generation_)
+			return;
+
+		// 作成（202）
+		if (res.ok() && parsed && !response.subscriptions.empty()) {
+			inFlight_.erase(spec.type);
+			active_[spec.type] = response.subscriptions.front().id;
+			metrics::Registry::instance().eventsubSubscriptionsCreated.inc();
+			blog(LOG_DEBUG, "[obs-scene-switcher][EventSub] Subscribed %s (cost %d/%d)", spec.type.c_str(),
+			     response.totalCost, response.maxTotalCost);
+			noteArmedLocked();
+			return;
+		}
+
+		// 同じ条件のサブスクリプションが既にある
+		if (res.status == 409) {
+			inFlight_.erase(spec.type);
+			active_[spec.type];
+			metrics::Registry::instance().eventsubSubscriptionsReused.inc();
+			blog(LOG_DEBUG, "[obs-scene-switcher][EventSub] Subscription %s already exists", spec.type.c_str());
+			noteArmedLocked();
+			return;
+		}
+
+		const bool retryable = !res.error.empty() || res.status >= 500;
+		if (!retryable || attempt >= kMaxCreateRetries) {
+			inFlight_.erase(spec.type);
+
+			// コスト上限・作成数の上限（429）、認証・スコープ（401/403）は再試行しても通らない
+			const char *message = res.error.empty() ? response.message.c_str() : res.error.c_str();
+			if (res.status == 429 || res.status == 400)
+				blog(LOG_ERROR,
+				     "[obs-scene-switcher] EventSub subscription %s rejected by limit (HTTP %d): %s",
+				     spec.type.c_str(), res.status, message);
+			else if (res.status == 401 || res.status == 403)
+				blog(LOG_ERROR,
+				     "[obs-scene-switcher] EventSub subscription %s not authorized (HTTP %d): %s",
+				     spec.type.c_str(), res.status, message);
+			else
+				blog(LOG_ERROR,
+				     "[obs-scene-switcher] Failed to create EventSub subscription %s (HTTP %d): %s",
+				     spec.type.c_str(), res.status, message);
+			return;
+		}
+	}
+
+	// 通信失敗・サーバーエラーは同じセッションのうちに再試行する
+	blog(LOG_WARNING, "[obs-scene-switcher] EventSub subscription %s failed (HTTP %d%s%s), retrying",
+	     spec.type.c_str(), res.status, res.error.empty() ? "" : ", ", res.error.c_str());
+	create(spec, sessionId, generation, attempt + 1);
+}
+
+void SubscriptionManager::noteArmedLocked()
+{
+	if (armReported_ || active_.size() != specs_.size())
+		return;
+
+	armReported_ = true;
+	const auto elapsedMs =
+		std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - armStartedAt_).count();
+	blog(LOG_INFO, "[obs-scene-switcher][EventSub] Armed %zu subscriptions in %lld ms (%d requests)",
+	     active_.size(), static_cast<long long>(elapsedMs), armRequests_);
+
+	if (onArmed_)
+		onArmed_();
+}
+
+void SubscriptionManager::onRevoked(const EventSubMessage &message)
+{
+	metrics::Registry::instance().eventsubRevocations.inc();
+
+	std::vector<Spec> toCreate;
+	std::string sessionId;
+	uint64_t generation;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+
+		auto it = active_.find(message.subscriptionType);
+		if (it != active_.end())
+			active_.erase(it);
+		armReported_ = false;
+
+		if (isPermanentRevocation(message.subscriptionStatus)) {
+			blog(LOG_ERROR, "[obs-scene-switcher] EventSub subscription %s revoked (%s); log in again to restore",
+			     message.subscriptionType.c_str(), message.subscriptionStatus.c_str());
+			return;
+		}
+
+		blog(LOG_WARNING, "[obs-scene-switcher] EventSub subscription %s revoked (%s), resubscribing",
+		     message.subscriptionType.c_str(), message.subscriptionStatus.c_str());
+
+		if (sessionId_.empty())
+			return;
+
+		armStartedAt_ = Clock::now();
+		armRequests_ = 0;
+		toCreate = takeMissingLocked();
+		sessionId = sessionId_;
+		generation = generation_;
+	}
+
+	for (const auto &spec : toCreate)
+		create(spec, sessionId, generation, 0);
+}
+
+void SubscriptionManager::reset()
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	sessionId_.clear();
+	generation_++;
+	active_.clear();
+	inFlight_.clear();
+}
+
+bool SubscriptionManager::isArmed() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return !sessionId_.empty() && active_.size() == specs_.size();
+}
+
+void SubscriptionManager::setArmedCallback(std::function<void()> callback)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	onArmed_ = std::move(callback);
+}
@@ -0,0 +1,83 @@
+// obs-scene-switcher plugin
+// Copyright (C) 2025 ksmksks
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+#include "core/eventsub_parser.hpp"
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+struct HttpRequest;
+struct HttpResponse;
+
+/**
+ * EventSub サブスクリプションの管理
+ *
+ * - WebSocket のサブスクリプションは作ったセッションにしか結び付かないため、session_welcome ごとに
+ *   一覧せずに作る（既にあれば 409 を購読済みとして扱う）。session_reconnect で移ったセッションは
+ *   サブスクリプションが引き継がれるため何も送らない
+ * - 作成の応答を解釈する（409 は既存として扱い、コスト上限・認証エラーは再試行しない）
+ * - revocation では理由に応じて作り直す
+ * - WebSocket のスレッドとネットワークスレッドから呼ばれる（内部で排他する）
+ */
+class SubscriptionManager {
+public:
+	using Clock = std::chrono::steady_clock;
+
+	struct Spec {
+		std::string type;
+		std::string version;
+		std::vector<std::string> conditionKeys;  // 配信者 ID を入れる condition のキー
+	};
+
+	explicit SubscriptionManager(std::vector<Spec> specs = {});
+
+	// 購読する種類を差し替える（接続中なら足りない分をすぐ作る。不要になった分は次のセッションで外れる）
+	void setSpecs(std::vector<Spec> specs);
+
+	void configure(const std::string &clientId, const std::string &accessToken,
+		       const std::string &broadcasterUserId);
+
+	// session_welcome（migrated: session_reconnect で移ったセッション）
+	void arm(const std::string &sessionId, bool migrated);
+	void onRevoked(const EventSubMessage &message);
+	// 停止時。以降に届いた応答は無視する
+	void reset();
+
+	bool isArmed() const;
+	// すべてのサブスクリプションが揃ったとき（セッションごとに 1 回）。ロック中に呼ぶため、通知を積むだけにすること
+	void setArmedCallback(std::function<void()> callback);
+
+private:
+	HttpRequest helixRequest(const std::string &method, const std::string &path) const;
+
+	// 未作成のサブスクリプションを選び、inFlight_ に載せる
+	std::vector<Spec> takeMissingLocked();
+	void create(const Spec &spec, const std::string &sessionId, uint64_t generation, int attempt);
+	void onCreated(const Spec &spec, const std::string &sessionId, uint64_t generation, int attempt,
+		       const HttpResponse &res);
+	void noteArmedLocked();
+
+	mutable std::mutex mutex_;
+	std::vector<Spec> specs_;
+	std::string clientId_;
+	std::string accessToken_;
+	std::string broadcasterUserId_;
+
+	std::string sessionId_;
+	uint64_t generation_ = 0;                            // セッション切替・停止で進める
+	std::unordered_map<std::string, std::string> active_;  // type → subscription id（409 なら空）
+	std::unordered_set<std::string> inFlight_;            // 作成中の type
+
+	// セッションが揃うまでの時間と要求数
+	Clock::time_point armStartedAt_;
+	int armRequests_ = 0;
+	bool armReported_ = false;
+	std::function<void()> onArmed_;
+};
@@ -0,0 +1,469 @@
+// obs-scene-switcher plugin
+// Copyright (C) 2025 ksmksks
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "network.hpp"
+#include "../core/executor.hpp"
+#include "../core/metrics.hpp"
+
+#include <obs-module.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <optional>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <wininet.h>
+#pragma comment(lib, "Wininet.lib")
+#endif
+
+// 同時に通信するリクエスト数（Helix と OAuth、更新確認が重なる程度）
+static constexpr size_t kNetworkThreads = 2;
+
+// 接続・送受信のタイムアウト
+static constexpr unsigned long kTimeoutMs = 10000;
+
+// Helix のレート制限（アプリアクセストークン・ユーザートークンとも 800 ポイント/分）
+static const char *kHelixHost = "api.twitch.tv";
+static constexpr double kHelixBucketPoints = 800;
+static constexpr std::chrono::milliseconds kHelixBucketRefill{60000};
+// 429 応答を再送する回数と、リセット時刻が分からない場合の待ち時間
+static constexpr int kMaxRateLimitRetries = 3;
+static constexpr std::chrono::milliseconds kRateLimitFallbackBackoff{1000};
+
+static std::string toLower(std::string s)
+{
+	std::transform(s.begin(), s.end(), s.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+	return s;
+}
+
+std::string HttpResponse::header(const std::string &name) const
+{
+	auto it = headers.find(toLower(name));
+	return it != headers.end() ? it->second : std::string();
+}
+
+Network &Network::instance()
+{
+	static Network inst;
+	return inst;
+}
+
+static bool isHelix(const HttpRequest &request)
+{
+	return request.host == kHelixHost;
+}
+
+Network::Network() : helixLimiter_(kHelixBucketPoints, kHelixBucketRefill) {}
+
+Network::~Network()
+{
+	stop();
+}
+
+void Network::start()
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	if (executor_)
+		return;
+
+#ifdef _WIN32
+	// セッションは 1 つだけ開き、接続は WinINet のキープアライブで使い回す
+	HINTERNET session = InternetOpenA("obs-scene-switcher", INTERNET_OPEN_TYPE_PRECONFIG, NULL, NULL, 0);
+	if (!session) {
+		blog(LOG_ERROR, "[obs-scene-switcher][Network] InternetOpenA failed");
+		return;
+	}
+
+	DWORD timeout = kTimeoutMs;
+	InternetSetOptionA(session, INTERNET_OPTION_CONNECT_TIMEOUT, &timeout, sizeof(timeout));
+	InternetSetOptionA(session, INTERNET_OPTION_SEND_TIMEOUT, &timeout, sizeof(timeout));
+	InternetSetOptionA(session, INTERNET_OPTION_RECEIVE_TIMEOUT, &timeout, sizeof(timeout));
+	session_ = session;
+#endif
+
+	executor_ = std::make_unique<Executor>(kNetworkThreads, "network");
+	dispatcher_ = std::thread(&Network::dispatchLoop, this);
+	blog(LOG_DEBUG, "[obs-scene-switcher][Network] Started");
+}
+
+void Network::stop(std::chrono::milliseconds drainTimeout)
+{
+	std::unique_ptr<Executor> executor;
+	std::thread dispatcher;
+	{
+		std::unique_lock<std::mutex> lock(mutex_);
+		if (!executor_)
+			return;
+
+		// 待ち行列と通信中の要求が空になるまで（最長 drainTimeout）送らせてから止める
+		if (drainTimeout.count() > 0) {
+			const auto idle = [this]() { return helixQueue_.empty() && activeRequests_ == 0; };
+			if (!idleCv_.wait_for(lock, drainTimeout, idle))
+				blog(LOG_WARNING,
+				     "[obs-scene-switcher][Network] Stopping with %zu queued and %zu active requests unsent",
+				     helixQueue_.size(), activeRequests_);
+		}
+
+		executor = std::move(executor_);
+
+#ifdef _WIN32
+		// 通信中のリクエストハンドルを閉じると、ブロック中の WinINet 呼び出しはすぐに失敗して戻る
+		for (void *handle : inFlight_)
+			InternetCloseHandle(static_cast<HINTERNET>(handle));
+#endif
+		inFlight_.clear();
+
+		// 相乗り待ちのコールバックも呼ばない
+		flights_.clear();
+		cache_.clear();
+		helixQueue_.clear();
+		dispatcher = std::move(dispatcher_);
+	}
+
+	helixCv_.notify_all();
+	if (dispatcher.joinable())
+		dispatcher.join();
+
+	// 未着手のリクエストは破棄し、実行中のものは中断された通信の後始末を待つ
+	executor->shutdown();
+
+	std::lock_guard<std::mutex> lock(mutex_);
+#ifdef _WIN32
+	if (session_)
+		InternetCloseHandle(static_cast<HINTERNET>(session_));
+#endif
+	session_ = nullptr;
+	// 破棄された未着手のタスクは完了を数えない
+	activeRequests_ = 0;
+
+	blog(LOG_DEBUG, "[obs-scene-switcher][Network] Stopped");
+}
+
+bool Network::isRunning() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return executor_ != nullptr;
+}
+
+void Network::request(HttpRequest request, Completion done)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	if (!executor_) {
+		blog(LOG_DEBUG, "[obs-scene-switcher][Network] Dropped %s %s%s (not running)", request.method.c_str(),
+		     request.host.c_str(), request.path.c_str());
+		return;
+	}
+
+	dispatchLocked(std::move(request), std::move(done));
+}
+
+void Network::requestShared(HttpRequest request, std::chrono::milliseconds cacheTtl, Completion done)
+{
+	const std::string key = sharedKey(request);
+	const auto now = std::chrono::steady_clock::now();
+
+	std::lock_guard<std::mutex> lock(mutex_);
+	if (!executor_) {
+		blog(LOG_DEBUG, "[obs-scene-switcher][Network] Dropped %s %s%s (not running)", request.method.c_str(),
+		     request.host.c_str(), request.path.c_str());
+		return;
+	}
+
+	for (auto it = cache_.begin(); it != cache_.end();) {
+		if (it->second.expiresAt <= now)
+			it = cache_.erase(it);
+		else
+			++it;
+	}
+
+	// キャッシュ済みでも完了コールバックはネットワークスレッドで呼ぶ（request() と同じ）
+	auto cached = cache_.find(key);
+	if (cached != cache_.end()) {
+		metrics::Registry::instance().helixCacheHits.inc();
+		executor_->post([this, response = cached->second.response, done = std::move(done)]() {
+			if (isRunning() && done)
+				done(response);
+		});
+		return;
+	}
+
+	auto flight = flights_.find(key);
+	if (flight != flights_.end()) {
+		metrics::Registry::instance().helixCoalesced.inc();
+		flight->second.push_back(std::move(done));
+		return;
+	}
+
+	flights_[key].push_back(std::move(done));
+
+	dispatchLocked(std::move(request), [this, key, cacheTtl](const HttpResponse &response) {
+		std::vector<Completion> waiters;
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			auto it = flights_.find(key);
+			if (it != flights_.end()) {
+				waiters = std::move(it->second);
+				flights_.erase(it);
+			}
+			if (response.ok() && cacheTtl.count() > 0)
+				cache_[key] = CachedResponse{response, std::chrono::steady_clock::now() + cacheTtl};
+		}
+
+		for (const auto &waiter : waiters) {
+			if (waiter)
+				waiter(response);
+		}
+	});
+}
+
+void Network::dispatchLocked(HttpRequest request, Completion onResponse)
+{
+	QueuedRequest queued;
+	queued.request = std::move(request);
+	queued.onResponse = std::move(onResponse);
+
+	if (isHelix(queued.request)) {
+		queued.sequence = ++helixSequence_;
+		enqueueHelixLocked(std::move(queued));
+		return;
+	}
+
+	postLocked(std::move(queued));
+}
+
+void Network::enqueueHelixLocked(QueuedRequest queued)
+{
+	const auto key = std::make_pair(static_cast<int>(queued.request.priority), queued.sequence);
+	helixQueue_.emplace(key, std::move(queued));
+	helixCv_.notify_one();
+}
+
+void Network::postLocked(QueuedRequest queued)
+{
+	// 完了コールバック（続きの要求を積むことがある）まで終えてから完了として数える
+	struct ActiveRequest {
+		Network *self;
+		~ActiveRequest()
+		{
+			std::lock_guard<std::mutex> lock(self->mutex_);
+			if (self->activeRequests_ > 0)
+				self->activeRequests_--;
+			self->idleCv_.notify_all();
+		}
+	};
+
+	activeRequests_++;
+	const bool posted = executor_->post([this, queued = std::move(queued)]() mutable {
+		const ActiveRequest active{this};
+		const HttpResponse response = perform(queued.request);
+
+		if (isHelix(queued.request)) {
+			std::lock_guard<std::mutex> lock(mutex_);
+			if (!executor_)
+				return;
+
+			applyRateLimitLocked(response);
+
+			// 制限超過はリセット後に同じ順位で送り直す
+			if (response.status == 429 && queued.rateLimitRetries < kMaxRateLimitRetries) {
+				queued.rateLimitRetries++;
+				enqueueHelixLocked(std::move(queued));
+				return;
+			}
+		}
+
+		// 停止で中断されたリクエストの後続処理は行わない
+		if (!isRunning())
+			return;
+		if (queued.onResponse)
+			queued.onResponse(response);
+	});
+	if (!posted)
+		activeRequests_--;
+}
+
+void Network::applyRateLimitLocked(const HttpResponse &response)
+{
+	const auto now = RateLimiter::Clock::now();
+	const std::string limit = response.header("Ratelimit-Limit");
+	const std::string remaining = response.header("Ratelimit-Remaining");
+	const std::string reset = response.header("Ratelimit-Reset");
+	const auto resetAt = reset.empty() ? now : RateLimiter::fromUnixSeconds(std::atoll(reset.c_str()));
+
+	if (!remaining.empty())
+		helixLimiter_.updateFromServer(std::atoi(limit.c_str()), std::atoi(remaining.c_str()), resetAt, now);
+
+	if (response.status == 429) {
+		const auto until = resetAt > now ? resetAt : now + kRateLimitFallbackBackoff;
+		helixLimiter_.pauseUntil(until);
+		metrics::Registry::instance().helixRateLimited.inc();
+
+		blog(LOG_WARNING, "[obs-scene-switcher][Network] Helix rate limit exceeded, pausing for %lld ms",
+		     (long long)std::chrono::duration_cast<std::chrono::milliseconds>(until - now).count());
+	}
+
+	helixCv_.notify_one();
+}
+
+void Network::dispatchLoop()
+{
+	std::unique_lock<std::mutex> lock(mutex_);
+	while (executor_) {
+		if (helixQueue_.empty()) {
+			helixCv_.wait(lock);
+			continue;
+		}
+
+		// バケットが空ならリセット（または 1 ポイント補充）まで待つ。待機中も優先度の高い要求が先頭に入る
+		const auto now = RateLimiter::Clock::now();
+		if (!helixLimiter_.tryAcquire(now)) {
+			metrics::Registry::instance().helixThrottled.inc();
+			helixCv_.wait_until(lock, helixLimiter_.nextAvailable(now));
+			continue;
+		}
+
+		auto node = helixQueue_.extract(helixQueue_.begin());
+		postLocked(std::move(node.mapped()));
+	}
+}
+
+void Network::invalidateCache()
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	cache_.clear();
+}
+
+std::string Network::sharedKey(const HttpRequest &request)
+{
+	// ヘッダ（認証トークンを含む）もキーに含め、別アカウントの応答を共有しない
+	std::string key = request.method + ' ' + request.host + request.path;
+	for (const auto &[name, value] : request.headers) {
+		key += '\n';
+		key += toLower(name);
+		key += ':';
+		key += value;
+	}
+	return key;
+}
+
+#ifdef _WIN32
+
+static void parseRawHeaders(const std::string &raw, HttpResponse &response)
+{
+	size_t pos = 0;
+	while (pos < raw.size()) {
+		size_t end = raw.find("\r\n", pos);
+		if (end == std::string::npos)
+			end = raw.size();
+
+		const std::string line = raw.substr(pos, end - pos);
+		const size_t colon = line.find(':');
+		if (colon != std::string::npos) {
+			size_t valueStart = colon + 1;
+			while (valueStart < line.size() && line[valueStart] == ' ')
+				++valueStart;
+			response.headers[toLower(line.substr(0, colon))] = line.substr(valueStart);
+		}
+		pos = end + 2;
+	}
+}
+
+HttpResponse Network::perform(const HttpRequest &request)
+{
+	HttpResponse response;
+
+	HINTERNET session = nullptr;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		session = static_cast<HINTERNET>(session_);
+	}
+	if (!session) {
+		response.error = "network not started";
+		return response;
+	}
+
+	HINTERNET hConnect = InternetConnectA(session, request.host.c_str(), INTERNET_DEFAULT_HTTPS_PORT, NULL, NULL,
+					      INTERNET_SERVICE_HTTP, 0, 0);
+	if (!hConnect) {
+		response.error = "InternetConnectA failed";
+		return response;
+	}
+
+	HINTERNET hRequest = HttpOpenRequestA(hConnect, request.method.c_str(), request.path.c_str(), NULL, NULL, NULL,
+					      INTERNET_FLAG_SECURE | INTERNET_FLAG_NO_CACHE_WRITE | INTERNET_FLAG_RELOAD,
+					      0);
+	if (!hRequest) {
+		InternetCloseHandle(hConnect);
+		response.error = "HttpOpenRequestA failed";
+		return response;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		inFlight_.insert(hRequest);
+	}
+
+	std::string headers;
+	for (const auto &[name, value] : request.headers)
+		headers += name + ": " + value + "\r\n";
+
+	{
+		std::optional<metrics::ScopedLatency> latency;
+		if (request.latency)
+			latency.emplace(*request.latency);
+
+		if (HttpSendRequestA(hRequest, headers.c_str(), (DWORD)headers.size(),
+				     request.body.empty() ? NULL : (LPVOID)request.body.data(), (DWORD)request.body.size())) {
+			DWORD status = 0;
+			DWORD len = sizeof(status);
+			if (HttpQueryInfoA(hRequest, HTTP_QUERY_STATUS_CODE | HTTP_QUERY_FLAG_NUMBER, &status, &len, NULL))
+				response.status = static_cast<int>(status);
+
+			len = 0;
+			HttpQueryInfoA(hRequest, HTTP_QUERY_RAW_HEADERS_CRLF, NULL, &len, NULL);
+			if (len > 0) {
+				std::string raw(len, '\0');
+				if (HttpQueryInfoA(hRequest, HTTP_QUERY_RAW_HEADERS_CRLF, raw.data(), &len, NULL)) {
+					raw.resize(len);
+					parseRawHeaders(raw, response);
+				}
+			}
+
+			char buffer[8192];
+			DWORD read = 0;
+			while (InternetReadFile(hRequest, buffer, sizeof(buffer), &read) && read > 0)
+				response.body.append(buffer, read);
+		} else {
+			response.error = "HttpSendRequestA failed (" + std::to_string(GetLastError()) + ")";
+		}
+	}
+
+	// stop() が先に閉じたハンドルは二重に閉じない
+	bool owned = false;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		owned = inFlight_.erase(hRequest) > 0;
+	}
+	if (owned)
+		InternetCloseHandle(hRequest);
+	else if (response.error.empty())
+		response.error = "cancelled";
+	InternetCloseHandle(hConnect);
+
+	return response;
+}
+
+#else
+
+HttpResponse Network::perform(const HttpRequest &)
+{
+	// Windows 以外では未実装
+	HttpResponse response;
+	response.error = "not supported on this platform";
+	return response;
+}
+
+#endif
@@ -0,0 +1,142 @@
+// obs-scene-switcher plugin
+// Copyright (C) 2025 ksmksks
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+#include "../core/rate_limiter.hpp"
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+class Executor;
+class LatencyHistogram;
+
+// Helix のレート制限待ちで先に送る順（High が最優先）
+enum class RequestPriority {
+	High,   // EventSub のサブスクリプション作成など、遅れると通知を取りこぼすもの
+	Normal,
+	Low,    // 報酬一覧の更新など、後回しにできるもの
+};
+
+struct HttpRequest {
+	std::string method = "GET";
+	std::string host;
+	std::string path;
+	std::vector<std::pair<std::string, std::string>> headers;
+	std::string body;
+	RequestPriority priority = RequestPriority::Normal;
+
+	// 送信から応答の読み終わりまでを記録するヒストグラム（任意）
+	LatencyHistogram *latency = nullptr;
+};
+
+struct HttpResponse {
+	int status = 0;
+	std::unordered_map<std::string, std::string> headers; // キーは小文字
+	std::string body;
+	std::string error; // 通信自体に失敗した場合のみ設定
+
+	bool ok() const { return error.empty() && status >= 200 && status < 300; }
+
+	// ヘッダ値（名前は大文字小文字を区別しない。なければ空文字列）
+	std::string header(const std::string &name) const;
+};
+
+/**
+ * ネットワーク I/O の実行器
+ *
+ * - Helix / OAuth / GitHub への HTTP 通信はすべてここの小さなスレッドプールで行う
+ *   （OBS・Qt のスレッドはネットワークを待たない）
+ * - request() の完了コールバックはネットワークスレッドで呼ばれる。UI に反映する場合は
+ *   呼び出し側で QMetaObject::invokeMethod(..., Qt::QueuedConnection) を使う
+ * - 複数段の処理（コード交換 → ユーザー情報取得、更新 → 再試行など）は完了コールバックから
+ *   次の request() を呼んでつなげる
+ * - stop() は通信中のリクエストを中断し、未着手のリクエストを破棄する。以降のコールバックは呼ばれない。
+ *   drainTimeout を渡すと、その間は積まれている要求（終了時の状態更新など）を送り終えるのを待つ
+ * - requestShared() は同一の要求をまとめる（実行中の要求への相乗りと、成功応答の短時間キャッシュ）
+ * - Helix（api.twitch.tv）への要求はすべて共有のトークンバケットを通す。Ratelimit-* ヘッダに追従し、
+ *   残量がなければ優先度順に待たせ、429 応答はリセット時刻まで止めてから再送する
+ */
+class Network {
+public:
+	using Completion = std::function<void(const HttpResponse &)>;
+
+	static Network &instance();
+
+	void start();
+	void stop(std::chrono::milliseconds drainTimeout = std::chrono::milliseconds(0));
+
+	bool isRunning() const;
+
+	void request(HttpRequest request, Completion done);
+
+	// 冪等な GET 用。メソッド・ホスト・パス・ヘッダが同じ要求は 1 回の通信にまとめる
+	// - 実行中の同一要求があれば新たに送らず、その応答を共有する
+	// - cacheTtl > 0 なら成功応答をその間保持し、期限内の要求には通信せずに返す
+	void requestShared(HttpRequest request, std::chrono::milliseconds cacheTtl, Completion done);
+	// 応答キャッシュを破棄する（実行中の要求はそのまま）
+	void invalidateCache();
+
+private:
+	Network();
+	~Network();
+
+	Network(const Network &) = delete;
+	Network &operator=(const Network &) = delete;
+
+	HttpResponse perform(const HttpRequest &request);
+
+	static std::string sharedKey(const HttpRequest &request);
+
+	struct QueuedRequest {
+		HttpRequest request;
+		Completion onResponse;
+		uint64_t sequence = 0;
+		int rateLimitRetries = 0;
+	};
+
+	// 以下は mutex_ を保持して呼ぶこと
+	void dispatchLocked(HttpRequest request, Completion onResponse);
+	void enqueueHelixLocked(QueuedRequest queued);
+	void postLocked(QueuedRequest queued);
+	void applyRateLimitLocked(const HttpResponse &response);
+
+	// Helix の待ち行列をレート制限に合わせて実行器へ流すスレッド
+	void dispatchLoop();
+
+	mutable std::mutex mutex_;
+	std::unique_ptr<Executor> executor_;
+
+	// WinINet のセッションと通信中のリクエストハンドル（stop() で閉じて中断する）
+	void *session_ = nullptr;
+	std::unordered_set<void *> inFlight_;
+
+	// requestShared(): 実行中の要求ごとの待ち合わせと、成功応答のキャッシュ
+	struct CachedResponse {
+		HttpResponse response;
+		std::chrono::steady_clock::time_point expiresAt;
+	};
+	std::unordered_map<std::string, std::vector<Completion>> flights_;
+	std::unordered_map<std::string, CachedResponse> cache_;
+
+	// Helix のレート制限（キー: 優先度・到着順）
+	RateLimiter helixLimiter_;
+	std::map<std::pair<int, uint64_t>, QueuedRequest> helixQueue_;
+	uint64_t helixSequence_ = 0;
+	std::condition_variable helixCv_;
+	std::thread dispatcher_;
+
+	// 実行器に渡して完了していない要求の数（stop() の待ち合わせ用）
+	size_t activeRequests_ = 0;
+	std::condition_variable idleCv_;
+};
@@ -3,75 +3,556 @@
 // SPDX-License-Identifier: GPL-2.0-or-later
 
 #include "http_server.hpp"
+#include "../core/executor.hpp"
+#include <obs-module.h>
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+
+#ifdef _WIN32
 #include <winsock2.h>
 #include <ws2tcpip.h>
 
 #pragma comment(lib, "Ws2_32.lib")
 
+using socket_t = SOCKET;
+using pollfd_t = WSAPOLLFD;
+static const socket_t kInvalidSocket = INVALID_SOCKET;
+
+static int pollSockets(pollfd_t *fds, size_t count, int timeoutMs)
+{
+	return WSAPoll(fds, static_cast<ULONG>(count), timeoutMs);
+}
+
+static void closeSocket(socket_t s)
+{
+	closesocket(s);
+}
+
+static bool setNonBlocking(socket_t s)
+{
+	u_long mode = 1;
+	return ioctlsocket(s, FIONBIO, &mode) == 0;
+}
+
+static bool wouldBlock()
+{
+	return WSAGetLastError() == WSAEWOULDBLOCK;
+}
+
+static int lastSocketError()
+{
+	return WSAGetLastError();
+}
+#else
+#include <arpa/inet.h>
+#include <cerrno>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using socket_t = int;
+using pollfd_t = struct pollfd;
+static const socket_t kInvalidSocket = -1;
+
+static int pollSockets(pollfd_t *fds, size_t count, int timeoutMs)
+{
+	return ::poll(fds, static_cast<nfds_t>(count), timeoutMs);
+}
+
+static void closeSocket(socket_t s)
+{
+	::close(s);
+}
+
+static bool setNonBlocking(socket_t s)
+{
+	const int flags = fcntl(s, F_GETFL, 0);
+	return flags >= 0 && fcntl(s, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+static bool wouldBlock()
+{
+	return errno == EAGAIN || errno == EWOULDBLOCK;
+}
+
+static int lastSocketError()
+{
+	return errno;
+}
+#endif
+
+// 無通信のまま接続を保持する最大時間
+static constexpr int kIdleTimeoutMs = 5000;
+// ヘッダ・本文の上限
+static constexpr size_t kMaxHeaderBytes = 8 * 1024;
+static constexpr size_t kMaxBodyBytes = 64 * 1024;
+// 同時接続数の上限（超過分は accept 後すぐに閉じる）
+static constexpr size_t kMaxConnections = 32;
+
+static constexpr uintptr_t kNoSocket = static_cast<uintptr_t>(kInvalidSocket);
+
+using SteadyClock = std::chrono::steady_clock;
+
+struct HttpServer::Connection {
+	enum class State {
+		Reading,
+		Dispatched,  // ハンドラの応答待ち
+		Writing,
+	};
+
+	uint64_t id = 0;
+	socket_t socket = kInvalidSocket;
+	State state = State::Reading;
+	std::string input;
+	std::string output;
+	size_t written = 0;
+	SteadyClock::time_point deadline;
+	bool closed = false;
+
+	void touch() { deadline = SteadyClock::now() + std::chrono::milliseconds(kIdleTimeoutMs); }
+};
+
+static const char *statusText(int status)
+{
+	switch (status) {
+	case 200:
+		return "OK";
+	case 400:
+		return "Bad Request";
+	case 404:
+		return "Not Found";
+	case 405:
+		return "Method Not Allowed";
+	case 413:
+		return "Payload Too Large";
+	case 431:
+		return "Request Header Fields Too Large";
+	case 503:
+		return "Service Unavailable";
+	default:
+		return "Error";
+	}
+}
+
+static bool equalsIgnoreCase(const std::string &a, const char *b)
+{
+	size_t i = 0;
+	for (; i < a.size() && b[i]; ++i) {
+		if (std::tolower(static_cast<unsigned char>(a[i])) != std::tolower(static_cast<unsigned char>(b[i])))
+			return false;
+	}
+	return i == a.size() && b[i] == '\0';
+}
+
 HttpServer *HttpServer::instance()
 {
 	static HttpServer instance;
 	return &instance;
 }
 
+HttpServer::HttpServer() : listenSocket_(kNoSocket), wakeSocket_(kNoSocket) {}
+
+HttpServer::~HttpServer()
+{
+	stop();
+}
+
 void HttpServer::start(int port, std::function<void(const std::string &)> cb)
 {
+	serve(port, [this, cb](const std::string &, const std::string &target) {
+		Response res;
+
+		// GET /callback?code=XXXX
+		const std::string prefix = "/callback?code=";
+		if (target.rfind(prefix, 0) != 0) {
+			res.status = 404;
+			return res;
+		}
+
+		std::string code = target.substr(prefix.size());
+		const auto amp = code.find('&');
+		if (amp != std::string::npos)
+			code.erase(amp);
+
+		// トークン交換はブロックするため、応答を返してから別タスクで実行する
+		if (cb)
+			workers_->post([cb, code]() { cb(code); });
+
+		res.contentType = "text/html";
+		res.body = "<h1>Authentication successful!</h1>"
+			   "You can close this window.";
+		return res;
+	});
+}
+
+bool HttpServer::serve(int port, Handler handler)
+{
+	std::lock_guard<std::mutex> lifecycle(lifecycleMutex_);
 	if (running_)
-		return;
+		return true;
+
+#ifdef _WIN32
+	WSAData wsaData;
+	WSAStartup(MAKEWORD(2, 2), &wsaData);
+#endif
+
+	socket_t listenSocket = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	socket_t wakeSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+
+	auto fail = [&](const char *what) {
+		blog(LOG_ERROR, "[obs-scene-switcher] HTTP server %s failed on port %d (error %d)", what, port,
+		     lastSocketError());
+		if (listenSocket != kInvalidSocket)
+			closeSocket(listenSocket);
+		if (wakeSocket != kInvalidSocket)
+			closeSocket(wakeSocket);
+#ifdef _WIN32
+		WSACleanup();
+#endif
+		return false;
+	};
+
+	if (listenSocket == kInvalidSocket || wakeSocket == kInvalidSocket)
+		return fail("socket");
+
+	// 再起動直後の TIME_WAIT でバインドに失敗しないようにする
+#ifndef _WIN32
+	int reuse = 1;
+	setsockopt(listenSocket, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+#endif
+
+	sockaddr_in addr{};
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(static_cast<uint16_t>(port));
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
 
+	if (bind(listenSocket, (sockaddr *)&addr, sizeof(addr)) != 0 || listen(listenSocket, SOMAXCONN) != 0 ||
+	    !setNonBlocking(listenSocket))
+		return fail("listen");
+
+	// stop() や応答完了で poll を起こすための自己宛て UDP ソケット
+	sockaddr_in wakeAddr{};
+	wakeAddr.sin_family = AF_INET;
+	wakeAddr.sin_port = 0;
+	wakeAddr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	socklen_t wakeLen = sizeof(wakeAddr);
+	if (bind(wakeSocket, (sockaddr *)&wakeAddr, sizeof(wakeAddr)) != 0 ||
+	    getsockname(wakeSocket, (sockaddr *)&wakeAddr, &wakeLen) != 0 ||
+	    connect(wakeSocket, (sockaddr *)&wakeAddr, sizeof(wakeAddr)) != 0 || !setNonBlocking(wakeSocket))
+		return fail("wake socket");
+
+	listenSocket_ = static_cast<uintptr_t>(listenSocket);
+	wakeSocket_ = static_cast<uintptr_t>(wakeSocket);
+	handler_ = std::move(handler);
+	workers_ = std::make_unique<Executor>(1, "http-worker");
 	running_ = true;
-	callback_ = cb;
-
-	serverThread_ = std::thread([=]() {
-		WSAData wsaData;
-		WSAStartup(MAKEWORD(2, 2), &wsaData);
-
-		SOCKET serverSocket = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
-
-		sockaddr_in addr{};
-		addr.sin_family = AF_INET;
-		addr.sin_port = htons(port);
-		addr.sin_addr.s_addr = INADDR_ANY;
-
-		bind(serverSocket, (sockaddr *)&addr, sizeof(addr));
-		listen(serverSocket, 1);
-
-		while (running_) {
-			SOCKET client = accept(serverSocket, NULL, NULL);
-			if (client == INVALID_SOCKET)
-				continue;
-
-			char buffer[4096] = {};
-			int len = recv(client, buffer, sizeof(buffer), 0);
-			if (len > 0) {
-				std::string req(buffer, len);
-
-				// GET /callback?code=XXXX
-				auto pos = req.find("GET /callback?code=");
-				if (pos != std::string::npos) {
-					auto codeStart = pos + strlen("GET /callback?code=");
-					auto codeEnd = req.find(" ", codeStart);
-					std::string code = req.substr(codeStart, codeEnd - codeStart);
-
-					if (callback_)
-						callback_(code);
-
-					std::string res = "HTTP/1.1 200 OK\r\n"
-							  "Content-Type: text/html\r\n\r\n"
-							  "<h1>Authentication successful!</h1>"
-							  "You can close this window.";
-					send(client, res.c_str(), (int)res.size(), 0);
+
+	serverThread_ = std::thread([this]() { serverLoop(); });
+	return true;
+}
+
+void HttpServer::stop()
+{
+	std::lock_guard<std::mutex> lifecycle(lifecycleMutex_);
+	if (!serverThread_.joinable())
+		return;
+
+	running_ = false;
+	wake();
+	serverThread_.join();
+
+	// 実行中のハンドラの完了を待つ（未着手のタスクは破棄）
+	workers_->shutdown();
+	workers_.reset();
+
+	closeSocket(static_cast<socket_t>(listenSocket_));
+	closeSocket(static_cast<socket_t>(wakeSocket_));
+	listenSocket_ = kNoSocket;
+	wakeSocket_ = kNoSocket;
+
+	completions_.clear();
+	handler_ = nullptr;
+
+#ifdef _WIN32
+	WSACleanup();
+#endif
+}
+
+void HttpServer::wake()
+{
+	const char byte = 0;
+	send(static_cast<socket_t>(wakeSocket_), &byte, 1, 0);
+}
+
+void HttpServer::serverLoop()
+{
+	const socket_t listenSocket = static_cast<socket_t>(listenSocket_);
+	const socket_t wakeSocket = static_cast<socket_t>(wakeSocket_);
+
+	std::vector<pollfd_t> fds;
+
+	while (running_) {
+		fds.clear();
+		fds.push_back({wakeSocket, POLLIN, 0});
+		fds.push_back({listenSocket, POLLIN, 0});
+
+		auto now = SteadyClock::now();
+		auto nextDeadline = now + std::chrono::milliseconds(kIdleTimeoutMs);
+		for (const auto &conn : connections_) {
+			short events = 0;
+			if (conn->state == Connection::State::Reading)
+				events = POLLIN;
+			else if (conn->state == Connection::State::Writing)
+				events = POLLOUT;
+			fds.push_back({conn->socket, events, 0});
+
+			if (conn->state != Connection::State::Dispatched)
+				nextDeadline = std::min(nextDeadline, conn->deadline);
+		}
+
+		// 切り上げる（期限の直前に起きて空振りの poll を繰り返さない）
+		const auto waitMs = std::chrono::ceil<std::chrono::milliseconds>(nextDeadline - now).count();
+		const int ready = pollSockets(fds.data(), fds.size(), static_cast<int>(std::max<long long>(0, waitMs)));
+		if (ready < 0)
+			continue;
+
+		if (!running_)
+			break;
+
+		if (fds[0].revents & POLLIN) {
+			char drain[64];
+			while (recv(wakeSocket, drain, sizeof(drain), 0) > 0) {
+			}
+		}
+
+		// poll 前に存在した接続のみ revents を参照する
+		const size_t polled = fds.size() - 2;
+		for (size_t i = 0; i < polled; ++i) {
+			Connection &conn = *connections_[i];
+			const short revents = fds[i + 2].revents;
+
+			if (revents & (POLLERR | POLLHUP | POLLNVAL)) {
+				if (!(revents & POLLIN) || conn.state != Connection::State::Reading) {
+					conn.closed = true;
+					continue;
 				}
 			}
+			if ((revents & POLLIN) && conn.state == Connection::State::Reading)
+				readFrom(conn);
+			else if ((revents & POLLOUT) && conn.state == Connection::State::Writing)
+				writeTo(conn);
+		}
 
-			closesocket(client);
+		takeCompletions();
+
+		if (fds[1].revents & POLLIN)
+			acceptConnections();
+
+		// タイムアウトと切断済み接続の後始末
+		now = SteadyClock::now();
+		for (auto &conn : connections_) {
+			if (!conn->closed && conn->state != Connection::State::Dispatched && now >= conn->deadline)
+				conn->closed = true;
 		}
 
-		WSACleanup();
+		connections_.erase(std::remove_if(connections_.begin(), connections_.end(),
+						  [](const std::unique_ptr<Connection> &conn) {
+							  if (!conn->closed)
+								  return false;
+							  closeSocket(conn->socket);
+							  return true;
+						  }),
+				   connections_.end());
+	}
+
+	for (auto &conn : connections_)
+		closeSocket(conn->socket);
+	connections_.clear();
+}
+
+void HttpServer::acceptConnections()
+{
+	const socket_t listenSocket = static_cast<socket_t>(listenSocket_);
+
+	while (true) {
+		socket_t client = accept(listenSocket, nullptr, nullptr);
+		if (client == kInvalidSocket)
+			return;  // would-block またはエラー
+
+		if (connections_.size() >= kMaxConnections || !setNonBlocking(client)) {
+			closeSocket(client);
+			continue;
+		}
+
+		auto conn = std::make_unique<Connection>();
+		conn->id = nextConnectionId_++;
+		conn->socket = client;
+		conn->touch();
+		connections_.push_back(std::move(conn));
+	}
+}
+
+void HttpServer::readFrom(Connection &conn)
+{
+	char buffer[4096];
+
+	while (true) {
+		const int len = static_cast<int>(recv(conn.socket, buffer, sizeof(buffer), 0));
+		if (len > 0) {
+			conn.input.append(buffer, static_cast<size_t>(len));
+			conn.touch();
+			if (conn.input.size() > kMaxHeaderBytes + kMaxBodyBytes)
+				break;
+			continue;
+		}
+		if (len == 0 || !wouldBlock()) {
+			conn.closed = true;
+			return;
+		}
+		break;
+	}
+
+	// ヘッダ終端まで揃うのを待つ
+	const size_t headerEnd = conn.input.find("\r\n\r\n");
+	if (headerEnd == std::string::npos) {
+		if (conn.input.size() > kMaxHeaderBytes) {
+			Response res;
+			res.status = 431;
+			respondNow(conn, res);
+		}
+		return;
+	}
+
+	// リクエストライン: METHOD SP TARGET SP VERSION
+	const size_t lineEnd = conn.input.find("\r\n");
+	const std::string line = conn.input.substr(0, lineEnd);
+	const size_t methodEnd = line.find(' ');
+	const size_t targetEnd = methodEnd == std::string::npos ? std::string::npos : line.find(' ', methodEnd + 1);
+	if (targetEnd == std::string::npos) {
+		Response res;
+		res.status = 400;
+		respondNow(conn, res);
+		return;
+	}
+
+	// Content-Length 分の本文が届くまで待つ
+	size_t contentLength = 0;
+	size_t pos = lineEnd + 2;
+	while (pos < headerEnd) {
+		const size_t next = conn.input.find("\r\n", pos);
+		const std::string header = conn.input.substr(pos, next - pos);
+		const size_t colon = header.find(':');
+		if (colon != std::string::npos && equalsIgnoreCase(header.substr(0, colon), "content-length"))
+			contentLength = static_cast<size_t>(std::strtoull(header.c_str() + colon + 1, nullptr, 10));
+		pos = next + 2;
+	}
+
+	if (contentLength > kMaxBodyBytes) {
+		Response res;
+		res.status = 413;
+		respondNow(conn, res);
+		return;
+	}
+
+	if (conn.input.size() < headerEnd + 4 + contentLength)
+		return;
+
+	dispatch(conn, line.substr(0, methodEnd), line.substr(methodEnd + 1, targetEnd - methodEnd - 1));
+}
+
+void HttpServer::dispatch(Connection &conn, const std::string &method, const std::string &target)
+{
+	conn.state = Connection::State::Dispatched;
+	conn.input.clear();
+
+	// ハンドラはワーカーで実行し、結果はサーバースレッドへ戻して送信する
+	const uint64_t id = conn.id;
+	const bool posted = workers_->post([this, id, method, target]() {
+		const Response res = handler_(method, target);
+		{
+			std::lock_guard<std::mutex> lock(completionsMutex_);
+			completions_.push_back({id, serialize(res)});
+		}
+		wake();
 	});
+
+	if (!posted) {
+		Response res;
+		res.status = 503;
+		respondNow(conn, res);
+	}
 }
 
-void HttpServer::stop()
+void HttpServer::respondNow(Connection &conn, const Response &res)
 {
-	running_ = false;
+	conn.state = Connection::State::Writing;
+	conn.output = serialize(res);
+	conn.written = 0;
+	conn.touch();
+	writeTo(conn);
+}
+
+void HttpServer::writeTo(Connection &conn)
+{
+	while (conn.written < conn.output.size()) {
+		const int sent = static_cast<int>(send(conn.socket, conn.output.data() + conn.written,
+						       static_cast<int>(conn.output.size() - conn.written), 0));
+		if (sent > 0) {
+			conn.written += static_cast<size_t>(sent);
+			conn.touch();
+			continue;
+		}
+		if (sent < 0 && wouldBlock())
+			return;  // POLLOUT を待つ
+
+		conn.closed = true;
+		return;
+	}
+
+	// Connection: close なので送信完了で閉じる
+	conn.closed = true;
+}
+
+void HttpServer::takeCompletions()
+{
+	std::vector<Completion> done;
+	{
+		std::lock_guard<std::mutex> lock(completionsMutex_);
+		done.swap(completions_);
+	}
+
+	for (auto &completion : done) {
+		auto it = std::find_if(connections_.begin(), connections_.end(),
+				       [&](const std::unique_ptr<Connection> &conn) {
+					       return conn->id == completion.connectionId;
+				       });
+		if (it == connections_.end() || (*it)->closed)
+			continue;  // 応答前に切断された
+
+		Connection &conn = **it;
+		conn.state = Connection::State::Writing;
+		conn.output = std::move(completion.payload);
+		conn.written = 0;
+		conn.touch();
+		writeTo(conn);
+	}
+}
+
+std::string HttpServer::serialize(const Response &res)
+{
+	return "HTTP/1.1 " + std::to_string(res.status) + " " + statusText(res.status) +
+	       "\r\n"
+	       "Content-Type: " +
+	       res.contentType +
+	       "\r\n"
+	       "Content-Length: " +
+	       std::to_string(res.body.size()) +
+	       "\r\n"
+	       "Connection: close\r\n\r\n" +
+	       res.body;
 }
@@ -7,18 +7,85 @@
 #include <string>
 #include <thread>
 #include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
 
+class Executor;
+
+/**
+ * localhost 専用の小さな HTTP/1.1 サーバー
+ *
+ * - 127.0.0.1 のみにバインドし、poll（Windows は WSAPoll）で全接続を 1 スレッドで多重化する
+ * - リクエストはヘッダ終端（と Content-Length 分の本文）まで逐次受信してから解析する
+ * - 接続ごとに無通信タイムアウトを設け、ハンドラはワーカースレッドで実行する
+ * - stop() は待ち受けを閉じ、サーバースレッドとワーカーの終了を待ってから戻る
+ */
 class HttpServer {
 public:
+	struct Response {
+		int status = 200;
+		std::string contentType = "text/plain; charset=utf-8";
+		std::string body;
+	};
+
+	// method と target（パス + クエリ）から応答を返す。ワーカースレッドで呼ばれる
+	using Handler = std::function<Response(const std::string &method, const std::string &target)>;
+
+	// OAuth コールバック用の共有インスタンス
 	static HttpServer *instance();
 
+	HttpServer();
+	~HttpServer();
+
+	HttpServer(const HttpServer &) = delete;
+	HttpServer &operator=(const HttpServer &) = delete;
+
+	// GET /callback?code=... を受け取って callback を呼ぶ（OAuth 用、callback はワーカースレッドで実行）
 	void start(int port, std::function<void(const std::string &)> callback);
+
+	// 任意のハンドラで 127.0.0.1:port を待ち受ける
+	bool serve(int port, Handler handler);
+
+	// 待ち受けを閉じ、サーバースレッドとワーカーの終了を待つ
 	void stop();
 
+	bool isRunning() const { return running_; }
+
 private:
-	HttpServer() = default;
+	struct Connection;
+
+	struct Completion {
+		uint64_t connectionId;
+		std::string payload;
+	};
+
+	void serverLoop();
+	void wake();
+	void acceptConnections();
+	void readFrom(Connection &conn);
+	void writeTo(Connection &conn);
+	void dispatch(Connection &conn, const std::string &method, const std::string &target);
+	void respondNow(Connection &conn, const Response &res);
+	void takeCompletions();
+
+	static std::string serialize(const Response &res);
+
+	std::mutex lifecycleMutex_;
 	std::thread serverThread_;
 	std::atomic<bool> running_ = false;
 
-	std::function<void(const std::string &)> callback_;
+	// ソケットはプラットフォーム差を隠すため整数で保持する
+	uintptr_t listenSocket_;
+	uintptr_t wakeSocket_;
+
+	Handler handler_;
+	std::unique_ptr<Executor> workers_;
+
+	std::vector<std::unique_ptr<Connection>> connections_;  // サーバースレッドのみが触る
+	uint64_t nextConnectionId_ = 1;
+
+	std::mutex completionsMutex_;
+	std::vector<Completion> completions_;
 };
@@ -5,16 +5,71 @@
 #include "twitch_oauth.hpp"
 #include "../obs/config_manager.hpp"
 #include "../i18n/locale_manager.hpp"
+#include "../core/metrics.hpp"
+#include "../net/network.hpp"
 
 #include <obs-module.h>
 #include <nlohmann/json.hpp>
+#include <ctime>
 #include <windows.h>
-#include <wininet.h>
-
-#pragma comment(lib, "Wininet.lib")
 
 static const char *REDIRECT_URI = "http://localhost:38915/callback";
-static const char *SCOPE = "channel:read:redemptions";
+// 引き換えの状態更新（FULFILLED / CANCELED）に manage が必要
+// Bits・サブスク・フォローのトリガーにそれぞれの read が必要（レイドはスコープ不要）
+static const char *SCOPE = "channel:read:redemptions%20channel:manage:redemptions%20bits:read"
+			   "%20channel:read:subscriptions%20moderator:read:followers";
+
+static const char *kIdHost = "id.twitch.tv";
+static const char *kHelixHost = "api.twitch.tv";
+
+// 報酬一覧の応答キャッシュ（起動・ログイン・設定画面の更新が重なった分をまとめる）
+static constexpr std::chrono::milliseconds kRewardsCacheTtl{5000};
+
+static HttpRequest tokenRequest(const std::string &body)
+{
+	HttpRequest req;
+	req.method = "POST";
+	req.host = kIdHost;
+	req.path = "/oauth2/token";
+	req.headers = {{"Content-Type", "application/x-www-form-urlencoded"}};
+	req.body = body;
+	return req;
+}
+
+static HttpRequest helixGet(const std::string &path, const std::string &clientId, const std::string &accessToken)
+{
+	HttpRequest req;
+	req.host = kHelixHost;
+	req.path = path;
+	req.headers = {{"Client-ID", clientId}, {"Authorization", "Bearer " + accessToken}};
+	req.latency = &metrics::Registry::instance().helixLatency;
+	return req;
+}
+
+// トークンエンドポイントの応答を解釈する（refresh_token が返らない場合は fallbackRefresh を使う）
+static bool parseTokenResponse(const HttpResponse &res, const std::string &fallbackRefresh, TokenSet &out)
+{
+	if (!res.error.empty()) {
+		blog(LOG_ERROR, "[obs-scene-switcher][OAuth] Token request failed: %s", res.error.c_str());
+		return false;
+	}
+
+	auto json = nlohmann::json::parse(res.body, nullptr, false);
+	if (json.is_discarded()) {
+		blog(LOG_ERROR, "[obs-scene-switcher] Failed to parse token response (HTTP %d)", res.status);
+		return false;
+	}
+
+	out.accessToken = json.value("access_token", "");
+	out.refreshToken = json.value("refresh_token", fallbackRefresh);
+	out.expiresAt = static_cast<long>(time(nullptr)) + static_cast<long>(json.value("expires_in", 0));
+
+	if (out.accessToken.empty()) {
+		blog(LOG_ERROR, "[obs-scene-switcher] Access token empty (HTTP %d)", res.status);
+		return false;
+	}
+	return true;
+}
 
 TwitchOAuth::TwitchOAuth()
 {
@@ -51,107 +106,55 @@ void TwitchOAuth::handleAuthCode(const std::string &code)
 	// TODO
 }
 
-bool TwitchOAuth::refreshAccessToken()
+static void refreshAttempt(HttpRequest req, std::string refreshToken, int attempt,
+			   TwitchOAuth::TokenCallback done)
+{
+	Network::instance().request(req, [req, refreshToken, attempt, done](const HttpResponse &res) {
+		auto &registry = metrics::Registry::instance();
+
+		TokenSet tokens;
+		if (parseTokenResponse(res, refreshToken, tokens)) {
+			registry.tokenRefreshes.inc();
+			if (attempt == 0)
+				blog(LOG_INFO, "[obs-scene-switcher] Token refresh successful");
+			else
+				blog(LOG_INFO, "[obs-scene-switcher] Token refresh succeeded on retry");
+			done(true, tokens);
+			return;
+		}
+
+		// リトライ試行
+		if (attempt == 0) {
+			blog(LOG_WARNING, "[obs-scene-switcher] Token refresh failed, retrying...");
+			refreshAttempt(req, refreshToken, attempt + 1, done);
+			return;
+		}
+
+		// 失敗時
+		registry.tokenRefreshFailures.inc();
+		blog(LOG_ERROR, "[obs-scene-switcher] Token refresh failed after retry");
+		done(false, {});
+	});
+}
+
+void TwitchOAuth::refreshAccessTokenAsync(TokenCallback done)
 {
 	auto &cfg = ConfigManager::instance();
-	refreshToken_ = cfg.getRefreshToken();
+	const std::string refreshToken = cfg.getRefreshToken();
 	clientId_ = cfg.getClientId();
 	clientSecret_ = cfg.getClientSecret();
 
-	if (refreshToken_.empty()) {
+	if (refreshToken.empty()) {
 		blog(LOG_DEBUG, "[obs-scene-switcher][OAuth] No refresh token available, skipping refresh");
-		return false;
+		done(false, {});
+		return;
 	}
 
 	blog(LOG_DEBUG, "[obs-scene-switcher][OAuth] Refreshing access token...");
 
-	auto attemptRefresh = [&]() -> bool {
-                HINTERNET hInet = InternetOpenA("TwitchOAuth", INTERNET_OPEN_TYPE_DIRECT, NULL, NULL, 0);
-	        if (!hInet) {
-		        blog(LOG_ERROR, "[obs-scene-switcher] InternetOpenA failed");
-		        return false;
-	        }
-
-	        HINTERNET hConnect = InternetConnectA(hInet, "id.twitch.tv", 443, NULL, NULL, INTERNET_SERVICE_HTTP, 0, 0);
-	        if (!hConnect) {
-		        blog(LOG_ERROR, "[obs-scene-switcher] InternetConnectA failed");
-		        InternetCloseHandle(hInet);
-		        return false;
-	        }
-
-	        HINTERNET hRequest =
-		        HttpOpenRequestA(hConnect, "POST", "/oauth2/token", NULL, NULL, NULL, INTERNET_FLAG_SECURE, 0);
-	        if (!hRequest) {
-		        blog(LOG_ERROR, "[obs-scene-switcher] HttpOpenRequestA failed");
-		        InternetCloseHandle(hConnect);
-		        InternetCloseHandle(hInet);
-		        return false;
-	        }
-
-	        std::string body = "client_id=" + clientId_ + "&client_secret=" + clientSecret_ +
-		        	   "&refresh_token=" + refreshToken_ + "&grant_type=refresh_token";
-	        std::string headers = "Content-Type: application/x-www-form-urlencoded";
-
-	        BOOL requestOk = HttpSendRequestA(hRequest, headers.c_str(), (DWORD)headers.size(), (LPVOID)body.c_str(),
-		        			  (DWORD)body.size());
-
-	        if (!requestOk) {
-		        blog(LOG_ERROR, "[obs-scene-switcher] HttpSendRequestA failed");
-		        InternetCloseHandle(hRequest);
-		        InternetCloseHandle(hConnect);
-		        InternetCloseHandle(hInet);
-		        return false;
-	        }
-
-	        char buffer[8192];
-	        DWORD read = 0;
-	        std::string response;
-	        while (InternetReadFile(hRequest, buffer, sizeof(buffer), &read) && read > 0)
-		        response.append(buffer, read);
-
-	        InternetCloseHandle(hRequest);
-	        InternetCloseHandle(hConnect);
-	        InternetCloseHandle(hInet);
-
-	        auto json = nlohmann::json::parse(response, nullptr, false);
-	        if (json.is_discarded()) {
-		        blog(LOG_ERROR, "[obs-scene-switcher] Failed to parse refresh response");
-		        return false;
-	        }
-
-	        accessToken_ = json.value("access_token", "");
-	        refreshToken_ = json.value("refresh_token", refreshToken_);
-	        expiresAt_ = static_cast<long>(time(nullptr)) + static_cast<long>(json.value("expires_in", 0));
-
-	        if (accessToken_.empty()) {
-		        blog(LOG_ERROR, "[obs-scene-switcher] Refresh failed: access_token empty");
-		        return false;
-		}
-		return true;
-	};
-
-	// 1回目試行
-	if (attemptRefresh()) {
-		blog(LOG_INFO, "[obs-scene-switcher] Token refresh successful");
-		cfg.setAccessToken(accessToken_);
-		cfg.setRefreshToken(refreshToken_);
-		cfg.setTokenExpiresAt(expiresAt_);
-		return true;
-	}
-
-        // リトライ試行
-	blog(LOG_WARNING, "[obs-scene-switcher] Token refresh failed, retrying...");
-	if (attemptRefresh()) {
-		blog(LOG_INFO, "[obs-scene-switcher] Token refresh succeeded on retry");
-		cfg.setAccessToken(accessToken_);
-		cfg.setRefreshToken(refreshToken_);
-		cfg.setTokenExpiresAt(expiresAt_);
-		return true;
-	}
-
-	// 失敗時
-	blog(LOG_ERROR, "[obs-scene-switcher] Token refresh failed after retry");
-	return false;
+	refreshAttempt(tokenRequest("client_id=" + clientId_ + "&client_secret=" + clientSecret_ +
+				    "&refresh_token=" + refreshToken + "&grant_type=refresh_token"),
+		       refreshToken, 0, std::move(done));
 }
 
 std::string TwitchOAuth::buildAuthUrl()
@@ -165,185 +168,132 @@ std::string TwitchOAuth::buildAuthUrl()
 	return url;
 }
 
-bool TwitchOAuth::fetchUserInfo()
+void TwitchOAuth::fetchUserInfoAsync(const std::string &clientId, const TokenSet &tokens, LoginCallback done)
 {
-	HINTERNET hInet = InternetOpenA("TwitchOAuth", INTERNET_OPEN_TYPE_DIRECT, NULL, NULL, 0);
-	if (!hInet)
-		return false;
-
-	HINTERNET hConnect =
-		InternetConnectA(hInet, "api.twitch.tv", 443, nullptr, nullptr, INTERNET_SERVICE_HTTP, 0, 0);
-	if (!hConnect)
-		return false;
-
-	HINTERNET hRequest =
-		HttpOpenRequestA(hConnect, "GET", "/helix/users", NULL, NULL, NULL, INTERNET_FLAG_SECURE, 0);
-
-	std::string headers = "Client-ID: " + clientId_ +
-			      "\r\n"
-			      "Authorization: Bearer " +
-			      accessToken_ + "\r\n";
-
-	if (!HttpSendRequestA(hRequest, headers.c_str(), (DWORD)headers.size(), nullptr, 0)) {
-		blog(LOG_ERROR, "[obs-scene-switcher] Failed to send user info request");
-		return false;
-	}
-
-	char buffer[8192];
-	DWORD read = 0;
-	std::string response;
-	while (InternetReadFile(hRequest, buffer, sizeof(buffer), &read) && read > 0) {
-		response.append(buffer, read);
-	}
-
-	InternetCloseHandle(hRequest);
-	InternetCloseHandle(hConnect);
-	InternetCloseHandle(hInet);
-
-	auto json = nlohmann::json::parse(response, nullptr, false);
-	if (json.is_discarded() || !json.contains("data") || json["data"].empty())
-		return false;
+	Network::instance().request(helixGet("/helix/users", clientId, tokens.accessToken),
+				    [tokens, done](const HttpResponse &res) {
+		auto json = nlohmann::json::parse(res.body, nullptr, false);
+		if (!res.ok() || json.is_discarded() || !json.contains("data") || json["data"].empty()) {
+			blog(LOG_ERROR, "[obs-scene-switcher] Failed to fetch user info (HTTP %d)", res.status);
+			done(false, tokens, {});
+			return;
+		}
 
-	const auto &user = json["data"][0];
-	broadcasterUserId_ = user.value("id", "");
-	broadcasterLogin_ = user.value("login", "");
-	displayName_ = user.value("display_name", "");
+		const auto &data = json["data"][0];
+		TwitchUser user;
+		user.id = data.value("id", "");
+		user.login = data.value("login", "");
+		user.displayName = data.value("display_name", "");
 
-	blog(LOG_INFO, "[obs-scene-switcher] Authenticated as: %s (%s)", displayName_.c_str(), broadcasterLogin_.c_str());
+		blog(LOG_INFO, "[obs-scene-switcher] Authenticated as: %s (%s)", user.displayName.c_str(),
+		     user.login.c_str());
 
-	return true;
+		done(true, tokens, user);
+	});
 }
 
-bool TwitchOAuth::exchangeCodeForToken(const std::string &code)
+void TwitchOAuth::exchangeCodeForTokenAsync(const std::string &code, LoginCallback done)
 {
 	blog(LOG_DEBUG, "[obs-scene-switcher][OAuth] Exchanging code for token...");
 
-	HINTERNET hInet = InternetOpenA("TwitchOAuth", INTERNET_OPEN_TYPE_DIRECT, NULL, NULL, 0);
-	if (!hInet) return false;
-
-	HINTERNET hConnect = InternetConnectA(hInet, "id.twitch.tv", 443, NULL, NULL, INTERNET_SERVICE_HTTP, 0, 0);
-	HINTERNET hRequest =
-		HttpOpenRequestA(hConnect, "POST", "/oauth2/token", NULL, NULL, NULL, INTERNET_FLAG_SECURE, 0);
-
-	std::string body = "client_id=" + clientId_ + "&client_secret=" + clientSecret_ + "&code=" + code +
-			   "&grant_type=authorization_code"
-			   "&redirect_uri=" + std::string(REDIRECT_URI);
-	std::string headers = "Content-Type: application/x-www-form-urlencoded";
-
-	HttpSendRequestA(hRequest, headers.c_str(), (DWORD)headers.size(), (LPVOID)body.c_str(), (DWORD)body.size());
-
-	char buffer[8192];
-	DWORD read = 0;
-	std::string response;
-
-	while (InternetReadFile(hRequest, buffer, sizeof(buffer), &read) && read > 0) {
-		response.append(buffer, read);
-	}
-
-	InternetCloseHandle(hRequest);
-	InternetCloseHandle(hConnect);
-	InternetCloseHandle(hInet);
-
-	// JSON parse
-	auto json = nlohmann::json::parse(response, nullptr, false);
-	if (json.is_discarded())
-		return false;
-
-	accessToken_ = json.value("access_token", "");
-	refreshToken_ = json.value("refresh_token", "");
-	expiresAt_ = json.value("expires_in", 0);
-
-	if (accessToken_.empty()) {
-		blog(LOG_ERROR, "[obs-scene-switcher] Access token empty");
-		return false;
-	}
+	auto &cfg = ConfigManager::instance();
+	clientId_ = cfg.getClientId();
+	clientSecret_ = cfg.getClientSecret();
 
-	blog(LOG_DEBUG, "[obs-scene-switcher][OAuth] Token exchange complete, fetching user info...");
+	const std::string clientId = clientId_;
+	HttpRequest req = tokenRequest("client_id=" + clientId_ + "&client_secret=" + clientSecret_ + "&code=" + code +
+				       "&grant_type=authorization_code"
+				       "&redirect_uri=" + std::string(REDIRECT_URI));
 
-	// ユーザー情報取得
-	if (!fetchUserInfo()) {
-		blog(LOG_ERROR, "[obs-scene-switcher] Failed to fetch user info");
-		return false;
-	}
+	Network::instance().request(std::move(req), [this, clientId, done](const HttpResponse &res) {
+		TokenSet tokens;
+		if (!parseTokenResponse(res, {}, tokens)) {
+			done(false, {}, {});
+			return;
+		}
 
-	// Config 保存
-	auto &cfg = ConfigManager::instance();
-	cfg.setAccessToken(accessToken_);
-	cfg.setRefreshToken(refreshToken_);
-	cfg.setTokenExpiresAt(expiresAt_);
-	cfg.setBroadcasterUserId(broadcasterUserId_);
-	cfg.setBroadcasterLogin(broadcasterLogin_);
-	cfg.setBroadcasterDisplayName(displayName_);
-	cfg.save();
+		blog(LOG_DEBUG, "[obs-scene-switcher][OAuth] Token exchange complete, fetching user info...");
 
-	return true;
+		// ユーザー情報取得
+		fetchUserInfoAsync(clientId, tokens, done);
+	});
 }
 
-std::vector<RewardInfo> TwitchOAuth::fetchChannelRewards()
+void TwitchOAuth::fetchChannelRewardsAsync(RewardsCallback done)
 {
-	std::vector<RewardInfo> list;
-
 	auto &cfg = ConfigManager::instance();
-	clientId_ = cfg.getClientId();
-	accessToken_ = cfg.getAccessToken();
-	std::string broadcasterUserId = cfg.getBroadcasterUserId();
+	const std::string clientId = cfg.getClientId();
+	const std::string accessToken = cfg.getAccessToken();
+	const std::string broadcasterUserId = cfg.getBroadcasterUserId();
 
-	if (clientId_.empty() || accessToken_.empty() || broadcasterUserId.empty()) {
-		blog(LOG_ERROR, "[obs-scene-switcher] Missing credentials for fetchChannelRewards()");
-		return list;
+	if (clientId.empty() || accessToken.empty() || broadcasterUserId.empty()) {
+		blog(LOG_ERROR, "[obs-scene-switcher] Missing credentials for fetchChannelRewardsAsync()");
+		done(false, {});
+		return;
 	}
 
-	HINTERNET hInet = InternetOpenA("TwitchOAuth", INTERNET_OPEN_TYPE_DIRECT, NULL, NULL, 0);
-	if (!hInet)
-		return list;
+	const std::string path = "/helix/channel_points/custom_rewards?broadcaster_id=" + broadcasterUserId;
 
-	HINTERNET hConnect =
-		InternetConnectA(hInet, "api.twitch.tv", 443, nullptr, nullptr, INTERNET_SERVICE_HTTP, 0, 0);
-	if (!hConnect) {
-		InternetCloseHandle(hInet);
-		return list;
-	}
+	HttpRequest req = helixGet(path, clientId, accessToken);
+	req.priority = RequestPriority::Low;
 
-	std::string path = "/helix/channel_points/custom_rewards?broadcaster_id=" + broadcasterUserId;
+	// 同時に来た同じ要求は 1 回の通信にまとめ、直後の再要求はキャッシュから返す
+	Network::instance().requestShared(std::move(req), kRewardsCacheTtl,
+					  [done](const HttpResponse &res) {
+		std::vector<RewardInfo> list;
 
-	HINTERNET hRequest = HttpOpenRequestA(hConnect, "GET", path.c_str(), NULL, NULL, NULL, INTERNET_FLAG_SECURE, 0);
-
-	std::string headers = "Client-ID: " + clientId_ +
-			      "\r\n"
-			      "Authorization: Bearer " +
-			      accessToken_ + "\r\n";
+		auto json = nlohmann::json::parse(res.body, nullptr, false);
+		if (!res.ok() || json.is_discarded() || !json.contains("data")) {
+			blog(LOG_ERROR, "[obs-scene-switcher] Reward request failed (HTTP %d%s%s)", res.status,
+			     res.error.empty() ? "" : ", ", res.error.c_str());
+			done(false, list);
+			return;
+		}
 
-	if (!HttpSendRequestA(hRequest, headers.c_str(), (DWORD)headers.size(), nullptr, 0)) {
-		blog(LOG_ERROR, "[obs-scene-switcher] Reward request failed");
-		InternetCloseHandle(hRequest);
-		InternetCloseHandle(hConnect);
-		InternetCloseHandle(hInet);
-		return list;
-	}
+		for (auto &r : json["data"]) {
+			RewardInfo info;
+			info.id = r.value("id", "");
+			info.title = r.value("title", "");
+			list.push_back(info);
+		}
 
-	char buffer[8192];
-	DWORD read = 0;
-	std::string response;
-	while (InternetReadFile(hRequest, buffer, sizeof(buffer), &read) && read > 0) {
-		response.append(buffer, read);
-	}
+		blog(LOG_INFO, "[obs-scene-switcher] Fetched %zu channel rewards", list.size());
 
-	InternetCloseHandle(hRequest);
-	InternetCloseHandle(hConnect);
-	InternetCloseHandle(hInet);
+		done(true, list);
+	});
+}
 
-	auto json = nlohmann::json::parse(response, nullptr, false);
-	if (json.is_discarded() || !json.contains("data"))
-		return list;
+void TwitchOAuth::updateRedemptionStatusAsync(const std::string &rewardId,
+					      const std::vector<std::string> &redemptionIds, const std::string &status,
+					      StatusCallback done)
+{
+	auto &cfg = ConfigManager::instance();
+	const std::string clientId = cfg.getClientId();
+	const std::string accessToken = cfg.getAccessToken();
+	const std::string broadcasterUserId = cfg.getBroadcasterUserId();
 
-	for (auto &r : json["data"]) {
-		RewardInfo info;
-		info.id = r.value("id", "");
-		info.title = r.value("title", "");
-		list.push_back(info);
+	if (clientId.empty() || accessToken.empty() || broadcasterUserId.empty() || redemptionIds.empty()) {
+		blog(LOG_ERROR, "[obs-scene-switcher] Missing credentials for updateRedemptionStatusAsync()");
+		done(0);
+		return;
 	}
 
-	blog(LOG_INFO, "[obs-scene-switcher] Fetched %zu channel rewards", list.size());
-
-	return list;
+	std::string path = "/helix/channel_points/custom_rewards/redemptions?broadcaster_id=" + broadcasterUserId +
+			   "&reward_id=" + rewardId;
+	for (const auto &id : redemptionIds)
+		path += "&id=" + id;
+
+	HttpRequest req = helixGet(path, clientId, accessToken);
+	req.method = "PATCH";
+	req.headers.emplace_back("Content-Type", "application/json");
+	req.body = nlohmann::json{{"status", status}}.dump();
+
+	Network::instance().request(std::move(req), [done](const HttpResponse &res) {
+		if (!res.error.empty())
+			blog(LOG_WARNING, "[obs-scene-switcher] Redemption status request failed: %s", res.error.c_str());
+		else if (res.status == 401)
+			blog(LOG_WARNING, "[obs-scene-switcher] Redemption status update unauthorized; log in again to grant "
+					  "channel:manage:redemptions");
+		done(res.error.empty() ? res.status : 0);
+	});
 }
@@ -3,7 +3,9 @@
 // SPDX-License-Identifier: GPL-2.0-or-later
 
 #pragma once
+#include <functional>
 #include <string>
+#include <vector>
 #include <QObject>
 
 struct RewardInfo {
@@ -11,9 +13,36 @@ struct RewardInfo {
 	std::string title;
 };
 
+// トークンエンドポイントの応答
+struct TokenSet {
+	std::string accessToken;
+	std::string refreshToken;
+	long expiresAt = 0;
+};
+
+// 認証したユーザー（配信者）
+struct TwitchUser {
+	std::string id;
+	std::string login;
+	std::string displayName;
+};
+
+/**
+ * Twitch OAuth / Helix
+ *
+ * - 通信は Network のスレッドで行い、完了コールバックもネットワークスレッドで呼ばれる
+ * - 入力（Client ID・トークンなど）は呼び出し時に ConfigManager から読み、結果は設定に書き込まない
+ *   （設定への反映は呼び出し側が UI スレッドで行う）
+ */
 class TwitchOAuth : public QObject {
 	Q_OBJECT
 public:
+	using TokenCallback = std::function<void(bool success, const TokenSet &tokens)>;
+	using LoginCallback = std::function<void(bool success, const TokenSet &tokens, const TwitchUser &user)>;
+	using RewardsCallback = std::function<void(bool success, const std::vector<RewardInfo> &rewards)>;
+	// HTTP ステータス（通信失敗・認証情報なしは 0）
+	using StatusCallback = std::function<void(int httpStatus)>;
+
 	static TwitchOAuth &instance()
 	{
 		static TwitchOAuth inst;
@@ -23,18 +52,19 @@ public:
 	void startOAuthLogin();                       // ブラウザで認証開始
 	void handleAuthCode(const std::string &code); // /callback で受信
 
-	bool refreshAccessToken();
+	// リフレッシュトークンでアクセストークンを更新（失敗時は 1 回だけ再試行）
+	void refreshAccessTokenAsync(TokenCallback done);
 
 	std::string buildAuthUrl();
-	bool exchangeCodeForToken(const std::string &code);
 
-	std::string getAccessToken() const { return accessToken_; }
-	std::string getRefreshToken() const { return refreshToken_; }
-	long getExpiresAt() const { return expiresAt_; }
+	// 認可コード → トークン → ユーザー情報
+	void exchangeCodeForTokenAsync(const std::string &code, LoginCallback done);
 
-	const std::string &getBroadcasterUserId() const { return broadcasterUserId_; }
+	void fetchChannelRewardsAsync(RewardsCallback done);
 
-	std::vector<RewardInfo> fetchChannelRewards();
+	// 同じ報酬の引き換え（最大 50 件）の状態を status（FULFILLED / CANCELED）に更新する
+	void updateRedemptionStatusAsync(const std::string &rewardId, const std::vector<std::string> &redemptionIds,
+					 const std::string &status, StatusCallback done);
 
 signals:
 	void authenticationError(const QString &message);
@@ -44,18 +74,9 @@ private:
 	~TwitchOAuth();
 	TwitchOAuth(const TwitchOAuth &) = delete;
 	TwitchOAuth &operator=(const TwitchOAuth &) = delete;
-	bool fetchUserInfo();
+
+	void fetchUserInfoAsync(const std::string &clientId, const TokenSet &tokens, LoginCallback done);
 
 	std::string clientId_;
 	std::string clientSecret_;
-
-	std::string accessToken_;
-	std::string refreshToken_;
-	long expiresAt_ = 0;
-
-	std::string broadcasterUserId_;
-	std::string broadcasterLogin_;
-	std::string displayName_;
-
-	std::vector<std::pair<std::string, std::string>> lastRewards_;
 };
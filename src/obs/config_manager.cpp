@@ -3,19 +3,18 @@
 // SPDX-License-Identifier: GPL-2.0-or-later
 
 #include "config_manager.hpp"
+#include "core/rule_serialization.hpp"
 
 #include <obs-module.h>
-#include <nlohmann/json.hpp>
 #include <fstream>
 #include <sstream>
 #include <filesystem>
+#include <cstdlib>
 #include <vector>
 #include <windows.h>
 #include <wincrypt.h>
 #pragma comment(lib, "Crypt32.lib")
 
-using json = nlohmann::json;
-
 ConfigManager &ConfigManager::instance()
 {
 	static ConfigManager inst;
@@ -110,6 +109,27 @@ static std::string base64_decode(const std::string &input)
 	return output;
 }
 
+static std::vector<RewardRule> parseRuleLines(const std::vector<std::string> &lines)
+{
+	std::vector<RewardRule> rules;
+	rules.reserve(lines.size());
+
+	for (const auto &raw : lines) {
+		RewardRule r;
+		if (!ruleFromJson(raw, r)) {
+			blog(LOG_ERROR, "[obs-scene-switcher] Failed to parse rule JSON: %s", raw.c_str());
+			continue;
+		}
+		if ((r.trigger == EventKind::Redemption && r.rewardId.empty()) ||
+		    (r.targetScene.empty() && r.actions.empty()))
+			continue;
+
+		rules.push_back(std::move(r));
+	}
+
+	return rules;
+}
+
 std::string secureEncode(const std::string &plain)
 {
 	auto enc = DPAPIEncrypt(plain);
@@ -169,16 +189,21 @@ void ConfigManager::save()
 	ofs << "broadcaster_login=" << broadcasterLogin_ << "\n";
 	ofs << "broadcaster_display_name=" << streamerDisplayName_ << "\n";
 	ofs << "plugin_enabled=" << (pluginEnabled_ ? "1" : "0") << "\n";
-	
-	for (const auto &r : rewardRules_) {
-		json j{
-			{"reward_id", r.rewardId},
-			{"source_scene", r.sourceScene},
-			{"target_scene", r.targetScene},
-			{"revert_seconds", r.revertSeconds},
-			{"enabled", r.enabled}
-		};
-		ofs << "rule=" << j.dump() << "\n";
+	ofs << "tick_sync_switching=" << (tickSyncSwitching_ ? "1" : "0") << "\n";
+	ofs << "load_aware_switching=" << (loadAwareSwitching_ ? "1" : "0") << "\n";
+	ofs << "redemption_status_updates=" << (redemptionStatusUpdates_ ? "1" : "0") << "\n";
+	ofs << "global_cooldown_seconds=" << globalCooldownSeconds_ << "\n";
+	ofs << "eventsub_standby=" << (eventSubStandby_ ? "1" : "0") << "\n";
+	ofs << "metrics_enabled=" << (metricsEnabled_ ? "1" : "0") << "\n";
+	ofs << "metrics_port=" << metricsPort_ << "\n";
+
+	// ルールはシーンコレクションごとのセクションに書く（セクションのないルールは旧形式の共通ルール）
+	stashActiveRules();
+	for (const auto &[collection, lines] : collectionRules_) {
+		if (!collection.empty())
+			ofs << "scene_collection=" << collection << "\n";
+		for (const auto &raw : lines)
+			ofs << "rule=" << raw << "\n";
 	}
 
 	blog(LOG_DEBUG, "[obs-scene-switcher] Settings saved successfully to %s", configPath_.c_str());
@@ -190,6 +215,8 @@ void ConfigManager::load()
 		return;
 
 	rewardRules_.clear();
+	collectionRules_.clear();
+	rulesDirty_ = false;
 
 	std::ifstream ifs(configPath_);
 	if (!ifs.is_open()) {
@@ -197,6 +224,7 @@ void ConfigManager::load()
 		return;
 	}
 
+	std::string section;  // 読み込み中のシーンコレクション（空: 旧形式の共通ルール）
 	std::string line;
 	while (std::getline(ifs, line)) {
 		if (line.empty())
@@ -227,27 +255,70 @@ void ConfigManager::load()
 			streamerDisplayName_ = line.substr(std::string("broadcaster_display_name=").size());
 		} else if (line.rfind("plugin_enabled=", 0) == 0) {
 			pluginEnabled_ = (line.substr(std::string("plugin_enabled=").size()) == "1");
+		} else if (line.rfind("tick_sync_switching=", 0) == 0) {
+			tickSyncSwitching_ = (line.substr(std::string("tick_sync_switching=").size()) == "1");
+		} else if (line.rfind("load_aware_switching=", 0) == 0) {
+			loadAwareSwitching_ = (line.substr(std::string("load_aware_switching=").size()) == "1");
+		} else if (line.rfind("redemption_status_updates=", 0) == 0) {
+			redemptionStatusUpdates_ =
+				(line.substr(std::string("redemption_status_updates=").size()) == "1");
+		} else if (line.rfind("global_cooldown_seconds=", 0) == 0) {
+			const int seconds = std::atoi(line.substr(std::string("global_cooldown_seconds=").size()).c_str());
+			globalCooldownSeconds_ = seconds > 0 ? seconds : 0;
+		} else if (line.rfind("eventsub_standby=", 0) == 0) {
+			eventSubStandby_ = (line.substr(std::string("eventsub_standby=").size()) == "1");
+		} else if (line.rfind("metrics_enabled=", 0) == 0) {
+			metricsEnabled_ = (line.substr(std::string("metrics_enabled=").size()) == "1");
+		} else if (line.rfind("metrics_port=", 0) == 0) {
+			const int port = std::atoi(line.substr(std::string("metrics_port=").size()).c_str());
+			if (port > 0 && port < 65536)
+				metricsPort_ = port;
+		} else if (line.rfind("scene_collection=", 0) == 0) {
+			// 以降の rule= はこのシーンコレクションのもの（ルールが 0 件でもセクションは残す）
+			section = line.substr(std::string("scene_collection=").size());
+			collectionRules_[section];
 		} else if (line.rfind("rule=", 0) == 0) {
-			const std::string raw = line.substr(std::string("rule=").size());
+			// 解析は有効なシーンコレクションのものだけ（setActiveSceneCollection() で行う）
+			collectionRules_[section].push_back(line.substr(std::string("rule=").size()));
+		}
+	}
 
-			auto j = json::parse(raw, nullptr, false);
-			if (j.is_discarded()) {
-				blog(LOG_ERROR, "[obs-scene-switcher] Failed to parse rule JSON: %s", raw.c_str());
-				continue;
-			}
+	rewardRules_ = parseRuleLines(collectionRules_[activeCollectionSection()]);
+}
 
-			RewardRule r;
-			r.rewardId = j.value("reward_id", "");
-			r.sourceScene = j.value("source_scene", "");
-			r.targetScene = j.value("target_scene", "");
-			r.revertSeconds = j.value("revert_seconds", 0);
-			r.enabled = j.value("enabled", true);
-			if (r.rewardId.empty() || r.targetScene.empty())
-				continue;
+std::string ConfigManager::activeCollectionSection() const
+{
+	return collectionRules_.count(activeCollection_) ? activeCollection_ : std::string();
+}
 
-			rewardRules_.push_back(std::move(r));
-		}
-	}
+void ConfigManager::setActiveSceneCollection(const std::string &name)
+{
+	if (name == activeCollection_)
+		return;
+
+	stashActiveRules();
+	activeCollection_ = name;
+
+	const std::string section = activeCollectionSection();
+	rewardRules_ = parseRuleLines(collectionRules_[section]);
+
+	blog(LOG_INFO, "[obs-scene-switcher] Scene collection '%s': loaded %zu rules%s", name.c_str(),
+	     rewardRules_.size(), section.empty() && !name.empty() ? " (shared rules)" : "");
+}
+
+void ConfigManager::stashActiveRules()
+{
+	if (!rulesDirty_)
+		return;
+
+	std::vector<std::string> lines;
+	lines.reserve(rewardRules_.size());
+	for (const auto &r : rewardRules_)
+		lines.push_back(ruleToJson(r));
+
+	// 共通ルールを使っていたコレクションも、編集したら自分のセクションを持つ
+	collectionRules_[activeCollection_] = std::move(lines);
+	rulesDirty_ = false;
 }
 
 const std::string &ConfigManager::getClientId() const
@@ -351,6 +422,21 @@ const std::string &ConfigManager::getBroadcasterDisplayName() const
 void ConfigManager::setRewardRules(const std::vector<RewardRule> &rules)
 {
 	rewardRules_ = rules;
+	rulesDirty_ = true;
+}
+
+void ConfigManager::setRewardRules(const std::string &collection, const std::vector<RewardRule> &rules)
+{
+	if (collection == activeCollection_) {
+		setRewardRules(rules);
+		return;
+	}
+
+	std::vector<std::string> lines;
+	lines.reserve(rules.size());
+	for (const auto &r : rules)
+		lines.push_back(ruleToJson(r));
+	collectionRules_[collection] = std::move(lines);
 }
 
 const std::vector<RewardRule> &ConfigManager::getRewardRules() const
@@ -361,6 +447,7 @@ const std::vector<RewardRule> &ConfigManager::getRewardRules() const
 void ConfigManager::clearRewardRules()
 {
 	rewardRules_.clear();
+	rulesDirty_ = true;
 }
 
 void ConfigManager::setPluginEnabled(bool enabled)
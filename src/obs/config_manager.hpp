@@ -3,6 +3,7 @@
 // SPDX-License-Identifier: GPL-2.0-or-later
 
 #pragma once
+#include <map>
 #include <string>
 #include <unordered_map>
 
@@ -38,12 +39,47 @@ public:
 	const std::string &getBroadcasterLogin() const;
 	const std::string &getBroadcasterDisplayName() const;
 
+	// ルールはシーンコレクションごとに保存する。以下は有効なシーンコレクションのルール
 	const std::vector<RewardRule> &getRewardRules() const;
 	void setRewardRules(const std::vector<RewardRule> &rules);
-	void clearRewardRules();  // プラグイン有効状態（起動時は常にfalseを返す）
+	// 指定したシーンコレクションのルールを置き換える（有効なコレクション以外なら解析せずに保持する）
+	void setRewardRules(const std::string &collection, const std::vector<RewardRule> &rules);
+	void clearRewardRules();
+
+	// 有効なシーンコレクションを切り替え、そのルールだけを読み込む（他のコレクションは未解析のまま保持）
+	void setActiveSceneCollection(const std::string &name);
+	const std::string &getActiveSceneCollection() const { return activeCollection_; }
+
+	// プラグイン有効状態（起動時は常にfalseを返す）
 	bool getPluginEnabled() const { return false; }
 	void setPluginEnabled(bool enabled);
 
+	// 切替を次の OBS ビデオ tick に同期して適用する
+	bool getTickSyncSwitching() const { return tickSyncSwitching_; }
+	void setTickSyncSwitching(bool enabled) { tickSyncSwitching_ = enabled; }
+
+	// OBS 高負荷時に通常優先度のルールを延期する
+	bool getLoadAwareSwitching() const { return loadAwareSwitching_; }
+	void setLoadAwareSwitching(bool enabled) { loadAwareSwitching_ = enabled; }
+
+	// 引き換えを自動で FULFILLED / CANCELED に更新する（このクライアントで作った報酬のみ）
+	bool getRedemptionStatusUpdates() const { return redemptionStatusUpdates_; }
+	void setRedemptionStatusUpdates(bool enabled) { redemptionStatusUpdates_ = enabled; }
+
+	// ルールの種類に関係なく、実行後に次の実行を受け付けない秒数（0 なら制限なし）
+	int getGlobalCooldownSeconds() const { return globalCooldownSeconds_; }
+	void setGlobalCooldownSeconds(int seconds) { globalCooldownSeconds_ = seconds; }
+
+	// 無効中も EventSub のセッションとサブスクリプションを維持する（通知は捨てる。有効化が即時になる）
+	bool getEventSubStandby() const { return eventSubStandby_; }
+	void setEventSubStandby(bool enabled) { eventSubStandby_ = enabled; }
+
+	// localhost のメトリクスエンドポイント（Prometheus 形式）
+	bool getMetricsEnabled() const { return metricsEnabled_; }
+	void setMetricsEnabled(bool enabled) { metricsEnabled_ = enabled; }
+	int getMetricsPort() const { return metricsPort_; }
+	void setMetricsPort(int port) { metricsPort_ = port; }
+
 private:
 	ConfigManager();
 	~ConfigManager() = default;
@@ -51,6 +87,11 @@ private:
 	ConfigManager(const ConfigManager &) = delete;
 	ConfigManager &operator=(const ConfigManager &) = delete;
 
+	// 有効なコレクションの編集結果を未解析の行に戻す
+	void stashActiveRules();
+	// 有効なコレクションが使うセクション（自分のセクションがなければ共通ルールの ""）
+	std::string activeCollectionSection() const;
+
 	std::string configPath_;
 	std::string clientId_;
 	std::string clientSecret_;
@@ -63,6 +104,21 @@ private:
 	std::string broadcasterLogin_;
 	std::string streamerDisplayName_;
 
-	std::vector<RewardRule> rewardRules_;  // プラグイン有効状態（内部保持のみ、getPluginEnabled()は常にfalseを返す）
+	std::vector<RewardRule> rewardRules_;  // 有効なシーンコレクションのルール
+	// シーンコレクション名 → ルールの JSON 行（未解析）。空の名前はコレクション指定のない旧形式のルールで、
+	// 自分のセクションを持たないコレクションはこれを使う
+	std::map<std::string, std::vector<std::string>> collectionRules_;
+	std::string activeCollection_;
+	bool rulesDirty_ = false;  // rewardRules_ を collectionRules_ に書き戻す必要がある
+
+	// プラグイン有効状態（内部保持のみ、getPluginEnabled()は常にfalseを返す）
 	bool pluginEnabled_ = false;
+
+	bool tickSyncSwitching_ = false;
+	bool loadAwareSwitching_ = false;
+	bool redemptionStatusUpdates_ = false;
+	int globalCooldownSeconds_ = 0;
+	bool eventSubStandby_ = false;
+	bool metricsEnabled_ = false;
+	int metricsPort_ = 38916;
 };
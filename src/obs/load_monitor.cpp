@@ -0,0 +1,109 @@
+// obs-scene-switcher plugin
+// Copyright (C) 2025 ksmksks
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "load_monitor.hpp"
+
+#include <obs-module.h>
+#include <obs-frontend-api.h>
+#include <cstdio>
+
+// サンプリング間隔
+static constexpr int kSampleIntervalMs = 1000;
+// この値を超える輻輳度を高負荷とみなす
+static constexpr float kCongestionThreshold = 0.5f;
+
+void LoadMonitor::start()
+{
+	if (running_ || !scheduler_)
+		return;
+
+	running_ = true;
+	underLoad_ = false;
+	last_ = sample();
+	window_ = {};
+
+	tick();
+}
+
+void LoadMonitor::stop()
+{
+	running_ = false;
+	underLoad_ = false;
+	++generation_;
+}
+
+LoadMonitor::Sample LoadMonitor::sample()
+{
+	Sample s;
+	s.laggedFrames = obs_get_lagged_frames();
+	s.totalFrames = obs_get_total_frames();
+
+	if (video_t *video = obs_get_video())
+		s.skippedFrames = video_output_get_skipped_frames(video);
+
+	// 配信中の出力があれば輻輳度も取得
+	if (obs_output_t *output = obs_frontend_get_streaming_output()) {
+		if (obs_output_active(output)) {
+			s.hasOutput = true;
+			s.outputDroppedFrames = obs_output_get_frames_dropped(output);
+			s.outputCongestion = obs_output_get_congestion(output);
+		}
+		obs_output_release(output);
+	}
+
+	return s;
+}
+
+void LoadMonitor::tick()
+{
+	const uint64_t generation = generation_;
+	scheduler_(kSampleIntervalMs, [this, generation]() {
+		if (generation != generation_ || !running_)
+			return;
+
+		const Sample now = sample();
+
+		window_.laggedFrames = now.laggedFrames - last_.laggedFrames;
+		window_.totalFrames = now.totalFrames - last_.totalFrames;
+		window_.skippedFrames = now.skippedFrames - last_.skippedFrames;
+		window_.outputDroppedFrames = now.hasOutput && last_.hasOutput
+						      ? now.outputDroppedFrames - last_.outputDroppedFrames
+						      : 0;
+		window_.outputCongestion = now.outputCongestion;
+		window_.hasOutput = now.hasOutput;
+
+		const bool underLoad = window_.laggedFrames > 0 || window_.skippedFrames > 0 ||
+				       window_.outputDroppedFrames > 0 ||
+				       (now.hasOutput && now.outputCongestion > kCongestionThreshold);
+
+		if (underLoad != underLoad_)
+			blog(LOG_INFO, "[obs-scene-switcher] OBS load %s (%s)", underLoad ? "high" : "recovered",
+			     describe().c_str());
+
+		underLoad_ = underLoad;
+		last_ = now;
+
+		tick();
+	});
+}
+
+std::string LoadMonitor::describe() const
+{
+	char buf[160];
+	snprintf(buf, sizeof(buf), "lagged=%u/%u skipped=%u dropped=%d congestion=%.2f", window_.laggedFrames,
+		 window_.totalFrames, window_.skippedFrames, window_.outputDroppedFrames,
+		 window_.hasOutput ? window_.outputCongestion : 0.0f);
+	return buf;
+}
+
+std::string LoadMonitor::describeDelta(const Sample &before, const Sample &after)
+{
+	const int dropped = before.hasOutput && after.hasOutput ? after.outputDroppedFrames - before.outputDroppedFrames
+								: 0;
+
+	char buf[128];
+	snprintf(buf, sizeof(buf), "lagged=+%u skipped=+%u dropped=+%d", after.laggedFrames - before.laggedFrames,
+		 after.skippedFrames - before.skippedFrames, dropped);
+	return buf;
+}
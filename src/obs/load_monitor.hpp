@@ -0,0 +1,59 @@
+// obs-scene-switcher plugin
+// Copyright (C) 2025 ksmksks
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <string>
+
+/**
+ * OBS の描画・エンコード負荷を監視する
+ *
+ * - レンダリング遅延フレーム（lagged）とエンコードスキップフレーム（skipped）
+ * - 配信出力の輻輳度（congestion）とドロップフレーム
+ *
+ * 一定間隔でサンプリングし、直近の区間で遅延が発生していれば高負荷と判定する。
+ */
+class LoadMonitor {
+public:
+	struct Sample {
+		uint32_t laggedFrames = 0;
+		uint32_t totalFrames = 0;
+		uint32_t skippedFrames = 0;
+		int outputDroppedFrames = 0;
+		float outputCongestion = 0.0f;
+		bool hasOutput = false;
+	};
+
+	// 周期サンプリング用の遅延実行（SceneSwitcher のタイマーを借りる）
+	using Scheduler = std::function<void(int delayMs, std::function<void()>)>;
+
+	void setScheduler(Scheduler scheduler) { scheduler_ = std::move(scheduler); }
+
+	void start();
+	void stop();
+	bool isRunning() const { return running_; }
+
+	static Sample sample();
+
+	// 直近の区間で描画・エンコードが追いついていないか
+	bool isUnderLoad() const { return underLoad_; }
+
+	// 判定根拠をログ向けに整形
+	std::string describe() const;
+
+	// 2 つのサンプル間のフレーム落ち増分を整形
+	static std::string describeDelta(const Sample &before, const Sample &after);
+
+private:
+	void tick();
+
+	Scheduler scheduler_;
+	bool running_ = false;
+	uint64_t generation_ = 0;
+
+	Sample last_;
+	Sample window_;  // 直近区間の増分
+	bool underLoad_ = false;
+};
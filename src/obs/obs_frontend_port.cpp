@@ -0,0 +1,199 @@
+// obs-scene-switcher plugin
+// Copyright (C) 2025 ksmksks
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "obs_frontend_port.hpp"
+
+#include <obs-frontend-api.h>
+#include <obs-module.h>
+#include <cstring>
+
+ObsFrontendPort::~ObsFrontendPort()
+{
+	restoreTransitionOverride();
+}
+
+std::vector<std::string> ObsFrontendPort::sceneNames() const
+{
+	std::vector<std::string> names;
+
+	obs_frontend_source_list scenes = {};
+	obs_frontend_get_scenes(&scenes);
+
+	names.reserve(scenes.sources.num);
+	for (size_t i = 0; i < scenes.sources.num; i++) {
+		const char *name = obs_source_get_name(scenes.sources.array[i]);
+		names.emplace_back(name ? name : "");
+	}
+
+	obs_frontend_source_list_free(&scenes);
+	return names;
+}
+
+std::string ObsFrontendPort::currentScene() const
+{
+	obs_source_t *current = obs_frontend_get_current_scene();
+	if (!current)
+		return {};
+
+	const char *name = obs_source_get_name(current);
+	std::string sceneName = name ? name : "";
+
+	obs_source_release(current);
+	return sceneName;
+}
+
+bool ObsFrontendPort::setCurrentScene(const std::string &sceneName)
+{
+	obs_frontend_source_list scenes = {};
+	obs_frontend_get_scenes(&scenes);
+
+	bool found = false;
+	for (size_t i = 0; i < scenes.sources.num; i++) {
+		obs_source_t *src = scenes.sources.array[i];
+		const char *name = obs_source_get_name(src);
+
+		if (name && sceneName == name) {
+			obs_frontend_set_current_scene(src);
+			found = true;
+			break;
+		}
+	}
+
+	obs_frontend_source_list_free(&scenes);
+	return found;
+}
+
+int ObsFrontendPort::transitionDurationMs() const
+{
+	return obs_frontend_get_transition_duration();
+}
+
+bool ObsFrontendPort::isCutTransition() const
+{
+	obs_source_t *transition = obs_frontend_get_current_transition();
+	const char *id = transition ? obs_source_get_unversioned_id(transition) : nullptr;
+	const bool isCut = id && strcmp(id, "cut_transition") == 0;
+	obs_source_release(transition);
+	return isCut;
+}
+
+void ObsFrontendPort::compileTransitions(std::vector<RewardRule> &rules)
+{
+	transitions_.compile(rules);
+}
+
+bool ObsFrontendPort::applyTransitionOverride(const RewardRule &rule)
+{
+	// 直前の差し替えが残っていれば先に戻す
+	restoreTransitionOverride();
+
+	if (rule.transitionSlot < 0)
+		return false;
+
+	// 延期・ステージング中に再解決された古いスロットは使わない
+	obs_source_t *transition = transitions_.get(rule.transitionSlot);
+	const char *transitionName = transition ? obs_source_get_name(transition) : nullptr;
+	if (!transitionName || rule.transitionName != transitionName) {
+		obs_source_release(transition);
+		blog(LOG_WARNING, "[obs-scene-switcher] Transition for '%s' is no longer available: %s",
+		     ruleLabel(rule).c_str(), rule.transitionName.c_str());
+		return false;
+	}
+
+	TransitionOverride saved;
+	saved.previous = obs_frontend_get_current_transition();
+	saved.previousDurationMs = obs_frontend_get_transition_duration();
+	transitionOverride_ = saved;
+
+	obs_frontend_set_current_transition(transition);
+	if (rule.transitionDurationMs > 0)
+		obs_frontend_set_transition_duration(rule.transitionDurationMs);
+
+	blog(LOG_DEBUG, "[obs-scene-switcher] Transition override for '%s': %s (%d ms)", ruleLabel(rule).c_str(),
+	     transitionName, obs_frontend_get_transition_duration());
+
+	obs_source_release(transition);
+	return true;
+}
+
+void ObsFrontendPort::restoreTransitionOverride()
+{
+	if (!transitionOverride_)
+		return;
+
+	if (transitionOverride_->previous) {
+		obs_frontend_set_current_transition(transitionOverride_->previous);
+		obs_source_release(transitionOverride_->previous);
+	}
+	obs_frontend_set_transition_duration(transitionOverride_->previousDurationMs);
+
+	transitionOverride_.reset();
+}
+
+uint64_t ObsFrontendPort::videoFrameTimeNs() const
+{
+	return obs_get_video_frame_time();
+}
+
+uint64_t ObsFrontendPort::frameIntervalNs() const
+{
+	obs_video_info ovi;
+	if (obs_get_video_info(&ovi) && ovi.fps_num > 0)
+		return 1000000000ULL * ovi.fps_den / ovi.fps_num;
+	return 0;
+}
+
+std::optional<bool> ObsFrontendPort::setSceneItemVisible(const std::string &sceneName, const std::string &sourceName,
+							  bool visible)
+{
+	obs_source_t *sceneSource = obs_get_source_by_name(sceneName.c_str());
+	obs_scene_t *scene = sceneSource ? obs_scene_from_source(sceneSource) : nullptr;
+	obs_sceneitem_t *item = scene ? obs_scene_find_source_recursive(scene, sourceName.c_str()) : nullptr;
+
+	std::optional<bool> previous;
+	if (item) {
+		previous = obs_sceneitem_visible(item);
+		obs_sceneitem_set_visible(item, visible);
+	}
+
+	obs_source_release(sceneSource);
+	return previous;
+}
+
+std::optional<bool> ObsFrontendPort::setFilterEnabled(const std::string &sourceName, const std::string &filterName,
+						       bool enabled)
+{
+	obs_source_t *source = obs_get_source_by_name(sourceName.c_str());
+	obs_source_t *filter = source ? obs_source_get_filter_by_name(source, filterName.c_str()) : nullptr;
+	obs_source_release(source);
+
+	if (!filter)
+		return std::nullopt;
+
+	const bool previous = obs_source_enabled(filter);
+	obs_source_set_enabled(filter, enabled);
+	obs_source_release(filter);
+	return previous;
+}
+
+bool ObsFrontendPort::restartMedia(const std::string &sourceName)
+{
+	obs_source_t *source = obs_get_source_by_name(sourceName.c_str());
+	if (!source || !(obs_source_get_output_flags(source) & OBS_SOURCE_CONTROLLABLE_MEDIA)) {
+		obs_source_release(source);
+		return false;
+	}
+
+	obs_source_media_restart(source);
+	obs_source_release(source);
+	return true;
+}
+
+void ObsFrontendPort::stopMedia(const std::string &sourceName)
+{
+	obs_source_t *source = obs_get_source_by_name(sourceName.c_str());
+	if (source)
+		obs_source_media_stop(source);
+	obs_source_release(source);
+}
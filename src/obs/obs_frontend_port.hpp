@@ -0,0 +1,53 @@
+// obs-scene-switcher plugin
+// Copyright (C) 2025 ksmksks
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+#include "core/frontend_port.hpp"
+#include "transition_cache.hpp"
+#include <obs.h>
+#include <optional>
+
+/**
+ * FrontendPort の OBS 実装（obs_frontend_* / libobs を呼ぶ）
+ *
+ * - ルール指定のトランジションは TransitionCache で解決し、差し替え前の状態をここで保持する
+ */
+class ObsFrontendPort : public FrontendPort {
+public:
+	ObsFrontendPort() = default;
+	~ObsFrontendPort() override;
+
+	ObsFrontendPort(const ObsFrontendPort &) = delete;
+	ObsFrontendPort &operator=(const ObsFrontendPort &) = delete;
+
+	std::vector<std::string> sceneNames() const override;
+	std::string currentScene() const override;
+	bool setCurrentScene(const std::string &name) override;
+
+	int transitionDurationMs() const override;
+	bool isCutTransition() const override;
+	void compileTransitions(std::vector<RewardRule> &rules) override;
+	bool applyTransitionOverride(const RewardRule &rule) override;
+	void restoreTransitionOverride() override;
+
+	uint64_t videoFrameTimeNs() const override;
+	uint64_t frameIntervalNs() const override;
+
+	std::optional<bool> setSceneItemVisible(const std::string &scene, const std::string &source,
+						bool visible) override;
+	std::optional<bool> setFilterEnabled(const std::string &source, const std::string &filter,
+					     bool enabled) override;
+	bool restartMedia(const std::string &source) override;
+	void stopMedia(const std::string &source) override;
+
+private:
+	// 差し替え前のトランジション（強参照）と長さ
+	struct TransitionOverride {
+		obs_source_t *previous = nullptr;
+		int previousDurationMs = 0;
+	};
+
+	TransitionCache transitions_;
+	std::optional<TransitionOverride> transitionOverride_;
+};
@@ -0,0 +1,274 @@
+// obs-scene-switcher plugin
+// Copyright (C) 2025 ksmksks
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "scene_prewarmer.hpp"
+
+#include <obs-module.h>
+#include <algorithm>
+#include <cstring>
+
+// CPU 使用率の増分を計測する間隔
+static constexpr int kMeasureDelayMs = 3000;
+
+ScenePrewarmer::~ScenePrewarmer()
+{
+	release();
+
+	if (cpuInfo_) {
+		os_cpu_usage_info_destroy(cpuInfo_);
+		cpuInfo_ = nullptr;
+	}
+}
+
+void ScenePrewarmer::warm(const std::vector<RewardRule> &rules)
+{
+	std::vector<std::string> desired;
+	for (const auto &rule : rules) {
+		if (!rule.enabled || !rule.prewarm || rule.targetScene.empty())
+			continue;
+		if (std::find(desired.begin(), desired.end(), rule.targetScene) == desired.end())
+			desired.push_back(rule.targetScene);
+	}
+
+	// 不要になったシーンの保温を解除
+	for (auto it = warmScenes_.begin(); it != warmScenes_.end();) {
+		if (std::find(desired.begin(), desired.end(), it->name) != desired.end()) {
+			++it;
+			continue;
+		}
+
+		blog(LOG_INFO, "[obs-scene-switcher] Pre-warm released: %s", it->name.c_str());
+		dropScene(*it);
+		it = warmScenes_.erase(it);
+	}
+
+	// 未保温のシーンを計測キューへ
+	for (const auto &name : desired) {
+		if (isWarm(name))
+			continue;
+		if (std::find(pending_.begin(), pending_.end(), name) != pending_.end())
+			continue;
+		pending_.push_back(name);
+	}
+
+	if (pending_.empty() || measuring_)
+		return;
+
+	measuring_ = true;
+
+	if (!scheduler_) {
+		warmNext();
+		return;
+	}
+
+	// 保温前の CPU 使用率をベースラインとして取得してから開始
+	if (!cpuInfo_)
+		cpuInfo_ = os_cpu_usage_info_start();
+	os_cpu_usage_info_query(cpuInfo_);
+
+	const uint64_t generation = generation_;
+	scheduler_(kMeasureDelayMs, [this, generation]() {
+		if (generation != generation_)
+			return;
+		lastCpuPercent_ = os_cpu_usage_info_query(cpuInfo_);
+		warmNext();
+	});
+}
+
+void ScenePrewarmer::release()
+{
+	++generation_;
+	measuring_ = false;
+	pending_.clear();
+
+	for (auto &scene : warmScenes_)
+		dropScene(scene);
+
+	if (!warmScenes_.empty())
+		blog(LOG_INFO, "[obs-scene-switcher] Pre-warm released for %zu scenes", warmScenes_.size());
+
+	warmScenes_.clear();
+}
+
+bool ScenePrewarmer::isWarm(const std::string &sceneName) const
+{
+	return std::any_of(warmScenes_.begin(), warmScenes_.end(),
+			   [&](const WarmScene &scene) { return scene.name == sceneName; });
+}
+
+void ScenePrewarmer::warmNext()
+{
+	while (!pending_.empty()) {
+		const std::string name = pending_.front();
+		pending_.erase(pending_.begin());
+
+		obs_source_t *source = obs_get_source_by_name(name.c_str());
+		if (!source || !obs_source_is_scene(source)) {
+			blog(LOG_WARNING, "[obs-scene-switcher] Pre-warm skipped, scene not found: %s", name.c_str());
+			obs_source_release(source);
+			continue;
+		}
+
+		WarmScene scene;
+		scene.name = name;
+		scene.source = source;
+		scene.paused = std::make_unique<PausedMedia>();
+
+		obs_source_inc_showing(source);
+		prerollMedia(source, *scene.paused);
+		signal_handler_connect(obs_source_get_signal_handler(source), "activate", &ScenePrewarmer::onSceneActivate,
+				       scene.paused.get());
+
+		scene.cost = inspect(source);
+		warmScenes_.push_back(std::move(scene));
+
+		if (!scheduler_) {
+			logCost(warmScenes_.back());
+			continue;
+		}
+
+		// シーンを 1 つ保温するごとに CPU 使用率の増分を計測
+		const uint64_t generation = generation_;
+		scheduler_(kMeasureDelayMs, [this, generation, name]() {
+			if (generation != generation_)
+				return;
+			finishMeasurement(name);
+			warmNext();
+		});
+		return;
+	}
+
+	measuring_ = false;
+}
+
+void ScenePrewarmer::finishMeasurement(const std::string &sceneName)
+{
+	const double cpu = os_cpu_usage_info_query(cpuInfo_);
+
+	for (auto &scene : warmScenes_) {
+		if (scene.name != sceneName)
+			continue;
+
+		scene.cost.cpuPercentDelta = cpu - lastCpuPercent_;
+		scene.cost.cpuMeasured = true;
+		logCost(scene);
+		break;
+	}
+
+	lastCpuPercent_ = cpu;
+}
+
+ScenePrewarmer::WarmCost ScenePrewarmer::inspect(obs_source_t *scene)
+{
+	WarmCost cost;
+
+	obs_source_enum_full_tree(
+		scene,
+		[](obs_source_t *, obs_source_t *child, void *param) {
+			auto *cost = static_cast<WarmCost *>(param);
+			cost->sourceCount++;
+
+			const char *id = obs_source_get_unversioned_id(child);
+			const uint32_t flags = obs_source_get_output_flags(child);
+
+			if (id && strcmp(id, "browser_source") == 0)
+				cost->browserSources++;
+			if (flags & OBS_SOURCE_CONTROLLABLE_MEDIA)
+				cost->mediaSources++;
+
+			// シーン・グループは合成結果なので個別テクスチャとして数えない
+			if ((flags & OBS_SOURCE_VIDEO) && !obs_source_is_scene(child) && !obs_source_is_group(child)) {
+				const uint64_t w = obs_source_get_width(child);
+				const uint64_t h = obs_source_get_height(child);
+				cost->textureBytes += w * h * 4;
+			}
+		},
+		&cost);
+
+	return cost;
+}
+
+void ScenePrewarmer::prerollMedia(obs_source_t *scene, PausedMedia &paused)
+{
+	std::lock_guard<std::mutex> lock(paused.mutex);
+	obs_source_enum_full_tree(
+		scene,
+		[](obs_source_t *, obs_source_t *child, void *param) {
+			if (!(obs_source_get_output_flags(child) & OBS_SOURCE_CONTROLLABLE_MEDIA))
+				return;
+			// オンエア中のシーンと共有しているソースは巻き戻さない（再生を終えた映像が先頭に戻って見える）
+			if (obs_source_active(child))
+				return;
+
+			// 停止中のメディアは先頭フレームまでデコードして一時停止しておく
+			switch (obs_source_media_get_state(child)) {
+			case OBS_MEDIA_STATE_NONE:
+			case OBS_MEDIA_STATE_STOPPED:
+			case OBS_MEDIA_STATE_ENDED:
+				obs_source_media_restart(child);
+				obs_source_media_play_pause(child, true);
+				static_cast<PausedMedia *>(param)->sources.push_back(obs_source_get_weak_source(child));
+				break;
+			default:
+				break;
+			}
+		},
+		&paused);
+}
+
+void ScenePrewarmer::onSceneActivate(void *data, calldata_t *)
+{
+	auto *paused = static_cast<PausedMedia *>(data);
+	std::lock_guard<std::mutex> lock(paused->mutex);
+
+	// 切替先としてオンエアになったら、一時停止しておいたメディアを先頭から再生する
+	for (obs_weak_source_t *weak : paused->sources) {
+		obs_source_t *child = obs_weak_source_get_source(weak);
+		if (child && obs_source_media_get_state(child) == OBS_MEDIA_STATE_PAUSED)
+			obs_source_media_play_pause(child, false);
+		obs_source_release(child);
+		obs_weak_source_release(weak);
+	}
+	paused->sources.clear();
+}
+
+void ScenePrewarmer::dropScene(WarmScene &scene)
+{
+	// 切断後はシグナルのコールバックが走らない（libobs がシグナルごとのロックで待ち合わせる）
+	signal_handler_disconnect(obs_source_get_signal_handler(scene.source), "activate",
+				  &ScenePrewarmer::onSceneActivate, scene.paused.get());
+
+	{
+		std::lock_guard<std::mutex> lock(scene.paused->mutex);
+		for (obs_weak_source_t *weak : scene.paused->sources) {
+			obs_source_t *child = obs_weak_source_get_source(weak);
+			// 保温で一時停止したまま誰も触っていなければ、元の停止状態に戻す
+			if (child && !obs_source_active(child) &&
+			    obs_source_media_get_state(child) == OBS_MEDIA_STATE_PAUSED)
+				obs_source_media_stop(child);
+			obs_source_release(child);
+			obs_weak_source_release(weak);
+		}
+		scene.paused->sources.clear();
+	}
+
+	obs_source_dec_showing(scene.source);
+	obs_source_release(scene.source);
+}
+
+void ScenePrewarmer::logCost(const WarmScene &scene)
+{
+	const WarmCost &cost = scene.cost;
+	const double textureMiB = static_cast<double>(cost.textureBytes) / (1024.0 * 1024.0);
+
+	if (cost.cpuMeasured) {
+		blog(LOG_INFO,
+		     "[obs-scene-switcher] Pre-warmed '%s': sources=%zu browser=%zu media=%zu texture=%.1f MiB cpu=%+.1f%%",
+		     scene.name.c_str(), cost.sourceCount, cost.browserSources, cost.mediaSources, textureMiB,
+		     cost.cpuPercentDelta);
+	} else {
+		blog(LOG_INFO, "[obs-scene-switcher] Pre-warmed '%s': sources=%zu browser=%zu media=%zu texture=%.1f MiB",
+		     scene.name.c_str(), cost.sourceCount, cost.browserSources, cost.mediaSources, textureMiB);
+	}
+}
@@ -0,0 +1,84 @@
+// obs-scene-switcher plugin
+// Copyright (C) 2025 ksmksks
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+#include "core/reward_rule.hpp"
+#include <obs.h>
+#include <util/platform.h>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * ルールの切替先シーンを事前に「表示中」状態にしておく
+ *
+ * - obs_source_inc_showing() で子ソース（ブラウザ・メディア）を起動済みにする
+ * - 停止中のメディアソースは先頭フレームまでデコードして一時停止しておく（オンエア中のものは触らない）。
+ *   一時停止したものはシーンがアクティブになったら再生し、保温を解除したら停止に戻す
+ * - シーンごとのメモリ概算と CPU 使用率の増分をログに出力する
+ */
+class ScenePrewarmer {
+public:
+	struct WarmCost {
+		size_t sourceCount = 0;
+		size_t browserSources = 0;
+		size_t mediaSources = 0;
+		uint64_t textureBytes = 0;  // 映像ソースのテクスチャサイズ概算
+		double cpuPercentDelta = 0.0;
+		bool cpuMeasured = false;
+	};
+
+	// 計測用の遅延実行（SceneSwitcher のタイマーを借りる）
+	using Scheduler = std::function<void(int delayMs, std::function<void()>)>;
+
+	ScenePrewarmer() = default;
+	~ScenePrewarmer();
+
+	ScenePrewarmer(const ScenePrewarmer &) = delete;
+	ScenePrewarmer &operator=(const ScenePrewarmer &) = delete;
+
+	void setScheduler(Scheduler scheduler) { scheduler_ = std::move(scheduler); }
+
+	// prewarm が有効なルールの切替先シーンを保温（不要になったシーンは解放）
+	void warm(const std::vector<RewardRule> &rules);
+
+	// すべての保温を解除
+	void release();
+
+	bool isWarm(const std::string &sceneName) const;
+
+private:
+	// 保温のために一時停止したメディア（activate シグナルはレンダリング側のスレッドからも届くため mutex で守る）
+	struct PausedMedia {
+		std::mutex mutex;
+		std::vector<obs_weak_source_t *> sources;
+	};
+
+	struct WarmScene {
+		std::string name;
+		obs_source_t *source = nullptr;  // 強参照（release 時に解放）
+		WarmCost cost;
+		std::unique_ptr<PausedMedia> paused;  // シーンの activate シグナルに渡すのでアドレスを固定する
+	};
+
+	void warmNext();
+	void finishMeasurement(const std::string &sceneName);
+	static WarmCost inspect(obs_source_t *scene);
+	static void prerollMedia(obs_source_t *scene, PausedMedia &paused);
+	static void onSceneActivate(void *data, calldata_t *cd);
+	// activate シグナルを外し、まだ一時停止のままのメディアを停止に戻してから参照を解放する
+	static void dropScene(WarmScene &scene);
+	static void logCost(const WarmScene &scene);
+
+	std::vector<WarmScene> warmScenes_;
+	std::vector<std::string> pending_;  // 計測のため 1 シーンずつ順に保温する
+	bool measuring_ = false;
+	uint64_t generation_ = 0;
+
+	os_cpu_usage_info_t *cpuInfo_ = nullptr;
+	double lastCpuPercent_ = 0.0;
+	Scheduler scheduler_;
+};
@@ -3,177 +3,129 @@
 // SPDX-License-Identifier: GPL-2.0-or-later
 
 #include "scene_switcher.hpp"
-#include <obs-frontend-api.h>
-#include <obs-module.h>
+#include <algorithm>
 
-SceneSwitcher::SceneSwitcher(QObject *parent) : QObject(parent)
+SceneSwitcher::SceneSwitcher(QObject *parent) : QObject(parent), engine_(frontend_)
 {
-	revertTimer_.setSingleShot(true);
-	connect(&revertTimer_, &QTimer::timeout, this, &SceneSwitcher::onRevertTimeout);
+	// 長時間の復帰でもずれないよう、期限は engine_ の TimerWheel が単調時計で管理する
+	wheelTimer_.setSingleShot(true);
+	wheelTimer_.setTimerType(Qt::PreciseTimer);
+	connect(&wheelTimer_, &QTimer::timeout, this, [this]() { engine_.advanceTimers(); });
 	countdownTimer_.setInterval(1000);
 	connect(&countdownTimer_, &QTimer::timeout, this, &SceneSwitcher::onCountdownTick);
+
+	engine_.setWakeupCallback([this](std::optional<TimerWheel::Clock::time_point> next) { armWheelTimer(next); });
+	engine_.setStateCallback([this](State state, int remainingSeconds, const std::string &targetScene,
+					const std::string &originalScene) {
+		onEngineStateChanged(state, remainingSeconds, targetScene, originalScene);
+	});
 }
 
 SceneSwitcher::~SceneSwitcher()
 {
+	// 破棄中の engine_ から Qt 側へ通知させない
+	engine_.setStateCallback(nullptr);
+	engine_.setWakeupCallback(nullptr);
 }
 
 QStringList SceneSwitcher::getSceneList()
 {
 	QStringList list;
-
-	obs_frontend_source_list scenes = {};
-	obs_frontend_get_scenes(&scenes);
-
-	for (size_t i = 0; i < scenes.sources.num; i++) {
-		obs_source_t *src = scenes.sources.array[i];
-		const char *name = obs_source_get_name(src);
-		list << QString::fromUtf8(name);
-	}
-
-	obs_frontend_source_list_free(&scenes);
-
+	for (const auto &name : frontend_.sceneNames())
+		list << QString::fromStdString(name);
 	return list;
 }
 
-void SceneSwitcher::switchScene(const std::string &sceneName)
+void SceneSwitcher::switchScene(const std::string &sceneName, const std::string &label)
 {
-	blog(LOG_DEBUG, "[obs-scene-switcher] switchScene(%s)", sceneName.c_str());
-
-	obs_frontend_source_list scenes = {};
-	obs_frontend_get_scenes(&scenes);
-
-	for (size_t i = 0; i < scenes.sources.num; i++) {
-		obs_source_t *src = scenes.sources.array[i];
-		const char *name = obs_source_get_name(src);
-
-		if (sceneName == name) {
-			obs_frontend_set_current_scene(src);
-			blog(LOG_DEBUG, "[obs-scene-switcher] Scene switched to %s", name);
-			break;
-		}
-	}
-
-	obs_frontend_source_list_free(&scenes);
+	engine_.switchScene(sceneName, label);
 }
 
 void SceneSwitcher::switchWithRevert(const RewardRule &rule)
 {
-	const bool hasRevert = rule.revertSeconds > 0;
+	engine_.switchWithRevert(rule);
+}
 
-	switch (state_) {
-	case State::Idle:
-		break;
+void SceneSwitcher::runActions(const RewardRule &rule)
+{
+	engine_.runActions(rule);
+}
 
-	case State::Switched:
-	case State::Reverting:
-		// 抑制状態を一時的に表示するが、タイマーは継続
-		blog(LOG_DEBUG, "[obs-scene-switcher] Request suppressed - timer continues");
-		emit stateChanged(State::Suppressed, revertTimer_.remainingTime() / 1000, currentTargetScene_, originalScene_);
-		
-		// 一定時間後に Switched 状態に戻す（UI表示のため）
-		QTimer::singleShot(1000, this, [this]() {
-			if (state_ == State::Switched) {
-				int remaining = revertTimer_.remainingTime() / 1000;
-				emit stateChanged(State::Switched, remaining, currentTargetScene_, originalScene_);
-			}
-		});
-		return;
+void SceneSwitcher::revertNow()
+{
+	engine_.revertNow();
+}
 
-	case State::Suppressed:
-		// 既に抑制中なら何もしない
-		return;
-	}
+QString SceneSwitcher::getCurrentSceneName() const
+{
+	return QString::fromStdString(frontend_.currentScene());
+}
 
-	originalScene_ = getCurrentSceneName();
-	currentTargetScene_ = QString::fromStdString(rule.targetScene);
+TimerWheel::TimerId SceneSwitcher::scheduleAfter(std::chrono::milliseconds delay, TimerWheel::Callback callback)
+{
+	return engine_.scheduleAfter(delay, std::move(callback));
+}
 
-	blog(LOG_DEBUG, "[obs-scene-switcher] Switching to '%s'%s", rule.targetScene.c_str(),
-	     hasRevert ? "" : " (no revert)");
+bool SceneSwitcher::cancelTimer(TimerWheel::TimerId id)
+{
+	return engine_.cancelTimer(id);
+}
 
-	switchScene(rule.targetScene);
+void SceneSwitcher::compileTransitions(std::vector<RewardRule> &rules)
+{
+	engine_.compileTransitions(rules);
+}
 
-	if (!hasRevert) {
-		state_ = State::Idle;
-		emit stateChanged(State::Idle);
-		return;
-	}
+void SceneSwitcher::handleFrontendEvent(enum obs_frontend_event event)
+{
+	switch (event) {
+	case OBS_FRONTEND_EVENT_SCENE_CHANGED:
+		engine_.onSceneChanged();
+		break;
 
-	state_ = State::Switched;
-	totalRevertSeconds_ = rule.revertSeconds;
-	emit stateChanged(State::Switched, totalRevertSeconds_, currentTargetScene_, originalScene_);
+	case OBS_FRONTEND_EVENT_TRANSITION_STOPPED:
+		engine_.onTransitionStopped();
+		break;
 
-	revertTimer_.start(rule.revertSeconds * 1000);
-	countdownTimer_.start();
+	default:
+		break;
+	}
 }
 
-QString SceneSwitcher::getCurrentSceneName() const
+void SceneSwitcher::onEngineStateChanged(State state, int remainingSeconds, const std::string &targetScene,
+					 const std::string &originalScene)
 {
-	obs_source_t *current = obs_frontend_get_current_scene();
-	if (!current)
-		return {};
-
-	const char *name = obs_source_get_name(current);
-	QString sceneName = name ? name : "";
-
-	obs_source_release(current);
-	return sceneName;
+	// カウントダウン表示は Switched の間だけ 1 秒ごとに更新する
+	if (state == State::Switched && !countdownTimer_.isActive())
+		countdownTimer_.start();
+	else if (state == State::Idle || state == State::Reverting)
+		countdownTimer_.stop();
+
+	emit stateChanged(state, remainingSeconds, QString::fromStdString(targetScene),
+			  QString::fromStdString(originalScene));
 }
 
 void SceneSwitcher::onCountdownTick()
 {
 	// Switched 状態の時のみカウントダウンを更新
-	if (state_ != State::Switched)
+	if (engine_.state() != State::Switched)
 		return;
-	
-	int remaining = revertTimer_.remainingTime() / 1000;
-	if (remaining >= 0) {
-		emit stateChanged(State::Switched, remaining, currentTargetScene_, originalScene_);
-	}
-}
 
-void SceneSwitcher::onRevertTimeout()
-{
-	countdownTimer_.stop();
-	
-	// タイマーが終了した時に Switched 状態でない場合は Idle に戻す
-	if (state_ != State::Switched && state_ != State::Suppressed) {
-		state_ = State::Idle;
-		emit stateChanged(State::Idle);
-		return;
+	int remaining = engine_.remainingRevertSeconds();
+	if (remaining >= 0) {
+		emit stateChanged(State::Switched, remaining, QString::fromStdString(engine_.targetScene()),
+				  QString::fromStdString(engine_.originalScene()));
 	}
-
-	state_ = State::Reverting;
-	emit stateChanged(State::Reverting, -1, originalScene_, QString());
-
-	blog(LOG_DEBUG, "[obs-scene-switcher] Reverting to previous scene: %s", originalScene_.toStdString().c_str());
-
-	switchScene(originalScene_.toStdString());
-
-	state_ = State::Idle;
-	emit stateChanged(State::Idle);
 }
 
-void SceneSwitcher::revertNow()
+void SceneSwitcher::armWheelTimer(std::optional<TimerWheel::Clock::time_point> next)
 {
-	// Manual revert: only valid in Switched state
-	if (state_ != State::Switched) {
-		blog(LOG_DEBUG, "[obs-scene-switcher] revertNow() called but not in Switched state");
+	if (!next) {
+		wheelTimer_.stop();
 		return;
 	}
 
-	blog(LOG_DEBUG, "[obs-scene-switcher] Manual revert requested");
-
-	// Stop timers
-	revertTimer_.stop();
-	countdownTimer_.stop();
-
-	// Perform revert
-	state_ = State::Reverting;
-	emit stateChanged(State::Reverting, -1, originalScene_, QString());
-
-	switchScene(originalScene_.toStdString());
-
-	state_ = State::Idle;
-	emit stateChanged(State::Idle);
+	// 次の期限（またはカスケード時刻）まで眠る。切り上げないと期限の直前に起きて 0 ms で張り直し続ける
+	const auto wait = std::chrono::ceil<std::chrono::milliseconds>(*next - TimerWheel::Clock::now());
+	wheelTimer_.start(static_cast<int>(std::max<long long>(0, wait.count())));
 }
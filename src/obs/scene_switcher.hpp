@@ -4,45 +4,67 @@
 
 #pragma once
 #include "core/reward_rule.hpp"
+#include "core/switch_engine.hpp"
+#include "core/timer_wheel.hpp"
+#include "obs_frontend_port.hpp"
+#include <obs-frontend-api.h>
 #include <QObject>
 #include <QTimer>
 #include <QString>
 #include <QStringList>
+#include <unordered_map>
 
+/**
+ * SwitchEngine を Qt のイベントループと OBS フロントエンドにつなぐラッパー
+ *
+ * - 切替の State Machine 本体は core/switch_engine（OBS・Qt 非依存）
+ * - タイマーの駆動、カウントダウン表示、状態通知の signal 化をここで行う
+ */
 class SceneSwitcher : public QObject {
 	Q_OBJECT
 
 public:
+	using State = SwitchEngine::State;
+	using SwitchLatency = SwitchEngine::SwitchLatency;
+
 	explicit SceneSwitcher(QObject *parent = nullptr);
 	~SceneSwitcher() override;
 
-	enum class State {
-		Idle,
-		Switched,
-		Reverting,
-		Suppressed
-	};
-
 	QStringList getSceneList();
-	void switchScene(const std::string &sceneName);
+	void switchScene(const std::string &sceneName, const std::string &label = {});
 	void switchWithRevert(const RewardRule &rule);
+	// ルールの切替先シーンと追加アクションを実行
+	void runActions(const RewardRule &rule);
 	void revertNow();
 	QString getCurrentSceneName() const;
+	State state() const { return engine_.state(); }
+
+	// 単調時計ベースのタイマー（復帰以外の遅延処理もここに登録する）
+	TimerWheel::TimerId scheduleAfter(std::chrono::milliseconds delay, TimerWheel::Callback callback);
+	bool cancelTimer(TimerWheel::TimerId id);
+
+	// ルールのトランジション指定を解決（ルール更新時・トランジション一覧の変更時）
+	void compileTransitions(std::vector<RewardRule> &rules);
+
+	// OBS フロントエンドイベント（シーン切替の着地確認）
+	void handleFrontendEvent(enum obs_frontend_event event);
+
+	const std::unordered_map<std::string, SwitchLatency> &switchLatency() const { return engine_.switchLatency(); }
 
 signals:
 	// シーン名を含む詳細な状態通知
-	void stateChanged(State newState, int remainingSeconds = -1, 
-	                  const QString &targetScene = QString(), 
+	void stateChanged(SceneSwitcher::State newState, int remainingSeconds = -1,
+	                  const QString &targetScene = QString(),
 	                  const QString &originalScene = QString());
 
 private:
-	void onRevertTimeout();
+	void onEngineStateChanged(State state, int remainingSeconds, const std::string &targetScene,
+				  const std::string &originalScene);
 	void onCountdownTick();
+	void armWheelTimer(std::optional<TimerWheel::Clock::time_point> next);
 
-	State state_ = State::Idle;
-	QString originalScene_;
-	QString currentTargetScene_;
-	QTimer revertTimer_;
+	ObsFrontendPort frontend_;
+	SwitchEngine engine_;
+	QTimer wheelTimer_;  // 次の期限で engine_ のタイマーを進めるための駆動タイマー
 	QTimer countdownTimer_;
-	int totalRevertSeconds_ = 0;
 };
@@ -0,0 +1,86 @@
+// obs-scene-switcher plugin
+// Copyright (C) 2025 ksmksks
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "tick_scheduler.hpp"
+#include "core/metrics.hpp"
+
+#include <obs-module.h>
+#include <util/platform.h>
+#include <QMetaObject>
+
+TickScheduler::TickScheduler(QObject *parent) : QObject(parent)
+{
+	obs_add_tick_callback(&TickScheduler::onTick, this);
+
+	auto &registry = metrics::Registry::instance();
+	registry.registerHistogram("scene_switcher_stage_to_tick_seconds", "Staged switch to next video tick",
+				   &stageToTick_);
+	registry.registerHistogram("scene_switcher_tick_to_apply_seconds", "Video tick to switch applied on UI thread",
+				   &tickToApply_);
+}
+
+TickScheduler::~TickScheduler()
+{
+	obs_remove_tick_callback(&TickScheduler::onTick, this);
+
+	auto &registry = metrics::Registry::instance();
+	registry.unregisterHistogram(&stageToTick_);
+	registry.unregisterHistogram(&tickToApply_);
+}
+
+void TickScheduler::stage(std::function<void()> apply)
+{
+	{
+		std::lock_guard<std::mutex> lk(mutex_);
+		// 同じフレームに届いた通知（レイドの連続引き換えなど）も捨てずに順に実行する。
+		// 引き換えは実行前に FULFILLED を積んでいるため、置き換えると実行されないまま消費される
+		pending_.push_back({std::move(apply), os_gettime_ns()});
+	}
+
+	staged_.store(true, std::memory_order_release);
+}
+
+void TickScheduler::onTick(void *param, float)
+{
+	auto *self = static_cast<TickScheduler *>(param);
+
+	// 通常の tick では atomic の読み取りのみ
+	if (!self->staged_.load(std::memory_order_acquire))
+		return;
+
+	self->takeStaged();
+}
+
+void TickScheduler::takeStaged()
+{
+	std::vector<Staged> staged;
+	{
+		std::lock_guard<std::mutex> lk(mutex_);
+		staged.swap(pending_);
+		staged_.store(false, std::memory_order_relaxed);
+	}
+
+	if (staged.empty())
+		return;
+
+	const uint64_t tickNs = os_gettime_ns();
+	for (const auto &entry : staged)
+		stageToTick_.record((tickNs - entry.stagedAtNs) / 1000);
+
+	// obs_frontend_* は UI スレッドから呼ぶ必要があるため転送する
+	QMetaObject::invokeMethod(
+		this,
+		[this, staged = std::move(staged), tickNs]() {
+			const uint64_t delayUs = (os_gettime_ns() - tickNs) / 1000;
+			tickToApply_.record(delayUs);
+
+			blog(LOG_DEBUG,
+			     "[obs-scene-switcher] Tick-synchronized switch applied (%zu staged, tick-to-apply %.2f ms)",
+			     staged.size(), delayUs / 1000.0);
+
+			for (const auto &entry : staged)
+				entry.apply();
+		},
+		Qt::QueuedConnection);
+}
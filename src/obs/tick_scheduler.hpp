@@ -0,0 +1,50 @@
+// obs-scene-switcher plugin
+// Copyright (C) 2025 ksmksks
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+#include "core/latency_histogram.hpp"
+#include <QObject>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+/**
+ * 切替処理を次の OBS ビデオ tick に同期して適用する
+ *
+ * - stage() で切替処理を登録（UI スレッド）
+ * - obs_add_tick_callback のコールバック（グラフィックススレッド）で取り出し、
+ *   UI スレッドへ転送して適用する
+ * - 登録から tick まで、tick から適用までの遅延を計測する
+ */
+class TickScheduler : public QObject {
+	Q_OBJECT
+
+public:
+	explicit TickScheduler(QObject *parent = nullptr);
+	~TickScheduler() override;
+
+	// 次の tick で apply を実行する（同じ tick までに登録した処理は登録順にすべて実行する）
+	void stage(std::function<void()> apply);
+
+	const LatencyHistogram &stageToTick() const { return stageToTick_; }
+	const LatencyHistogram &tickToApply() const { return tickToApply_; }
+
+private:
+	static void onTick(void *param, float seconds);
+	void takeStaged();
+
+	std::atomic<bool> staged_{false};
+	struct Staged {
+		std::function<void()> apply;
+		uint64_t stagedAtNs = 0;
+	};
+
+	std::mutex mutex_;
+	std::vector<Staged> pending_;
+
+	LatencyHistogram stageToTick_;
+	LatencyHistogram tickToApply_;
+};
@@ -0,0 +1,84 @@
+// obs-scene-switcher plugin
+// Copyright (C) 2025 ksmksks
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "transition_cache.hpp"
+
+#include <obs-frontend-api.h>
+#include <obs-module.h>
+
+TransitionCache::~TransitionCache()
+{
+	clear();
+}
+
+void TransitionCache::compile(std::vector<RewardRule> &rules)
+{
+	clear();
+
+	bool needed = false;
+	for (auto &rule : rules) {
+		rule.transitionSlot = -1;
+		needed = needed || !rule.transitionName.empty();
+	}
+
+	if (!needed)
+		return;
+
+	obs_frontend_source_list transitions = {};
+	obs_frontend_get_transitions(&transitions);
+
+	for (auto &rule : rules) {
+		if (rule.transitionName.empty())
+			continue;
+
+		// 同じトランジションを参照するルールはスロットを共有する
+		for (size_t i = 0; i < entries_.size(); ++i) {
+			if (entries_[i].name == rule.transitionName) {
+				rule.transitionSlot = static_cast<int>(i);
+				break;
+			}
+		}
+		if (rule.transitionSlot >= 0)
+			continue;
+
+		for (size_t i = 0; i < transitions.sources.num; ++i) {
+			obs_source_t *transition = transitions.sources.array[i];
+			const char *name = obs_source_get_name(transition);
+			if (!name || rule.transitionName != name)
+				continue;
+
+			Entry entry;
+			entry.name = rule.transitionName;
+			entry.weak = obs_source_get_weak_source(transition);
+			entries_.push_back(std::move(entry));
+			rule.transitionSlot = static_cast<int>(entries_.size() - 1);
+			break;
+		}
+
+		if (rule.transitionSlot < 0) {
+			blog(LOG_WARNING, "[obs-scene-switcher] Transition not found for '%s': %s",
+			     ruleLabel(rule).c_str(), rule.transitionName.c_str());
+		}
+	}
+
+	obs_frontend_source_list_free(&transitions);
+
+	blog(LOG_DEBUG, "[obs-scene-switcher] Resolved %zu rule transitions", entries_.size());
+}
+
+obs_source_t *TransitionCache::get(int slot) const
+{
+	if (slot < 0 || static_cast<size_t>(slot) >= entries_.size())
+		return nullptr;
+
+	return obs_weak_source_get_source(entries_[slot].weak);
+}
+
+void TransitionCache::clear()
+{
+	for (auto &entry : entries_)
+		obs_weak_source_release(entry.weak);
+
+	entries_.clear();
+}
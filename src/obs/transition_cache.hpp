@@ -0,0 +1,42 @@
+// obs-scene-switcher plugin
+// Copyright (C) 2025 ksmksks
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+#include "core/reward_rule.hpp"
+#include <obs.h>
+#include <string>
+#include <vector>
+
+/**
+ * ルールごとのトランジション指定を事前に解決しておくキャッシュ
+ *
+ * - compile() でルールが参照するトランジションを一度だけ列挙・解決し、
+ *   ルールにはスロット番号（RewardRule::transitionSlot）だけを持たせる
+ * - 切替時は get() でスロットから取り出すだけで、名前による検索は行わない
+ * - ハンドルは弱参照で保持する（トランジションが削除された場合は nullptr）
+ */
+class TransitionCache {
+public:
+	TransitionCache() = default;
+	~TransitionCache();
+
+	TransitionCache(const TransitionCache &) = delete;
+	TransitionCache &operator=(const TransitionCache &) = delete;
+
+	// ルールのトランジション名を解決し transitionSlot を設定する
+	void compile(std::vector<RewardRule> &rules);
+
+	// スロットのトランジションを強参照で返す（呼び出し側で release が必要）
+	obs_source_t *get(int slot) const;
+
+	void clear();
+
+private:
+	struct Entry {
+		std::string name;
+		obs_weak_source_t *weak = nullptr;
+	};
+
+	std::vector<Entry> entries_;
+};
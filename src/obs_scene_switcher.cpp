@@ -7,11 +7,27 @@
 #include "ui/plugin_dock.hpp"
 #include "ui/dock_main_widget.hpp"
 #include "obs/config_manager.hpp"
+#include "obs/scene_prewarmer.hpp"
+#include "obs/tick_scheduler.hpp"
+#include "obs/load_monitor.hpp"
 #include "oauth/http_server.hpp"
 #include "eventsub/eventsub_client.hpp"
+#include "net/network.hpp"
 #include "i18n/locale_manager.hpp"
+#include "core/trace.hpp"
+#include "core/metrics.hpp"
+#include "core/executor.hpp"
+#include "core/startup_profiler.hpp"
+#include "core/rule_engine.hpp"
+#include "core/rule_predicates.hpp"
+#include "core/redemption_batcher.hpp"
+#include "core/cooldown_table.hpp"
+#include "core/combo_tracker.hpp"
 
 #include <obs-frontend-api.h>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
 
 // OBS logging
 extern "C" {
@@ -20,6 +36,16 @@ extern "C" {
 
 ObsSceneSwitcher *ObsSceneSwitcher::s_instance_ = nullptr;
 
+// 高負荷時に延期したルールの再判定間隔と最大延期時間
+static constexpr int kDeferredCheckMs = 500;
+static constexpr int kMaxDeferMs = 5000;
+// 切替後のフレーム落ち増分を計測するまでの時間
+static constexpr int kFrameDropProbeMs = 2000;
+// 引き換えの状態更新をまとめる時間
+static constexpr int kRedemptionFlushMs = 250;
+// 終了時に積んだ状態更新を送り終えるまで待つ最長時間（OBS の終了を長く止めない）
+static constexpr int kShutdownDrainMs = 500;
+
 ObsSceneSwitcher *ObsSceneSwitcher::instance()
 {
 	if (!s_instance_) {
@@ -43,6 +69,35 @@ ObsSceneSwitcher::ObsSceneSwitcher()
 	sceneSwitcher_ = std::make_unique<SceneSwitcher>(this);  // SceneSwitcher の状態変更を UI に転送
 	connect(sceneSwitcher_.get(), &SceneSwitcher::stateChanged, 
 	        this, &ObsSceneSwitcher::onSceneSwitcherStateChanged);
+
+	tickScheduler_ = std::make_unique<TickScheduler>(this);
+
+	loadMonitor_ = std::make_unique<LoadMonitor>();
+	loadMonitor_->setScheduler([this](int delayMs, std::function<void()> task) {
+		sceneSwitcher_->scheduleAfter(std::chrono::milliseconds(delayMs), std::move(task));
+	});
+
+	prewarmer_ = std::make_unique<ScenePrewarmer>();
+	prewarmer_->setScheduler([this](int delayMs, std::function<void()> task) {
+		sceneSwitcher_->scheduleAfter(std::chrono::milliseconds(delayMs), std::move(task));
+	});
+
+	cooldowns_ = std::make_unique<CooldownTable>();
+	combos_ = std::make_unique<ComboTracker>();
+
+	redemptionBatcher_ = std::make_unique<RedemptionBatcher>(kRedemptionFlushMs);
+	redemptionBatcher_->setScheduler([this](int delayMs, std::function<void()> task) {
+		sceneSwitcher_->scheduleAfter(std::chrono::milliseconds(delayMs), std::move(task));
+	});
+	redemptionBatcher_->setSender([this](const std::string &rewardId, const std::vector<std::string> &ids,
+					     RedemptionStatus status, std::function<void(int)> done) {
+		// 完了はネットワークスレッドで呼ばれるため UI スレッドへ戻す
+		TwitchOAuth::instance().updateRedemptionStatusAsync(
+			rewardId, ids, redemptionStatusName(status), [this, done](int httpStatus) {
+				QMetaObject::invokeMethod(this, [done, httpStatus]() { done(httpStatus); },
+							  Qt::QueuedConnection);
+			});
+	});
 }
 
 ObsSceneSwitcher::~ObsSceneSwitcher()
@@ -54,77 +109,150 @@ void ObsSceneSwitcher::start()
 {
 	blog(LOG_DEBUG, "[obs-scene-switcher] Initializing plugin");
 
-	// Dock 生成・登録
-	PluginDock *dock = PluginDock::instance();
-	PluginDock::registerDock();
-
-	// UI 更新のための signal-slot 接続
-	QObject::connect(this, // ObsSceneSwitcher (signal発信元)
-			 &ObsSceneSwitcher::authenticationSucceeded,
-			 dock, // PluginDock (UI側)
-			 &PluginDock::onAuthenticationSucceeded,
-			 Qt::QueuedConnection // UIスレッド保証
-	);
-	QObject::connect(this, // ObsSceneSwitcher (signal発信元)
-			 &ObsSceneSwitcher::authenticationFailed,
-			 dock, // PluginDock (UI側)
-			 &PluginDock::onAuthenticationFailed,
-			 Qt::QueuedConnection // UIスレッド保証
-	);
-	QObject::connect(this, // ObsSceneSwitcher (signal発信元)
-			 &ObsSceneSwitcher::loggedOut,
-			 dock, // PluginDock (UI側)
-			 &PluginDock::onLoggedOut,
-			 Qt::QueuedConnection // UIスレッド保証
-	);
-	QObject::connect(&EventSubClient::instance(),
-                         &EventSubClient::redemptionReceived, this,
-			 &ObsSceneSwitcher::onRedemptionReceived,
-			 Qt::QueuedConnection // UIスレッド保証
-	);
-
-	// 認証設定をロード
-	reloadAuthConfig();
-	loadConfig();
+	using Affinity = startup::TaskGraph::Affinity;
+
+	// 起動時の並行ロード用
+	startupExecutor_ = std::make_unique<Executor>(2, "startup");
+
+	// OBS 起動をブロックする処理のみをタスクグラフで実行する
+	// 設定のロード（DPAPI 復号）とロケールのロードはファイル I/O のみで互いに独立しているため並行に実行する
+	startup::TaskGraph graph;
+	const auto configTask = graph.add("config", Affinity::Pool, []() { ConfigManager::instance(); });
+	const auto localeTask = graph.add("locale", Affinity::Pool, []() { LocaleManager::instance(); });
+	graph.add("network", Affinity::Pool, []() { Network::instance().start(); });
+
+	// Dock 生成・登録（Qt ウィジェットは UI スレッドで生成する）
+	const auto dockTask = graph.add("dock", Affinity::Caller, [this]() {
+		PluginDock *dock = PluginDock::instance();
+		PluginDock::registerDock();
+
+		// UI 更新のための signal-slot 接続
+		QObject::connect(this, // ObsSceneSwitcher (signal発信元)
+				 &ObsSceneSwitcher::authenticationSucceeded,
+				 dock, // PluginDock (UI側)
+				 &PluginDock::onAuthenticationSucceeded,
+				 Qt::QueuedConnection // UIスレッド保証
+		);
+		QObject::connect(this, // ObsSceneSwitcher (signal発信元)
+				 &ObsSceneSwitcher::authenticationFailed,
+				 dock, // PluginDock (UI側)
+				 &PluginDock::onAuthenticationFailed,
+				 Qt::QueuedConnection // UIスレッド保証
+		);
+		QObject::connect(this, // ObsSceneSwitcher (signal発信元)
+				 &ObsSceneSwitcher::loggedOut,
+				 dock, // PluginDock (UI側)
+				 &PluginDock::onLoggedOut,
+				 Qt::QueuedConnection // UIスレッド保証
+		);
+	}, {configTask, localeTask});
+
+	graph.add("callbacks", Affinity::Caller, [this]() {
+		QObject::connect(&EventSubClient::instance(),
+				 &EventSubClient::eventReceived, this,
+				 &ObsSceneSwitcher::onEventReceived,
+				 Qt::DirectConnection // 照合は WebSocket のスレッドで行う
+		);
+		QObject::connect(&EventSubClient::instance(), &EventSubClient::subscriptionsArmed, this,
+				 &ObsSceneSwitcher::onEventSubArmed, Qt::QueuedConnection);
+
+		// OBS イベントコールバック登録（切替確認のため認証状態に関わらず登録）
+		setupObsCallbacks();
+
+		// トレースのダンプ（ツールメニュー項目は解除 API がないため起動時に 1 度だけ登録）
+		obs_frontend_add_tools_menu_item(Tr("SceneSwitcher.Menu.DumpTrace").toUtf8().constData(),
+						 &ObsSceneSwitcher::onDumpTraceMenu, this);
+	}, {localeTask});
+
+	graph.add("rules", Affinity::Caller, [this]() {
+		// 認証設定をロード
+		reloadAuthConfig();
+		loadConfig();
+
+		// 現在のシーンコレクションのルールをロード
+		loadSceneCollectionRules();
+		blog(LOG_DEBUG, "[obs-scene-switcher] Loaded %zu reward rules from config", ruleSet_.load()->rules.size());
+	}, {configTask, dockTask});
+
+	graph.run(*startupExecutor_);
 
 	auto &cfg = ConfigManager::instance();
-	
-	// ルールをロード
-	setRewardRules(cfg.getRewardRules());
-	blog(LOG_DEBUG, "[obs-scene-switcher] Loaded %zu reward rules from config", rewardRules_.size());
 
+	// メトリクス（オプション。認証に問題があるときこそ見たいので、認証状態に関わらず開始する）
+	{
+		startup::Profiler::Scope phase("metrics", true);
+		updateMetricsServer();
+	}
 
         // 初回 or 未設定
 	if (!cfg.isAuthValid()) {
 		blog(LOG_DEBUG, "[obs-scene-switcher] No valid authentication ");
 		authenticated_ = false;
 		emit authenticationFailed();
+		// 未ログインでも起動フェーズは実行しているため計測結果を出す
+		reportStartupProfile();
 		return;
 	}
 
-	// 期限切れならトークン更新
-	if (cfg.isTokenExpired()) {
-		blog(LOG_DEBUG, "[obs-scene-switcher] Token expired, attempting refresh");
-		if (!TwitchOAuth::instance().refreshAccessToken()) {
-			blog(LOG_ERROR, "[obs-scene-switcher] Token refresh failed");
-			authenticated_ = false;
-			emit authenticationFailed();
-			return;
-		}
-		cfg.save();
-		blog(LOG_DEBUG, "[obs-scene-switcher] Token refreshed successfully");
+	// トークンが有効ならこの時点で認証済みとする
+	if (!cfg.isTokenExpired()) {
+		onStartupAuthFinished(true);
+		return;
+	}
+
+	// 期限切れならトークン更新（ネットワークスレッドで実行し、結果は UI スレッドへ戻す）
+	blog(LOG_DEBUG, "[obs-scene-switcher] Token expired, attempting refresh");
+	const auto refreshStart = startup::Clock::now();
+	TwitchOAuth::instance().refreshAccessTokenAsync([this, refreshStart](bool success, const TokenSet &tokens) {
+		startup::Profiler::instance().record("token_refresh", refreshStart, startup::Clock::now(), false);
+
+		QMetaObject::invokeMethod(this, [this, success, tokens]() {
+			if (success) {
+				accessToken_ = tokens.accessToken;
+				refreshToken_ = tokens.refreshToken;
+				expiresAt_ = tokens.expiresAt;
+				saveConfig();
+				blog(LOG_DEBUG, "[obs-scene-switcher] Token refreshed successfully");
+			}
+			onStartupAuthFinished(success);
+		}, Qt::QueuedConnection);
+	});
+}
+
+void ObsSceneSwitcher::onStartupAuthFinished(bool success)
+{
+	if (!success) {
+		blog(LOG_ERROR, "[obs-scene-switcher] Token refresh failed");
+		authenticated_ = false;
+		emit authenticationFailed();
+		reportStartupProfile();
+		return;
 	}
 
 	// 認証成功
 	authenticated_ = true;
 	blog(LOG_DEBUG, "[obs-scene-switcher] Authentication successful");
 	emit authenticationSucceeded();
-	
-	// チャンネルポイント一覧を取得
-	fetchRewardList();
+	updateEventSubStandby();
+
+	// チャンネルポイント一覧を取得（完了時に起動プロファイルを出力）
+	const auto fetchStart = startup::Clock::now();
+	fetchRewardList([this, fetchStart]() {
+		startup::Profiler::instance().record("reward_fetch", fetchStart, startup::Clock::now(), false);
+		reportStartupProfile();
+	});
+}
+
+void ObsSceneSwitcher::reportStartupProfile()
+{
+	auto &profiler = startup::Profiler::instance();
+	const int64_t blockingUs = profiler.blockingUs();
+	const std::string summary = profiler.summary();
+
+	blog(LOG_INFO, "[obs-scene-switcher] Startup profile:\n%s", summary.c_str());
 
-	// OBS イベントコールバック登録
-	setupObsCallbacks();
+	if (pluginDock_ && blockingUs >= 0)
+		pluginDock_->updateStartupInfo(blockingUs, QString::fromStdString(summary));
 }
 
 void ObsSceneSwitcher::stop()
@@ -135,21 +263,55 @@ void ObsSceneSwitcher::stop()
 	removeObsCallbacks();
 	
 	disconnectEventSub();
+
+	// 溜まっている状態更新を送る（延期中の引き換えはポイントを返す）
+	dropDeferredRule();
+	redemptionBatcher_->flush();
+
+	// 積んだ状態更新を短時間だけ送らせてから、通信中のリクエストを中断し、以降の完了コールバックを止める
+	Network::instance().stop(std::chrono::milliseconds(kShutdownDrainMs));
+
+	if (startupExecutor_)
+		startupExecutor_->shutdown();
+
+	prewarmer_->release();
+
+	// HTTP サーバーはモジュール解放前に確実に停止する（スレッドを join する）
+	metricsServer_.reset();
+	HttpServer::instance()->stop();
 }
 
 void ObsSceneSwitcher::handleOAuthCallback(const std::string &code)
 {
 	blog(LOG_DEBUG, "[obs-scene-switcher] Received code: %s", code.c_str());
 
-	if (!TwitchOAuth::instance().exchangeCodeForToken(code)) {
+	// HTTP サーバーのスレッドから呼ばれるため、設定の読み取りを含めて UI スレッドで開始する
+	QMetaObject::invokeMethod(this, [this, code]() {
+		TwitchOAuth::instance().exchangeCodeForTokenAsync(
+			code, [this](bool success, const TokenSet &tokens, const TwitchUser &user) {
+				QMetaObject::invokeMethod(this, [this, success, tokens, user]() {
+					onOAuthLoginFinished(success, tokens, user);
+				}, Qt::QueuedConnection);
+			});
+	}, Qt::QueuedConnection);
+}
+
+void ObsSceneSwitcher::onOAuthLoginFinished(bool success, const TokenSet &tokens, const TwitchUser &user)
+{
+	if (!success) {
 		blog(LOG_ERROR, "[obs-scene-switcher] OAuth token exchange failed");
 		return;
 	}
 
-	// 結果を読み取る
-	accessToken_ = TwitchOAuth::instance().getAccessToken();
-	refreshToken_ = TwitchOAuth::instance().getRefreshToken();
-	expiresAt_ = TwitchOAuth::instance().getExpiresAt();
+	// 結果を反映
+	auto &cfg = ConfigManager::instance();
+	cfg.setBroadcasterUserId(user.id);
+	cfg.setBroadcasterLogin(user.login);
+	cfg.setBroadcasterDisplayName(user.displayName);
+
+	accessToken_ = tokens.accessToken;
+	refreshToken_ = tokens.refreshToken;
+	expiresAt_ = tokens.expiresAt;
 
 	authenticated_ = true;
 
@@ -158,6 +320,7 @@ void ObsSceneSwitcher::handleOAuthCallback(const std::string &code)
 	blog(LOG_DEBUG, "[obs-scene-switcher] OAuth authentication successful");
 
 	emit authenticationSucceeded();
+	updateEventSubStandby();
 	
 	// チャンネルポイント一覧を取得
 	fetchRewardList();
@@ -177,6 +340,8 @@ void ObsSceneSwitcher::logout()
 	if (pluginEnabled_) {
 		setEnabled(false);
 	}
+	// 待機中の接続も切る
+	disconnectEventSub();
 
 	// 認証情報をクリア
 	accessToken_.clear();
@@ -186,6 +351,7 @@ void ObsSceneSwitcher::logout()
 
 	// リワードリストをクリア
 	rewardList_.clear();
+	redemptionBatcher_->clear();
 
 	saveConfig();
 	
@@ -225,6 +391,39 @@ void ObsSceneSwitcher::disconnectEventSub()
 	EventSubClient::instance().stop();
 }
 
+void ObsSceneSwitcher::updateEventSubStandby()
+{
+	// 有効中は常に接続している
+	if (pluginEnabled_)
+		return;
+
+	if (ConfigManager::instance().getEventSubStandby() && isAuthenticated()) {
+		if (!eventsubConnected_) {
+			blog(LOG_INFO, "[obs-scene-switcher] EventSub standby: keeping the session armed while disabled");
+			connectEventSub();
+		}
+	} else {
+		disconnectEventSub();
+	}
+}
+
+void ObsSceneSwitcher::onEventSubArmed()
+{
+	// 有効化を待っている間に揃ったときだけ報告する（待機中・再接続で揃ったものは数えない）
+	if (!awaitingArm_ || !pluginEnabled_)
+		return;
+	awaitingArm_ = false;
+
+	const auto elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+				       std::chrono::steady_clock::now() - armRequestedAt_)
+				       .count();
+	blog(LOG_INFO, "[obs-scene-switcher] EventSub armed %lld ms after enabling (%s)",
+	     static_cast<long long>(elapsedMs), armFromStandby_ ? "warm standby" : "cold connect");
+
+	if (pluginDock_)
+		pluginDock_->updateArmInfo(elapsedMs, armFromStandby_);
+}
+
 void ObsSceneSwitcher::setEnabled(bool enabled)
 {
 	if (pluginEnabled_ == enabled)
@@ -235,9 +434,23 @@ void ObsSceneSwitcher::setEnabled(bool enabled)
 	if (enabled) {
 		// 認証済みの場合のみ接続
 		if (isAuthenticated()) {
+			// 待機中の接続があればそのまま使う（サブスクリプションが揃っていれば有効化は即時）
+			armFromStandby_ = eventsubConnected_;
+			armRequestedAt_ = std::chrono::steady_clock::now();
+			awaitingArm_ = true;
 			pluginEnabled_ = true;
-			connectEventSub();  // UI 状態更新（待機中）
-			
+			if (!eventsubConnected_)
+				connectEventSub();
+			if (EventSubClient::instance().isArmed())
+				onEventSubArmed();
+
+			// 切替先シーンの事前保温
+			prewarmer_->warm(ruleSet_.load()->rules);
+
+			if (ConfigManager::instance().getLoadAwareSwitching())
+				loadMonitor_->start();
+
+			// UI 状態更新（待機中）
 			if (pluginDock_) {
 				auto *mainWidget = pluginDock_->getWidget()->findChild<DockMainWidget*>();
 				if (mainWidget) {
@@ -250,14 +463,19 @@ void ObsSceneSwitcher::setEnabled(bool enabled)
 			return;
 		}
 	} else {
-		// 完全停止
+		// 停止（待機オプションが有効なら EventSub は切らず、届いた通知は捨てる）
 		pluginEnabled_ = false;
-		disconnectEventSub();
+		awaitingArm_ = false;
+		updateEventSubStandby();
+		prewarmer_->release();
+		loadMonitor_->stop();
+		dropDeferredRule();
 		
 		if (pluginDock_) {
 			auto *mainWidget = pluginDock_->getWidget()->findChild<DockMainWidget*>();
 			if (mainWidget) {
-				mainWidget->updateState(Tr("SceneSwitcher.Status.Disabled"));
+				mainWidget->updateState(Tr(eventsubConnected_ ? "SceneSwitcher.Status.Standby"
+									       : "SceneSwitcher.Status.Disabled"));
 				mainWidget->updateCountdown(-1);
 			}
 		}
@@ -271,56 +489,255 @@ void ObsSceneSwitcher::setEnabled(bool enabled)
 	emit enabledStateChanged(pluginEnabled_);
 }
 
-void ObsSceneSwitcher::onRedemptionReceived(const std::string &rewardId, const std::string &userName,
-					    const std::string &userInput)
+void ObsSceneSwitcher::onEventReceived(const TwitchEvent &event, qint64 ageMs)
 {
-	blog(LOG_DEBUG, "[obs-scene-switcher] Redemption received: %s", rewardId.c_str());
+	const auto *redemption = std::get_if<RedemptionEvent>(&event);
+	const std::string rewardId = redemption ? redemption->rewardId : std::string();
+	const int64_t kind = static_cast<int64_t>(event.index());
+
+	// ホットパスでは書式化しない（トレースに記録し、ダンプ時に書式化する）
+	SS_TRACE_DEBUG(trace::Event::RedemptionReceived, kind, 0, 0, rewardId);
+	auto &registry = metrics::Registry::instance();
+	registry.eventsReceived[event.index()].inc();
+	if (redemption)
+		registry.redemptionsReceived.inc();
 	
 	// プラグインが無効の場合は無視
 	if (!pluginEnabled_) {
-		blog(LOG_DEBUG, "[obs-scene-switcher] Plugin disabled, ignoring redemption");
+		SS_TRACE_DEBUG(trace::Event::RedemptionIgnored, kind, 0, 0, rewardId);
 		return;
 	}
 
-	// 現在のシーン名を取得
-	QString currentScene = sceneSwitcher_->getCurrentSceneName();
-	std::string currentSceneStr = currentScene.toStdString();
-	
-	blog(LOG_DEBUG, "[obs-scene-switcher] Current scene: %s", currentSceneStr.c_str());
+	// 上から順にルールを検索（最初の有効なマッチを優先）。ルールの保存と並行してもスナップショットは変わらない
+	RuleSetPtr ruleSet = ruleSet_.load();
+	const auto currentScene = currentScene_.load();
+	const RewardRule *rule = matchRule(ruleSet->rules, event, *currentScene);
+
+	// 再接続・OBS の停止で遅れて届いた通知では実行しない（引き換えは実行しなかったものとしてポイントを返す）
+	if (rule && rule->maxEventAgeSeconds > 0 && ageMs > static_cast<qint64>(rule->maxEventAgeSeconds) * 1000) {
+		registry.staleEventsDropped.inc();
+		SS_TRACE_INFO(trace::Event::RuleStale, static_cast<int64_t>(rule - ruleSet->rules.data()), ageMs,
+			      static_cast<int64_t>(rule->maxEventAgeSeconds) * 1000);
+		blog(LOG_INFO, "[obs-scene-switcher] Rule '%s' skipped: notification is %lld ms old (limit %d s)",
+		     ruleLabel(*rule).c_str(), static_cast<long long>(ageMs), rule->maxEventAgeSeconds);
+		rule = nullptr;
+	}
+
+	// UI スレッドに渡すのはマッチした通知と、状態更新が必要になりうる引き換えだけ
+	if (!rule && !redemption)
+		return;
+
+	QMetaObject::invokeMethod(
+		this, [this, ruleSet = std::move(ruleSet), rule, event]() { onRuleMatched(ruleSet, rule, event); },
+		Qt::QueuedConnection);
+}
 
-	// 上から順にルールを検索（最初の有効なマッチを優先）
-	for (const auto &rule : rewardRules_) {
-		if (rule.rewardId != rewardId)
-			continue;
+void ObsSceneSwitcher::onRuleMatched(const RuleSetPtr &ruleSet, const RewardRule *rule, const TwitchEvent &event)
+{
+	// 照合後に無効化された
+	if (!pluginEnabled_)
+		return;
 
-		// ルールが無効の場合は次のルールへ
-		if (!rule.enabled) {
-			blog(LOG_DEBUG, "[obs-scene-switcher] Rule for reward_id=%s is disabled, checking to next rule", rewardId.c_str());
-			continue;
+	auto &cfg = ConfigManager::instance();
+	auto &registry = metrics::Registry::instance();
+	const int64_t ruleIndex = rule ? static_cast<int64_t>(rule - ruleSet->rules.data()) : -1;
+
+	// コンボルールは揃うまで実行しない（数えた通知は受け付けたものとして扱い、揃ったら 1 回だけ実行する）
+	bool absorbed = false;
+	bool comboCompleted = false;
+	if (rule && rule->combo.enabled()) {
+		comboCompleted = combos_->record(*rule, event);
+		SS_TRACE_DEBUG(trace::Event::RuleCombo, ruleIndex, comboCompleted ? 1 : 0);
+		if (!comboCompleted) {
+			registry.comboEventsAbsorbed.inc();
+			absorbed = true;
 		}
+	}
 
-		// ソースシーンのチェック
-		// 空文字列または "Any" の場合は任意のシーンにマッチ
-		bool sourceMatches = rule.sourceScene.empty() || 
-		                     rule.sourceScene == "Any" || 
-		                     rule.sourceScene == currentSceneStr;
-		
-		if (!sourceMatches) {
-			blog(LOG_DEBUG, "[obs-scene-switcher] Source scene mismatch: rule requires '%s', current is '%s'", 
-			     rule.sourceScene.c_str(), currentSceneStr.c_str());
-			continue;
+	// クールダウン中のルールは実行しない（引き換えは実行しなかったものとして状態を更新する）
+	if (rule && !absorbed) {
+		const auto rejection = cooldowns_->tryAcquire(*rule, event, cfg.getGlobalCooldownSeconds());
+		if (rejection) {
+			registry.cooldownRejected[static_cast<size_t>(rejection->scope)].inc();
+			SS_TRACE_INFO(trace::Event::RuleCooldown, ruleIndex, static_cast<int64_t>(rejection->scope),
+				      rejection->remainingMs);
+			blog(LOG_INFO, "[obs-scene-switcher] Rule '%s' skipped: %s cooldown (%d ms left)",
+			     ruleLabel(*rule).c_str(), cooldownScopeName(rejection->scope), rejection->remainingMs);
+
+			// 揃ったコンボは捨てずにウィンドウに残し、この通知も数えたものとして扱う
+			// （クールダウン明けに次の通知で揃えば実行する）
+			if (comboCompleted) {
+				registry.comboEventsAbsorbed.inc();
+				absorbed = true;
+			} else {
+				rule = nullptr;
+			}
+		} else if (comboCompleted) {
+			combos_->consume(*rule);
+			registry.combosCompleted.inc();
+			blog(LOG_INFO, "[obs-scene-switcher] Combo completed for '%s' (%d %s in %d s)",
+			     ruleLabel(*rule).c_str(), rule->combo.count, rule->combo.distinctUsers ? "users" : "events",
+			     rule->combo.windowSeconds);
+		}
+	}
+
+	const auto *redemption = std::get_if<RedemptionEvent>(&event);
+	const RedemptionEvent *statusRedemption =
+		redemption && cfg.getRedemptionStatusUpdates() ? redemption : nullptr;
+
+	if (rule && !absorbed) {
+		dispatchRule(*rule, statusRedemption);
+		return;
+	}
+
+	// ルールに登録していない報酬には触れない
+	if (statusRedemption &&
+	    (rule || std::any_of(ruleSet->rules.begin(), ruleSet->rules.end(), [redemption](const RewardRule &r) {
+		     return r.trigger == EventKind::Redemption && r.rewardId == redemption->rewardId;
+	     })))
+		queueRedemptionStatus(*statusRedemption, rule, absorbed);
+}
+
+void ObsSceneSwitcher::queueRedemptionStatus(const RedemptionEvent &event, const RewardRule *rule, bool countedInCombo)
+{
+	// 実行されない引き換え（元シーン不一致・古い通知・クールダウン・抑制・延期後の破棄）はポイントを返す。
+	// シーン切替だけのルールは切替中なら抑制される（tick 同期で次の tick に実行されるもの、コンボに数えたものは
+	// 受付時点の判断で FULFILLED とする。延期したものは実行・破棄が決まってから更新する）
+	const bool suppressed = rule && !countedInCombo && !rule->targetScene.empty() && rule->actions.empty() &&
+				sceneSwitcher_->state() != SceneSwitcher::State::Idle;
+	const RedemptionStatus status =
+		rule && !suppressed ? RedemptionStatus::Fulfilled : RedemptionStatus::Canceled;
+
+	redemptionBatcher_->enqueue(event.rewardId, event.id, status);
+}
+
+void ObsSceneSwitcher::dispatchRule(const RewardRule &rule, const RedemptionEvent *redemption)
+{
+	auto &cfg = ConfigManager::instance();
+
+	if (cfg.getLoadAwareSwitching()) {
+		if (!loadMonitor_->isRunning())
+			loadMonitor_->start();
+
+		// 高負荷時は通常優先度のルールを延期する
+		if (loadMonitor_->isUnderLoad()) {
+			if (!rule.highPriority) {
+				deferRule(rule, redemption);
+				return;
+			}
+
+			blog(LOG_INFO, "[obs-scene-switcher] High-priority rule '%s' runs under load (%s)",
+			     ruleLabel(rule).c_str(), loadMonitor_->describe().c_str());
 		}
+	}
+
+	// 切替中かどうかは実行前の状態で判断する
+	if (redemption)
+		queueRedemptionStatus(*redemption, &rule);
+	executeRule(rule);
+}
+
+void ObsSceneSwitcher::executeRule(const RewardRule &rule)
+{
+	// 切替判断を次のビデオ tick で適用（オプション）
+	if (ConfigManager::instance().getTickSyncSwitching()) {
+		tickScheduler_->stage([this, rule]() { applyRule(rule); });
+		return;
+	}
+
+	applyRule(rule);
+}
+
+void ObsSceneSwitcher::applyRule(const RewardRule &rule)
+{
+	// 発火回数は実際に実行したときだけ数える（コンボ・クールダウン・延期で止まったものは含めない）
+	if (rule.firedCounter)
+		rule.firedCounter->inc();
+
+	if (!ConfigManager::instance().getLoadAwareSwitching()) {
+		sceneSwitcher_->runActions(rule);
+		return;
+	}
+
+	// 切替によるフレーム落ちの増分を記録
+	const LoadMonitor::Sample before = LoadMonitor::sample();
+	sceneSwitcher_->runActions(rule);
+
+	const std::string label = ruleLabel(rule);
+	sceneSwitcher_->scheduleAfter(std::chrono::milliseconds(kFrameDropProbeMs), [label, before]() {
+		const LoadMonitor::Sample after = LoadMonitor::sample();
+		blog(LOG_INFO, "[obs-scene-switcher] Frame-drop delta after '%s': %s", label.c_str(),
+		     LoadMonitor::describeDelta(before, after).c_str());
+	});
+}
+
+void ObsSceneSwitcher::deferRule(const RewardRule &rule, const RedemptionEvent *redemption)
+{
+	std::optional<RedemptionEvent> pending;
+	if (redemption)
+		pending = *redemption;
+
+	// 延期中の要求があれば最新のものに置き換える（置き換えられた引き換えは実行されないためポイントを返す）
+	if (deferredRule_) {
+		if (deferredRule_->redemption)
+			queueRedemptionStatus(*deferredRule_->redemption, nullptr);
+		deferredRule_->rule = rule;
+		deferredRule_->redemption = std::move(pending);
+		deferredRule_->coalesced++;
+		blog(LOG_INFO, "[obs-scene-switcher] Deferred rule coalesced into '%s' (%d coalesced, %s)",
+		     ruleLabel(rule).c_str(), deferredRule_->coalesced, loadMonitor_->describe().c_str());
+		return;
+	}
+
+	deferredRule_ = DeferredRule{rule, TimerWheel::Clock::now(), 0, std::move(pending)};
+	blog(LOG_INFO, "[obs-scene-switcher] Deferred rule '%s' under load (%s)", ruleLabel(rule).c_str(),
+	     loadMonitor_->describe().c_str());
+
+	sceneSwitcher_->scheduleAfter(std::chrono::milliseconds(kDeferredCheckMs), [this]() { checkDeferredRule(); });
+}
 
-		blog(LOG_DEBUG, "[obs-scene-switcher] Matched rule: %s -> %s (revert: %d sec)", 
-		     rule.sourceScene.empty() || rule.sourceScene == "Any" ? "Any" : rule.sourceScene.c_str(),
-		     rule.targetScene.c_str(), rule.revertSeconds);
+void ObsSceneSwitcher::checkDeferredRule()
+{
+	if (!deferredRule_)
+		return;
+
+	const auto waitedMs = std::chrono::duration_cast<std::chrono::milliseconds>(TimerWheel::Clock::now() -
+										    deferredRule_->since)
+				      .count();
+
+	if (!pluginEnabled_) {
+		dropDeferredRule();
+		return;
+	}
+
+	if (!loadMonitor_->isUnderLoad()) {
+		const DeferredRule deferred = *deferredRule_;
+		deferredRule_.reset();
+
+		blog(LOG_INFO, "[obs-scene-switcher] Running deferred rule '%s' after %lld ms (%d coalesced)",
+		     ruleLabel(deferred.rule).c_str(), (long long)waitedMs, deferred.coalesced);
+		if (deferred.redemption)
+			queueRedemptionStatus(*deferred.redemption, &deferred.rule);
+		executeRule(deferred.rule);
+		return;
+	}
 
-		sceneSwitcher_->switchWithRevert(rule);
-		return;  // 最初の有効なルールを実行したら終了
+	if (waitedMs >= kMaxDeferMs) {
+		blog(LOG_WARNING, "[obs-scene-switcher] Dropped deferred rule '%s' after %lld ms (%d coalesced, %s)",
+		     ruleLabel(deferredRule_->rule).c_str(), (long long)waitedMs, deferredRule_->coalesced,
+		     loadMonitor_->describe().c_str());
+		dropDeferredRule();
+		return;
 	}
 
-	blog(LOG_WARNING, "[obs-scene-switcher] No enabled rule found for reward_id=%s (total rules: %zu)", 
-	     rewardId.c_str(), rewardRules_.size());
+	sceneSwitcher_->scheduleAfter(std::chrono::milliseconds(kDeferredCheckMs), [this]() { checkDeferredRule(); });
+}
+
+void ObsSceneSwitcher::dropDeferredRule()
+{
+	if (deferredRule_ && deferredRule_->redemption)
+		queueRedemptionStatus(*deferredRule_->redemption, nullptr);
+	deferredRule_.reset();
 }
 
 void ObsSceneSwitcher::switchScene(const std::string &sceneName)
@@ -341,9 +758,68 @@ void ObsSceneSwitcher::revertSceneNow()
 
 void ObsSceneSwitcher::setRewardRules(const std::vector<RewardRule> &rules)
 {
-	rewardRules_ = rules;
+	// メトリクスのルール別カウンタ（index はルールの並び）。カウンタはルールに持たせて実行時に数える
+	const auto counters = metrics::Registry::instance().setRules(rules);
+
+	std::vector<RewardRule> counted = rules;
+	for (size_t i = 0; i < counted.size(); ++i)
+		counted[i].firedCounter = counters[i];
+	publishRules(std::move(counted));
+	const RuleSetPtr ruleSet = ruleSet_.load();
+	// 消えたルール・コンボをやめたルールの集計を捨てる
+	combos_->retain(ruleSet->rules);
+
+	blog(LOG_DEBUG, "[obs-scene-switcher] Loaded %zu rules (snapshot %llu)", ruleSet->rules.size(),
+	     (unsigned long long)ruleSet->version);
+
+	// 有効中なら保温対象を更新
+	if (pluginEnabled_)
+		prewarmer_->warm(ruleSet->rules);
+
+	updateEventKinds();
+}
+
+void ObsSceneSwitcher::publishRules(std::vector<RewardRule> rules)
+{
+	sceneSwitcher_->compileTransitions(rules);
+	// 発火条件は保存時に 1 回だけコンパイルする（照合時には正規表現を作らない）
+	compileRulePredicates(rules);
+
+	auto next = std::make_shared<CompiledRuleSet>();
+	next->rules = std::move(rules);
+	next->version = ruleSet_.load()->version + 1;
+
+	// 照合中のスレッドは古いスナップショットを使い切ってから手放す
+	ruleSet_.store(std::move(next));
+}
+
+void ObsSceneSwitcher::loadSceneCollectionRules()
+{
+	char *name = obs_frontend_get_current_scene_collection();
+	const std::string collection = name ? name : "";
+	bfree(name);
+
+	auto &cfg = ConfigManager::instance();
+	cfg.setActiveSceneCollection(collection);
+	setRewardRules(cfg.getRewardRules());
+	refreshCurrentScene();
+}
+
+void ObsSceneSwitcher::refreshCurrentScene()
+{
+	currentScene_.store(std::make_shared<const std::string>(sceneSwitcher_->getCurrentSceneName().toStdString()));
+}
+
+void ObsSceneSwitcher::updateEventKinds()
+{
+	// 有効なルールが使う種類だけを購読する（スコープのない種類で購読エラーを出さないため）
+	std::vector<EventKind> kinds;
+	for (const auto &rule : ruleSet_.load()->rules) {
+		if (rule.enabled && std::find(kinds.begin(), kinds.end(), rule.trigger) == kinds.end())
+			kinds.push_back(rule.trigger);
+	}
 
-	blog(LOG_DEBUG, "[obs-scene-switcher] Loaded %zu rules", rewardRules_.size());
+	EventSubClient::instance().setEventKinds(kinds);
 }
 
 void ObsSceneSwitcher::onSceneSwitcherStateChanged(SceneSwitcher::State state, int remainingSeconds,
@@ -398,7 +874,7 @@ void ObsSceneSwitcher::loadConfig()
 	expiresAt_ = cfg.getTokenExpiresAt();
 }
 
-void ObsSceneSwitcher::fetchRewardList()
+void ObsSceneSwitcher::fetchRewardList(std::function<void()> onDone)
 {
 	if (!authenticated_) {
 		blog(LOG_WARNING, "[obs-scene-switcher] Cannot fetch rewards: not authenticated");
@@ -406,8 +882,19 @@ void ObsSceneSwitcher::fetchRewardList()
 	}
 	
 	blog(LOG_DEBUG, "[obs-scene-switcher] Fetching channel rewards list...");
-	rewardList_ = TwitchOAuth::instance().fetchChannelRewards();
-	blog(LOG_DEBUG, "[obs-scene-switcher] Fetched %zu rewards", rewardList_.size());
+	TwitchOAuth::instance().fetchChannelRewardsAsync(
+		[this, onDone](bool success, const std::vector<RewardInfo> &rewards) {
+			QMetaObject::invokeMethod(this, [this, onDone, success, rewards]() {
+				// 取得中にログアウトされた場合は破棄する
+				if (success && authenticated_) {
+					rewardList_ = rewards;
+					blog(LOG_DEBUG, "[obs-scene-switcher] Fetched %zu rewards", rewardList_.size());
+					emit rewardListChanged(rewardList_);
+				}
+				if (onDone)
+					onDone();
+			}, Qt::QueuedConnection);
+		});
 }
 
 void ObsSceneSwitcher::saveConfig()
@@ -430,51 +917,140 @@ void ObsSceneSwitcher::reloadAuthConfig()
 
 void ObsSceneSwitcher::setupObsCallbacks()
 {
-	obs_frontend_add_event_callback(
-		[](enum obs_frontend_event event, void *private_data) {
-			auto *self = static_cast<ObsSceneSwitcher*>(private_data);
-			
-			switch (event) {
-			case OBS_FRONTEND_EVENT_STREAMING_STARTED:
-				// 配信開始時：認証済みなら自動的に有効化
-				if (self->isAuthenticated() && !self->isEnabled()) {
-					blog(LOG_INFO, "[obs-scene-switcher] Streaming started - auto-enabling plugin");
-					self->setEnabled(true);
-				}
-				break;
-				
-			case OBS_FRONTEND_EVENT_STREAMING_STOPPED:
-				// 配信停止時：自動的に無効化
-				if (self->isEnabled()) {
-					blog(LOG_INFO, "[obs-scene-switcher] Streaming stopped - auto-disabling plugin");
-					self->setEnabled(false);
-				}
-				break;
-				
-			default:
-				break;
-			}
-		},
-		this
-	);
+	obs_frontend_add_event_callback(&ObsSceneSwitcher::onFrontendEvent, this);
 }
 
 void ObsSceneSwitcher::removeObsCallbacks()
 {
-	obs_frontend_remove_event_callback(
-		[](enum obs_frontend_event event, void *private_data) {
-			auto *self = static_cast<ObsSceneSwitcher*>(private_data);
-			
-			switch (event) {
-			case OBS_FRONTEND_EVENT_STREAMING_STARTED:
-			case OBS_FRONTEND_EVENT_STREAMING_STOPPED:
-				break;
-			default:
-				break;
+	obs_frontend_remove_event_callback(&ObsSceneSwitcher::onFrontendEvent, this);
+}
+
+void ObsSceneSwitcher::updateMetricsServer()
+{
+	auto &cfg = ConfigManager::instance();
+	const bool enabled = cfg.getMetricsEnabled();
+	const int port = cfg.getMetricsPort();
+
+	if (metricsServer_ && (!enabled || metricsPort_ != port)) {
+		metricsServer_.reset();
+		blog(LOG_INFO, "[obs-scene-switcher] Metrics endpoint stopped");
+	}
+
+	if (!enabled || metricsServer_)
+		return;
+
+	// localhost のみで待ち受ける（外部公開はしない）
+	auto server = std::make_unique<HttpServer>();
+	const bool ok = server->serve(
+		port,
+		[](const std::string &method, const std::string &target) {
+			HttpServer::Response res;
+			if (method != "GET") {
+				res.status = 405;
+				return res;
+			}
+			if (target != "/metrics") {
+				res.status = 404;
+				return res;
 			}
-		},
-		this
-	);
+			res.contentType = "text/plain; version=0.0.4; charset=utf-8";
+			res.body = metrics::Registry::instance().renderPrometheus();
+			return res;
+		});
+
+	if (!ok)
+		return;
+
+	metricsServer_ = std::move(server);
+	metricsPort_ = port;
+	blog(LOG_INFO, "[obs-scene-switcher] Metrics endpoint listening on http://127.0.0.1:%d/metrics", port);
+}
+
+void ObsSceneSwitcher::onDumpTraceMenu(void *private_data)
+{
+	static_cast<ObsSceneSwitcher*>(private_data)->dumpTrace();
+}
+
+void ObsSceneSwitcher::dumpTrace()
+{
+	// 書式化はここでのみ行う
+	std::ostringstream out;
+	const size_t count = trace::dump(out);
+
+	char *path = obs_module_config_path("trace.log");
+	if (path) {
+		std::ofstream file(path, std::ios::trunc);
+		if (file)
+			file << out.str();
+		else
+			blog(LOG_WARNING, "[obs-scene-switcher] Failed to write trace file: %s", path);
+	}
+
+	blog(LOG_INFO, "[obs-scene-switcher] Trace dump (%zu records)%s%s", count, path ? " -> " : "",
+	     path ? path : "");
+	bfree(path);
+
+	std::istringstream lines(out.str());
+	std::string line;
+	while (std::getline(lines, line))
+		blog(LOG_INFO, "[obs-scene-switcher][trace] %s", line.c_str());
+}
+
+void ObsSceneSwitcher::onFrontendEvent(enum obs_frontend_event event, void *private_data)
+{
+	auto *self = static_cast<ObsSceneSwitcher*>(private_data);
+
+	switch (event) {
+	case OBS_FRONTEND_EVENT_STREAMING_STARTED:
+		// 配信開始時：認証済みなら自動的に有効化
+		if (self->isAuthenticated() && !self->isEnabled()) {
+			blog(LOG_INFO, "[obs-scene-switcher] Streaming started - auto-enabling plugin");
+			self->setEnabled(true);
+		}
+		break;
+
+	case OBS_FRONTEND_EVENT_STREAMING_STOPPED:
+		// 配信停止時：自動的に無効化（EventSub の待機オプションが有効なら接続は残す）
+		if (self->isEnabled()) {
+			blog(LOG_INFO, "[obs-scene-switcher] Streaming stopped - auto-disabling plugin");
+			self->setEnabled(false);
+		}
+		break;
+
+	case OBS_FRONTEND_EVENT_SCENE_CHANGED:
+		self->refreshCurrentScene();
+		// シーン切替の着地確認
+		self->sceneSwitcher_->handleFrontendEvent(event);
+		break;
+
+	case OBS_FRONTEND_EVENT_TRANSITION_STOPPED:
+		// シーン切替の着地確認
+		self->sceneSwitcher_->handleFrontendEvent(event);
+		break;
+
+	case OBS_FRONTEND_EVENT_SCENE_COLLECTION_CHANGING:
+		// 旧コレクションのシーンを参照し続けない（保温の強参照を外し、切替中は照合しない）
+		self->prewarmer_->release();
+		self->dropDeferredRule();
+		self->publishRules({});
+		break;
+
+	case OBS_FRONTEND_EVENT_SCENE_COLLECTION_CHANGED:
+		// 新しいコレクションのルールだけを読み込んでコンパイルする
+		self->loadSceneCollectionRules();
+		break;
+
+	case OBS_FRONTEND_EVENT_FINISHED_LOADING:
+	case OBS_FRONTEND_EVENT_TRANSITION_LIST_CHANGED:
+		if (event == OBS_FRONTEND_EVENT_FINISHED_LOADING)
+			self->refreshCurrentScene();
+		// ルールのトランジション指定を解決し直す（新しいスナップショットとして公開）
+		self->publishRules(self->ruleSet_.load()->rules);
+		break;
+
+	default:
+		break;
+	}
 }
 
 extern "C" {
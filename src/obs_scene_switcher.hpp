@@ -4,12 +4,17 @@
 
 #pragma once
 
+#include <atomic>
+#include <chrono>
 #include <string>
+#include <functional>
 #include <memory>
 #include <unordered_map>
+#include <optional>
 #include <QObject>
 
 #include "obs/scene_switcher.hpp"
+#include "core/rule_set.hpp"
 #include "eventsub/eventsub_client.hpp"
 #include "oauth/twitch_oauth.hpp"
 #include "ui/rule_row.hpp"
@@ -17,6 +22,14 @@
 class TwitchOAuth;
 class EventSubClient;
 class SceneSwitcher;
+class ScenePrewarmer;
+class TickScheduler;
+class LoadMonitor;
+class RedemptionBatcher;
+class CooldownTable;
+class ComboTracker;
+class HttpServer;
+class Executor;
 class PluginDock;
 
 class ObsSceneSwitcher : public QObject {
@@ -39,6 +52,8 @@ public:
 	// EventSub
 	void connectEventSub();
 	void disconnectEventSub();
+	// 無効中も EventSub を待機させるオプションを、設定と認証状態に合わせて開始・停止する
+	void updateEventSubStandby();
 
 	// プラグイン有効/無効制御
 	void setEnabled(bool enabled);
@@ -51,8 +66,8 @@ public:
         // リワード一覧取得
 	const std::vector<RewardInfo> &getRewardList() const { return rewardList_; }
 	
-	// チャンネルポイント一覧を取得（WebSocket接続不要）
-	void fetchRewardList();
+	// チャンネルポイント一覧を取得（WebSocket接続不要、非同期。onDone は UI スレッドで呼ばれる）
+	void fetchRewardList(std::function<void()> onDone = {});
 
 	// OBS シーン切り替え
 	void switchScene(const std::string &sceneName);
@@ -69,6 +84,15 @@ public:
 	void setupObsCallbacks();
 	void removeObsCallbacks();
 
+	// メトリクスエンドポイントを設定に合わせて開始・停止
+	void updateMetricsServer();
+
+	// トレースリングをファイルと OBS ログへ書き出す（ツールメニューから実行）
+	void dumpTrace();
+
+	// 起動フェーズの計測結果をログと Dock に出力する
+	void reportStartupProfile();
+
 signals:
 	void authenticationSucceeded();
 	void authenticationFailed();
@@ -77,10 +101,13 @@ signals:
 	void enabledStateChanged(bool enabled);
 	void loggedOut();  // ログアウト専用シグナル
 
+	// リワード一覧の取得完了
+	void rewardListChanged(const std::vector<RewardInfo> &rewards);
+
 public slots:
-	// EventSub 通知コールバック
-	void onRedemptionReceived(const std::string &rewardId, const std::string &userName,
-				  const std::string &userInput);
+	// EventSub 通知コールバック（引き換え・Bits・サブスク・レイド・フォロー）
+	// WebSocket のスレッドで照合し、実行する内容だけを UI スレッドへ渡す（ageMs は発生からの推定時間、不明なら -1）
+	void onEventReceived(const TwitchEvent &event, qint64 ageMs);
 	
 	// SceneSwitcher 状態変更
 	void onSceneSwitcherStateChanged(SceneSwitcher::State state, int remainingSeconds = -1,
@@ -90,10 +117,43 @@ public slots:
 private:
 	ObsSceneSwitcher();
 	~ObsSceneSwitcher();
+
+	// サブスクリプションが揃った（有効化からの時間を Dock に出す）
+	void onEventSubArmed();
+
+	// 照合結果を UI スレッドで処理する（rule は ruleSet の要素、なければ nullptr）
+	void onRuleMatched(const RuleSetPtr &ruleSet, const RewardRule *rule, const TwitchEvent &event);
+
+	// マッチしたルールの実行（負荷に応じた延期・tick 同期を経由）
+	// redemption は状態を更新する引き換え（延期したら実行・破棄が決まるまで更新しない。不要なら nullptr）
+	void dispatchRule(const RewardRule &rule, const RedemptionEvent *redemption = nullptr);
+	void executeRule(const RewardRule &rule);
+	void applyRule(const RewardRule &rule);
+	void deferRule(const RewardRule &rule, const RedemptionEvent *redemption);
+	void checkDeferredRule();
+	// 延期中の要求を実行せずに捨てる（引き換えはポイントを返す）
+	void dropDeferredRule();
+
+	// 引き換えの状態更新（FULFILLED / CANCELED）をまとめて送る（オプション。rule が nullptr なら実行しなかった）
+	void queueRedemptionStatus(const RedemptionEvent &event, const RewardRule *rule, bool countedInCombo = false);
+
+	// ルールを解決して新しいスナップショットとして公開する（UI スレッドから呼ぶ）
+	void publishRules(std::vector<RewardRule> rules);
+	// 現在のシーンコレクションのルールを設定から読み込んで公開する
+	void loadSceneCollectionRules();
+	// 照合に使う現在のシーン名を取り直す（UI スレッドから呼ぶ）
+	void refreshCurrentScene();
+
+	// ルールが使うイベントの種類を EventSub の購読に反映する
+	void updateEventKinds();
+
+	// 起動時のトークン更新・OAuth ログインの結果を UI スレッドで反映する
+	void onStartupAuthFinished(bool success);
+	void onOAuthLoginFinished(bool success, const TokenSet &tokens, const TwitchUser &user);
 	
-	// OBS イベントコールバック
-	static void onStreamingStarted(enum obs_frontend_event event, void *private_data);
-	static void onStreamingStopped(enum obs_frontend_event event, void *private_data);
+	// OBS イベントコールバック（登録と解除で同じ関数ポインタを使う）
+	static void onFrontendEvent(enum obs_frontend_event event, void *private_data);
+	static void onDumpTraceMenu(void *private_data);
 
 	static ObsSceneSwitcher *s_instance_;
 
@@ -102,9 +162,14 @@ private:
 	// Twitch Auth 状態
 	bool authenticated_ = false;
 	bool eventsubConnected_ = false;
+
+	// 有効化から通知を受けられるまでの計測（standby: 待機中の接続を引き継いだ）
+	bool awaitingArm_ = false;
+	bool armFromStandby_ = false;
+	std::chrono::steady_clock::time_point armRequestedAt_;
 	
-	// プラグイン有効状態（起動時は常にfalse）
-	bool pluginEnabled_ = false;
+	// プラグイン有効状態（起動時は常にfalse。EventSub のスレッドからも読む）
+	std::atomic<bool> pluginEnabled_{false};
 	
 	// 配信開始前の有効状態を記憶（配信終了時に復元）
 	bool wasEnabledBeforeStreaming_ = false;
@@ -118,8 +183,41 @@ private:
 
         std::vector<RewardInfo> rewardList_;
 
-	// Reward → Scene のマッピング（順序を保持）
-	std::vector<RewardRule> rewardRules_;
+	// Reward → Scene のマッピング（順序を保持）。保存のたびに丸ごと差し替え、照合側はロックなしで読む
+	SnapshotCell<CompiledRuleSet> ruleSet_;
+	// 照合に使う現在のシーン名（OBS のシーン切替通知で更新する。OBS の API は UI スレッドでしか呼ばない）
+	SnapshotCell<std::string> currentScene_;
 
 	std::unique_ptr<SceneSwitcher> sceneSwitcher_;
+
+	// 切替先シーンの事前保温（有効中のみ）
+	std::unique_ptr<ScenePrewarmer> prewarmer_;
+
+	// ビデオ tick 同期の切替適用
+	std::unique_ptr<TickScheduler> tickScheduler_;
+
+	// OBS 負荷監視と延期中の切替（最新の 1 件にまとめる）
+	struct DeferredRule {
+		RewardRule rule;
+		TimerWheel::Clock::time_point since;
+		int coalesced = 0;
+		std::optional<RedemptionEvent> redemption;  // 実行・破棄のときに状態を更新する
+	};
+	std::unique_ptr<LoadMonitor> loadMonitor_;
+	std::optional<DeferredRule> deferredRule_;
+
+	// ルール・報酬・ユーザー・全体のクールダウン
+	std::unique_ptr<CooldownTable> cooldowns_;
+	// コンボルールのスライディングウィンドウ
+	std::unique_ptr<ComboTracker> combos_;
+
+	// 引き換えの状態更新
+	std::unique_ptr<RedemptionBatcher> redemptionBatcher_;
+
+	// localhost のメトリクスエンドポイント（オプション）
+	std::unique_ptr<HttpServer> metricsServer_;
+	int metricsPort_ = 0;
+
+	// 起動時の並行ロード
+	std::unique_ptr<Executor> startupExecutor_;
 };
@@ -21,17 +21,35 @@ with this program. If not, see <https://www.gnu.org/licenses/>
 
 #include "obs_scene_switcher.hpp"
 #include "update/update_checker.hpp"
+#include "core/startup_profiler.hpp"
+#include "core/log.hpp"
 
 OBS_DECLARE_MODULE()
 
+// core のログを OBS のログへ転送する
+static void coreLogSink(int level, const char *message)
+{
+	blog(level, "%s", message);
+}
+
 bool obs_module_load(void)
 {
 	obs_log(LOG_INFO, "plugin loaded successfully (version %s)", PLUGIN_VERSION);
+	corelog::setSink(&coreLogSink);
+
+	// 起動フェーズの計測（OBS 起動をブロックした時間を記録する）
+	startup::Profiler::instance().reset();
 
 	ObsSceneSwitcher::instance()->start();
 	
 	// 非同期でアップデートチェック
-	UpdateChecker::checkOnStartupAsync();
+	{
+		startup::Profiler::Scope phase("update_check", true);
+		UpdateChecker::checkOnStartupAsync();
+	}
+
+	startup::Profiler::instance().markBlockingDone();
+	ObsSceneSwitcher::instance()->reportStartupProfile();
 	
 	return true;
 }
@@ -40,6 +58,7 @@ void obs_module_unload(void)
 {
 	ObsSceneSwitcher::instance()->stop();
 	ObsSceneSwitcher::destroy();
+	corelog::setSink(nullptr);
 }
 
 obs_properties_t *obs_module_properties(void)
@@ -79,6 +79,15 @@ DockMainWidget::DockMainWidget(QWidget *parent) : QWidget(parent)
 	
 	mainLayout->addStretch();
 
+	// 起動時間（内訳はツールチップ）
+	labelStartup_ = new QLabel("", this);
+	labelStartup_->setStyleSheet("QLabel { color: #888888; font-size: 10px; }");
+	mainLayout->addWidget(labelStartup_);
+
+	labelArmed_ = new QLabel("", this);
+	labelArmed_->setStyleSheet("QLabel { color: #888888; font-size: 10px; }");
+	mainLayout->addWidget(labelArmed_);
+
 	// シグナル接続
 	connect(buttonToggleEnabled_, &QPushButton::toggled, 
 		this, &DockMainWidget::enableToggleRequested);
@@ -148,6 +157,24 @@ void DockMainWidget::updateCountdown(int seconds)
 	}
 }
 
+void DockMainWidget::updateStartupInfo(qint64 blockingUs, const QString &details)
+{
+	if (!labelStartup_)
+		return;
+
+	labelStartup_->setText(Tr("SceneSwitcher.Status.StartupTime").arg(blockingUs / 1000.0, 0, 'f', 1));
+	labelStartup_->setToolTip(QString("<pre>%1</pre>").arg(details.toHtmlEscaped()));
+}
+
+void DockMainWidget::updateArmInfo(qint64 elapsedMs, bool standby)
+{
+	if (!labelArmed_)
+		return;
+
+	labelArmed_->setText(Tr(standby ? "SceneSwitcher.Status.ArmedStandby" : "SceneSwitcher.Status.Armed")
+				     .arg(elapsedMs));
+}
+
 void DockMainWidget::applyToggleStyle()
 {
 	if (!buttonToggleEnabled_)
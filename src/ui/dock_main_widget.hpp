@@ -30,6 +30,12 @@ public:
 	void updateCountdown(int seconds);
 	void setRevertButtonVisible(bool visible);
 
+	// 起動時間（OBS 起動をブロックした時間とフェーズ別の内訳）
+	void updateStartupInfo(qint64 blockingUs, const QString &details);
+
+	// 有効化から EventSub が通知を受けられるまでの時間（standby: 待機中の接続を引き継いだ）
+	void updateArmInfo(qint64 elapsedMs, bool standby);
+
 signals:
 	/// 「設定を開く」ボタン
 	void settingsRequested();
@@ -59,4 +65,8 @@ private:
 	QPushButton *buttonToggleEnabled_ = nullptr;
 	QPushButton *logoutButton_ = nullptr;
 	QPushButton *buttonSettings_ = nullptr;
+
+	// 起動時間・有効化から EventSub の準備完了まで
+	QLabel *labelStartup_ = nullptr;
+	QLabel *labelArmed_ = nullptr;
 };
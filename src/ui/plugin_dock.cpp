@@ -153,6 +153,18 @@ void PluginDock::showMain()
 	}
 }
 
+void PluginDock::updateStartupInfo(qint64 blockingUs, const QString &details)
+{
+	if (mainDockWidget_)
+		mainDockWidget_->updateStartupInfo(blockingUs, details);
+}
+
+void PluginDock::updateArmInfo(qint64 elapsedMs, bool standby)
+{
+	if (mainDockWidget_)
+		mainDockWidget_->updateArmInfo(elapsedMs, standby);
+}
+
 void PluginDock::onAuthenticationError(const QString &message)
 {
 	QMessageBox::warning(mainWidget_, 
@@ -22,6 +22,10 @@ public:
 	void showLogin();
 	void showMain();
 
+	// 起動時間の表示
+	void updateStartupInfo(qint64 blockingUs, const QString &details);
+	void updateArmInfo(qint64 elapsedMs, bool standby);
+
 public slots:
 	void onAuthenticationSucceeded();
 	void onAuthenticationFailed();
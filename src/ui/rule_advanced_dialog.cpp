@@ -0,0 +1,424 @@
+// obs-scene-switcher plugin
+// Copyright (C) 2025 ksmksks
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "rule_advanced_dialog.hpp"
+#include "../i18n/locale_manager.hpp"
+#include "../core/rule_predicates.hpp"
+#include "../core/combo_tracker.hpp"
+
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QFormLayout>
+#include <QLabel>
+#include <obs-frontend-api.h>
+#include <QComboBox>
+#include <QLineEdit>
+#include <QSpinBox>
+#include <QHeaderView>
+#include <QMessageBox>
+#include <QStringList>
+#include <type_traits>
+
+// ユーザー一覧はカンマ区切りで編集する
+static QString joinUsers(const std::vector<std::string> &users)
+{
+	QStringList list;
+	for (const auto &user : users)
+		list << QString::fromStdString(user);
+	return list.join(", ");
+}
+
+static std::vector<std::string> splitUsers(const QString &text)
+{
+	std::vector<std::string> users;
+	for (const auto &part : text.split(',', Qt::SkipEmptyParts)) {
+		const QString user = part.trimmed();
+		if (!user.isEmpty())
+			users.push_back(user.toStdString());
+	}
+	return users;
+}
+
+static QSpinBox *makeCooldownSpin(int seconds, QWidget *parent)
+{
+	auto *spin = new QSpinBox(parent);
+	spin->setRange(0, 3600);
+	spin->setSuffix(QString(" %1").arg(Tr("SceneSwitcher.Rule.Duration")));
+	spin->setSpecialValueText(Tr("SceneSwitcher.RuleAdvanced.CooldownNone"));
+	spin->setValue(seconds);
+	return spin;
+}
+
+// アクション表の列
+enum ActionColumn {
+	kColType = 0,
+	kColTarget,   // シーン名またはソース名
+	kColDetail,   // シーンアイテム名またはフィルタ名
+	kColOn,       // 表示/有効
+	kColRevert,   // 復帰秒数
+	kColCount
+};
+
+RuleAdvancedDialog::RuleAdvancedDialog(const RewardRule &rule, QWidget *parent) : QDialog(parent), rule_(rule)
+{
+	setWindowTitle(Tr("SceneSwitcher.RuleAdvanced.Title"));
+	resize(640, 360);
+	setModal(true);
+
+	auto *layout = new QVBoxLayout(this);
+	auto *formLayout = new QFormLayout();
+
+	// 切替先シーンの事前保温
+	prewarmCheckBox_ = new QCheckBox(Tr("SceneSwitcher.RuleAdvanced.Prewarm"), this);
+	prewarmCheckBox_->setToolTip(Tr("SceneSwitcher.RuleAdvanced.PrewarmTooltip"));
+	prewarmCheckBox_->setChecked(rule_.prewarm);
+	formLayout->addRow(prewarmCheckBox_);
+
+	// 高負荷時も延期しない
+	highPriorityCheckBox_ = new QCheckBox(Tr("SceneSwitcher.RuleAdvanced.HighPriority"), this);
+	highPriorityCheckBox_->setToolTip(Tr("SceneSwitcher.RuleAdvanced.HighPriorityTooltip"));
+	highPriorityCheckBox_->setChecked(rule_.highPriority);
+	formLayout->addRow(highPriorityCheckBox_);
+
+	// 遅れて届いた通知では実行しない
+	maxEventAgeSpin_ = new QSpinBox(this);
+	maxEventAgeSpin_->setRange(0, 3600);
+	maxEventAgeSpin_->setSuffix(QString(" %1").arg(Tr("SceneSwitcher.Rule.Duration")));
+	maxEventAgeSpin_->setSpecialValueText(Tr("SceneSwitcher.RuleAdvanced.MaxEventAgeNone"));
+	maxEventAgeSpin_->setValue(rule_.maxEventAgeSeconds);
+	maxEventAgeSpin_->setToolTip(Tr("SceneSwitcher.RuleAdvanced.MaxEventAgeTooltip"));
+	formLayout->addRow(Tr("SceneSwitcher.RuleAdvanced.MaxEventAge"), maxEventAgeSpin_);
+
+	// この切替だけに使うトランジション（先頭は OBS の現在の設定）
+	transitionBox_ = new QComboBox(this);
+	transitionBox_->addItem(Tr("SceneSwitcher.RuleAdvanced.TransitionDefault"), QString());
+
+	obs_frontend_source_list transitions = {};
+	obs_frontend_get_transitions(&transitions);
+	for (size_t i = 0; i < transitions.sources.num; i++) {
+		const QString name = QString::fromUtf8(obs_source_get_name(transitions.sources.array[i]));
+		transitionBox_->addItem(name, name);
+	}
+	obs_frontend_source_list_free(&transitions);
+
+	if (!rule_.transitionName.empty()) {
+		const QString name = QString::fromStdString(rule_.transitionName);
+		int index = transitionBox_->findData(name);
+		if (index < 0) {
+			// 削除済みのトランジションも設定としては保持する
+			transitionBox_->addItem(name, name);
+			index = transitionBox_->count() - 1;
+		}
+		transitionBox_->setCurrentIndex(index);
+	}
+	transitionBox_->setToolTip(Tr("SceneSwitcher.RuleAdvanced.TransitionTooltip"));
+	formLayout->addRow(Tr("SceneSwitcher.RuleAdvanced.Transition"), transitionBox_);
+
+	transitionDurationSpin_ = new QSpinBox(this);
+	transitionDurationSpin_->setRange(0, 20000);
+	transitionDurationSpin_->setSingleStep(50);
+	transitionDurationSpin_->setSuffix(" ms");
+	transitionDurationSpin_->setSpecialValueText(Tr("SceneSwitcher.RuleAdvanced.TransitionDurationDefault"));
+	transitionDurationSpin_->setValue(rule_.transitionDurationMs);
+	formLayout->addRow(Tr("SceneSwitcher.RuleAdvanced.TransitionDuration"), transitionDurationSpin_);
+
+	layout->addLayout(formLayout);
+
+	// 発火条件（満たさない通知では下のルールを探す）
+	layout->addWidget(new QLabel(Tr("SceneSwitcher.RuleAdvanced.Conditions"), this));
+	auto *conditionLayout = new QFormLayout();
+
+	inputPatternEdit_ = new QLineEdit(QString::fromStdString(rule_.predicates.inputPattern), this);
+	inputPatternEdit_->setToolTip(Tr("SceneSwitcher.RuleAdvanced.InputPatternTooltip"));
+	conditionLayout->addRow(Tr("SceneSwitcher.RuleAdvanced.InputPattern"), inputPatternEdit_);
+
+	inputRegexCheckBox_ = new QCheckBox(Tr("SceneSwitcher.RuleAdvanced.InputRegex"), this);
+	inputRegexCheckBox_->setChecked(rule_.predicates.inputRegex);
+	conditionLayout->addRow(inputRegexCheckBox_);
+
+	allowUsersEdit_ = new QLineEdit(joinUsers(rule_.predicates.allowUsers), this);
+	allowUsersEdit_->setToolTip(Tr("SceneSwitcher.RuleAdvanced.AllowUsersTooltip"));
+	conditionLayout->addRow(Tr("SceneSwitcher.RuleAdvanced.AllowUsers"), allowUsersEdit_);
+
+	denyUsersEdit_ = new QLineEdit(joinUsers(rule_.predicates.denyUsers), this);
+	denyUsersEdit_->setToolTip(Tr("SceneSwitcher.RuleAdvanced.DenyUsersTooltip"));
+	conditionLayout->addRow(Tr("SceneSwitcher.RuleAdvanced.DenyUsers"), denyUsersEdit_);
+
+	// Bits の下限は Bits ルールでだけ編集できる
+	minBitsSpin_ = new QSpinBox(this);
+	minBitsSpin_->setRange(0, 1000000);
+	minBitsSpin_->setSpecialValueText(Tr("SceneSwitcher.RuleAdvanced.MinBitsNone"));
+	minBitsSpin_->setValue(rule_.predicates.minBits);
+	minBitsSpin_->setEnabled(rule_.trigger == EventKind::Cheer);
+	conditionLayout->addRow(Tr("SceneSwitcher.RuleAdvanced.MinBits"), minBitsSpin_);
+
+	layout->addLayout(conditionLayout);
+
+	// クールダウン（実行後、指定秒数は同じ要求を実行しない）
+	layout->addWidget(new QLabel(Tr("SceneSwitcher.RuleAdvanced.Cooldowns"), this));
+	auto *cooldownLayout = new QFormLayout();
+
+	ruleCooldownSpin_ = makeCooldownSpin(rule_.cooldowns.ruleSeconds, this);
+	ruleCooldownSpin_->setToolTip(Tr("SceneSwitcher.RuleAdvanced.RuleCooldownTooltip"));
+	cooldownLayout->addRow(Tr("SceneSwitcher.RuleAdvanced.RuleCooldown"), ruleCooldownSpin_);
+
+	rewardCooldownSpin_ = makeCooldownSpin(rule_.cooldowns.rewardSeconds, this);
+	rewardCooldownSpin_->setToolTip(Tr("SceneSwitcher.RuleAdvanced.RewardCooldownTooltip"));
+	cooldownLayout->addRow(Tr("SceneSwitcher.RuleAdvanced.RewardCooldown"), rewardCooldownSpin_);
+
+	userCooldownSpin_ = makeCooldownSpin(rule_.cooldowns.userSeconds, this);
+	userCooldownSpin_->setToolTip(Tr("SceneSwitcher.RuleAdvanced.UserCooldownTooltip"));
+	cooldownLayout->addRow(Tr("SceneSwitcher.RuleAdvanced.UserCooldown"), userCooldownSpin_);
+
+	layout->addLayout(cooldownLayout);
+
+	// コンボ（T 秒以内に N 回 / N 人で 1 回だけ実行する）
+	layout->addWidget(new QLabel(Tr("SceneSwitcher.RuleAdvanced.Combo"), this));
+	auto *comboLayout = new QHBoxLayout();
+
+	comboCountSpin_ = new QSpinBox(this);
+	comboCountSpin_->setRange(1, ComboTracker::kMaxCount);
+	comboCountSpin_->setSpecialValueText(Tr("SceneSwitcher.RuleAdvanced.ComboOff"));
+	comboCountSpin_->setValue(rule_.combo.enabled() ? rule_.combo.count : 1);
+	comboCountSpin_->setToolTip(Tr("SceneSwitcher.RuleAdvanced.ComboTooltip"));
+
+	comboWindowSpin_ = new QSpinBox(this);
+	comboWindowSpin_->setRange(1, 600);
+	comboWindowSpin_->setPrefix(Tr("SceneSwitcher.RuleAdvanced.ComboWithin"));
+	comboWindowSpin_->setSuffix(QString(" %1").arg(Tr("SceneSwitcher.Rule.Duration")));
+	comboWindowSpin_->setValue(rule_.combo.windowSeconds > 0 ? rule_.combo.windowSeconds : 10);
+
+	comboDistinctCheckBox_ = new QCheckBox(Tr("SceneSwitcher.RuleAdvanced.ComboDistinct"), this);
+	comboDistinctCheckBox_->setChecked(rule_.combo.distinctUsers);
+
+	comboLayout->addWidget(comboCountSpin_);
+	comboLayout->addWidget(comboWindowSpin_);
+	comboLayout->addWidget(comboDistinctCheckBox_);
+	comboLayout->addStretch();
+	layout->addLayout(comboLayout);
+
+	const auto updateComboFields = [this](int count) {
+		comboWindowSpin_->setEnabled(count > 1);
+		comboDistinctCheckBox_->setEnabled(count > 1);
+	};
+	updateComboFields(comboCountSpin_->value());
+	connect(comboCountSpin_, QOverload<int>::of(&QSpinBox::valueChanged), this, updateComboFields);
+
+	// 追加アクション（シーン切替より軽量なアイテム表示・フィルタ・メディア操作）
+	layout->addWidget(new QLabel(Tr("SceneSwitcher.RuleAdvanced.Actions"), this));
+
+	actionsTable_ = new QTableWidget(0, kColCount, this);
+	actionsTable_->setHorizontalHeaderLabels({Tr("SceneSwitcher.RuleAdvanced.ActionType"),
+						  Tr("SceneSwitcher.RuleAdvanced.ActionTarget"),
+						  Tr("SceneSwitcher.RuleAdvanced.ActionDetail"),
+						  Tr("SceneSwitcher.RuleAdvanced.ActionOn"),
+						  Tr("SceneSwitcher.RuleAdvanced.ActionRevert")});
+	actionsTable_->horizontalHeader()->setSectionResizeMode(QHeaderView::Stretch);
+	actionsTable_->verticalHeader()->setVisible(false);
+	actionsTable_->setSelectionBehavior(QAbstractItemView::SelectRows);
+	actionsTable_->setToolTip(Tr("SceneSwitcher.RuleAdvanced.ActionsTooltip"));
+	layout->addWidget(actionsTable_);
+
+	for (const auto &action : rule_.actions)
+		addActionRow(action);
+
+	auto *actionButtonLayout = new QHBoxLayout();
+	addActionButton_ = new QPushButton(Tr("SceneSwitcher.RuleAdvanced.AddAction"), this);
+	removeActionButton_ = new QPushButton(Tr("SceneSwitcher.RuleAdvanced.RemoveAction"), this);
+	actionButtonLayout->addWidget(addActionButton_);
+	actionButtonLayout->addWidget(removeActionButton_);
+	actionButtonLayout->addStretch();
+	layout->addLayout(actionButtonLayout);
+
+	// ボタン行
+	auto *buttonLayout = new QHBoxLayout();
+	saveButton_ = new QPushButton(Tr("SceneSwitcher.Settings.Save"), this);
+	cancelButton_ = new QPushButton(Tr("SceneSwitcher.Settings.Cancel"), this);
+
+	buttonLayout->addStretch();
+	buttonLayout->addWidget(saveButton_);
+	buttonLayout->addWidget(cancelButton_);
+
+	layout->addLayout(buttonLayout);
+
+	connect(saveButton_, &QPushButton::clicked, this, &RuleAdvancedDialog::onSaveClicked);
+	connect(cancelButton_, &QPushButton::clicked, this, &RuleAdvancedDialog::onCancelClicked);
+	connect(addActionButton_, &QPushButton::clicked, this, &RuleAdvancedDialog::onAddActionClicked);
+	connect(removeActionButton_, &QPushButton::clicked, this, &RuleAdvancedDialog::onRemoveActionClicked);
+}
+
+RewardRule RuleAdvancedDialog::rule() const
+{
+	return rule_;
+}
+
+void RuleAdvancedDialog::onSaveClicked()
+{
+	rule_.prewarm = prewarmCheckBox_->isChecked();
+	rule_.highPriority = highPriorityCheckBox_->isChecked();
+	rule_.maxEventAgeSeconds = maxEventAgeSpin_->value();
+	rule_.transitionName = transitionBox_->currentData().toString().toStdString();
+	rule_.transitionDurationMs = rule_.transitionName.empty() ? 0 : transitionDurationSpin_->value();
+
+	RulePredicates predicates;
+	predicates.inputPattern = inputPatternEdit_->text().trimmed().toStdString();
+	predicates.inputRegex = inputRegexCheckBox_->isChecked();
+	predicates.allowUsers = splitUsers(allowUsersEdit_->text());
+	predicates.denyUsers = splitUsers(denyUsersEdit_->text());
+	predicates.minBits = rule_.trigger == EventKind::Cheer ? minBitsSpin_->value() : 0;
+
+	// 不正な正規表現のルールは発火しないので、保存前に知らせる
+	std::string error;
+	CompiledPredicates::compile(predicates, rule_.trigger, error);
+	if (!error.empty()) {
+		QMessageBox::warning(this, Tr("SceneSwitcher.RuleAdvanced.Title"),
+				     Tr("SceneSwitcher.RuleAdvanced.InvalidRegex").arg(QString::fromStdString(error)));
+		inputPatternEdit_->setFocus();
+		return;
+	}
+	rule_.predicates = std::move(predicates);
+
+	rule_.cooldowns.ruleSeconds = ruleCooldownSpin_->value();
+	rule_.cooldowns.rewardSeconds = rewardCooldownSpin_->value();
+	rule_.cooldowns.userSeconds = userCooldownSpin_->value();
+
+	rule_.combo = RuleCombo();
+	if (comboCountSpin_->value() > 1) {
+		rule_.combo.count = comboCountSpin_->value();
+		rule_.combo.windowSeconds = comboWindowSpin_->value();
+		rule_.combo.distinctUsers = comboDistinctCheckBox_->isChecked();
+	}
+
+	rule_.actions.clear();
+	for (int row = 0; row < actionsTable_->rowCount(); ++row) {
+		RuleAction action;
+		if (readActionRow(row, action))
+			rule_.actions.push_back(std::move(action));
+	}
+
+	// 切替中の 2 つ目の切替は抑制されて実行されないので、保存前に知らせる
+	if (sceneSwitchCount(rule_) > 1) {
+		QMessageBox::warning(this, Tr("SceneSwitcher.RuleAdvanced.Title"),
+				     Tr("SceneSwitcher.RuleAdvanced.MultipleSwitches"));
+		actionsTable_->setFocus();
+		return;
+	}
+
+	accept();
+}
+
+void RuleAdvancedDialog::onCancelClicked()
+{
+	reject();
+}
+
+void RuleAdvancedDialog::onAddActionClicked()
+{
+	addActionRow(SceneItemVisibilityAction{});
+}
+
+void RuleAdvancedDialog::onRemoveActionClicked()
+{
+	const int row = actionsTable_->currentRow();
+	if (row >= 0)
+		actionsTable_->removeRow(row);
+}
+
+void RuleAdvancedDialog::addActionRow(const RuleAction &action)
+{
+	const int row = actionsTable_->rowCount();
+	actionsTable_->insertRow(row);
+
+	// 種別（RuleAction の variant の並びと同じ順）
+	auto *typeBox = new QComboBox(actionsTable_);
+	typeBox->addItem(Tr("SceneSwitcher.RuleAdvanced.ActionSwitchScene"));
+	typeBox->addItem(Tr("SceneSwitcher.RuleAdvanced.ActionItemVisibility"));
+	typeBox->addItem(Tr("SceneSwitcher.RuleAdvanced.ActionFilterToggle"));
+	typeBox->addItem(Tr("SceneSwitcher.RuleAdvanced.ActionMediaRestart"));
+	typeBox->setCurrentIndex(static_cast<int>(action.index()));
+
+	auto *targetEdit = new QLineEdit(actionsTable_);
+	auto *detailEdit = new QLineEdit(actionsTable_);
+	auto *onCheckBox = new QCheckBox(actionsTable_);
+	onCheckBox->setChecked(true);
+	auto *revertSpin = new QSpinBox(actionsTable_);
+	revertSpin->setRange(0, 3600);
+	revertSpin->setSuffix(QString(" %1").arg(Tr("SceneSwitcher.Rule.Duration")));
+
+	std::visit(
+		[&](const auto &a) {
+			using T = std::decay_t<decltype(a)>;
+			if constexpr (std::is_same_v<T, SwitchSceneAction>) {
+				targetEdit->setText(QString::fromStdString(a.scene));
+			} else if constexpr (std::is_same_v<T, SceneItemVisibilityAction>) {
+				targetEdit->setText(QString::fromStdString(a.scene));
+				detailEdit->setText(QString::fromStdString(a.source));
+				onCheckBox->setChecked(a.visible);
+			} else if constexpr (std::is_same_v<T, FilterToggleAction>) {
+				targetEdit->setText(QString::fromStdString(a.source));
+				detailEdit->setText(QString::fromStdString(a.filter));
+				onCheckBox->setChecked(a.enabled);
+			} else if constexpr (std::is_same_v<T, MediaRestartAction>) {
+				targetEdit->setText(QString::fromStdString(a.source));
+			}
+			revertSpin->setValue(a.revertSeconds);
+		},
+		action);
+
+	// 種別によって使わない列は無効化
+	auto updateColumns = [detailEdit, onCheckBox](int type) {
+		const bool hasDetail = type == 1 || type == 2;
+		detailEdit->setEnabled(hasDetail);
+		onCheckBox->setEnabled(hasDetail);
+	};
+	updateColumns(typeBox->currentIndex());
+	connect(typeBox, QOverload<int>::of(&QComboBox::currentIndexChanged), this, updateColumns);
+
+	actionsTable_->setCellWidget(row, kColType, typeBox);
+	actionsTable_->setCellWidget(row, kColTarget, targetEdit);
+	actionsTable_->setCellWidget(row, kColDetail, detailEdit);
+	actionsTable_->setCellWidget(row, kColOn, onCheckBox);
+	actionsTable_->setCellWidget(row, kColRevert, revertSpin);
+}
+
+bool RuleAdvancedDialog::readActionRow(int row, RuleAction &out) const
+{
+	auto *typeBox = qobject_cast<QComboBox *>(actionsTable_->cellWidget(row, kColType));
+	auto *targetEdit = qobject_cast<QLineEdit *>(actionsTable_->cellWidget(row, kColTarget));
+	auto *detailEdit = qobject_cast<QLineEdit *>(actionsTable_->cellWidget(row, kColDetail));
+	auto *onCheckBox = qobject_cast<QCheckBox *>(actionsTable_->cellWidget(row, kColOn));
+	auto *revertSpin = qobject_cast<QSpinBox *>(actionsTable_->cellWidget(row, kColRevert));
+	if (!typeBox || !targetEdit || !detailEdit || !onCheckBox || !revertSpin)
+		return false;
+
+	const std::string target = targetEdit->text().trimmed().toStdString();
+	const std::string detail = detailEdit->text().trimmed().toStdString();
+	const bool on = onCheckBox->isChecked();
+	const int revertSeconds = revertSpin->value();
+
+	// 対象が未入力の行は保存しない
+	if (target.empty())
+		return false;
+
+	switch (typeBox->currentIndex()) {
+	case 0:
+		out = SwitchSceneAction{target, revertSeconds};
+		return true;
+	case 1:
+		if (detail.empty())
+			return false;
+		out = SceneItemVisibilityAction{target, detail, on, revertSeconds};
+		return true;
+	case 2:
+		if (detail.empty())
+			return false;
+		out = FilterToggleAction{target, detail, on, revertSeconds};
+		return true;
+	case 3:
+		out = MediaRestartAction{target, revertSeconds};
+		return true;
+	default:
+		return false;
+	}
+}
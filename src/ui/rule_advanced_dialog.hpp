@@ -0,0 +1,62 @@
+// obs-scene-switcher plugin
+// Copyright (C) 2025 ksmksks
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+#include "core/reward_rule.hpp"
+#include <QDialog>
+#include <QCheckBox>
+#include <QPushButton>
+#include <QTableWidget>
+#include <QComboBox>
+#include <QLineEdit>
+#include <QSpinBox>
+
+/**
+ * ルールの詳細設定ダイアログ
+ *
+ * RuleRow の 1 行に収まらないオプション項目を編集する。
+ */
+class RuleAdvancedDialog : public QDialog {
+	Q_OBJECT
+
+public:
+	explicit RuleAdvancedDialog(const RewardRule &rule, QWidget *parent = nullptr);
+
+	// 編集結果（ダイアログで扱わない項目は元の値のまま）
+	RewardRule rule() const;
+
+private slots:
+	void onSaveClicked();
+	void onCancelClicked();
+	void onAddActionClicked();
+	void onRemoveActionClicked();
+
+private:
+	void addActionRow(const RuleAction &action);
+	bool readActionRow(int row, RuleAction &out) const;
+
+	RewardRule rule_;
+
+	QCheckBox *prewarmCheckBox_;
+	QCheckBox *highPriorityCheckBox_;
+	QSpinBox *maxEventAgeSpin_;
+	QComboBox *transitionBox_;
+	QSpinBox *transitionDurationSpin_;
+	QLineEdit *inputPatternEdit_;
+	QCheckBox *inputRegexCheckBox_;
+	QLineEdit *allowUsersEdit_;
+	QLineEdit *denyUsersEdit_;
+	QSpinBox *minBitsSpin_;
+	QSpinBox *ruleCooldownSpin_;
+	QSpinBox *rewardCooldownSpin_;
+	QSpinBox *userCooldownSpin_;
+	QSpinBox *comboCountSpin_;
+	QSpinBox *comboWindowSpin_;
+	QCheckBox *comboDistinctCheckBox_;
+	QTableWidget *actionsTable_;
+	QPushButton *addActionButton_;
+	QPushButton *removeActionButton_;
+	QPushButton *saveButton_;
+	QPushButton *cancelButton_;
+};
@@ -3,12 +3,32 @@
 // SPDX-License-Identifier: GPL-2.0-or-later
 
 #include "rule_row.hpp"
+#include "rule_advanced_dialog.hpp"
 #include "../i18n/locale_manager.hpp"
 #include <QHBoxLayout>
 #include <QToolButton>
 #include <QStyle>
 #include <QLabel>
 
+// リワード欄でイベントのトリガーを表す項目のデータ（"event:cheer" など）
+static const QString kEventTriggerPrefix = QStringLiteral("event:");
+
+static QString eventTriggerLabel(EventKind kind)
+{
+	switch (kind) {
+	case EventKind::Cheer:
+		return Tr("SceneSwitcher.Rule.Trigger.Cheer");
+	case EventKind::Subscribe:
+		return Tr("SceneSwitcher.Rule.Trigger.Subscribe");
+	case EventKind::Raid:
+		return Tr("SceneSwitcher.Rule.Trigger.Raid");
+	case EventKind::Follow:
+		return Tr("SceneSwitcher.Rule.Trigger.Follow");
+	default:
+		return QString();
+	}
+}
+
 RuleRow::RuleRow(QWidget *parent) : QWidget(parent)
 {
 	auto *layout = new QHBoxLayout(this);
@@ -79,6 +99,12 @@ RuleRow::RuleRow(QWidget *parent) : QWidget(parent)
 	revertSpin_->setFixedWidth(100);
 	revertSpin_->setSizePolicy(fixedPolicy);
 
+	// 詳細設定ボタン
+	advancedButton_ = new QPushButton("⚙", this);
+	advancedButton_->setToolTip(Tr("SceneSwitcher.Rule.Advanced"));
+	advancedButton_->setFixedWidth(30);
+	advancedButton_->setSizePolicy(fixedPolicy);
+
 	// 削除ボタン
 	removeButton_ = new QPushButton(Tr("SceneSwitcher.Rule.Remove"), this);
 	removeButton_->setFixedWidth(60);
@@ -93,6 +119,7 @@ RuleRow::RuleRow(QWidget *parent) : QWidget(parent)
 	layout->addWidget(targetSceneBox_);
 	layout->addWidget(colonLabel);
 	layout->addWidget(revertSpin_);
+	layout->addWidget(advancedButton_);
 	layout->addWidget(removeButton_);
 
 	// 伸縮はコンボ部分に寄せる
@@ -100,6 +127,7 @@ RuleRow::RuleRow(QWidget *parent) : QWidget(parent)
 	layout->setStretch(4, 2); // reward (arrow1=3, reward=4)
 	layout->setStretch(6, 2); // targetScene (arrow2=5, target=6)
 
+	connect(advancedButton_, &QPushButton::clicked, this, &RuleRow::onAdvancedClicked);
 	connect(removeButton_, &QPushButton::clicked, [this]() { emit removeRequested(this); });
 }
 
@@ -107,7 +135,8 @@ void RuleRow::setSceneList(const QList<QString> &scenes)
 {
 	// 現在の選択を保存
 	QString currentSourceScene = currentScene();
-	QString currentTargetScene = targetSceneBox_->currentText();
+	QString currentTargetScene = targetScene();
+	const bool wasNoSwitch = targetSceneBox_->count() > 0 && currentTargetScene.isEmpty();
 	
 	// コンボボックスをクリアして再構築
 	originalSceneBox_->clear();
@@ -117,8 +146,9 @@ void RuleRow::setSceneList(const QList<QString> &scenes)
 	originalSceneBox_->addItem(Tr("SceneSwitcher.Rule.Any"), "Any");
 	originalSceneBox_->addItems(scenes);
 	
-	// 切替先シーンには通常のシーンのみ
+	// 切替先シーンには通常のシーンと、末尾に「切替なし（アクションのみ）」
 	targetSceneBox_->addItems(scenes);
+	targetSceneBox_->addItem(Tr("SceneSwitcher.Rule.NoSwitch"), "None");
 	
 	// 以前の選択を復元
 	if (currentSourceScene == "Any") {
@@ -133,7 +163,9 @@ void RuleRow::setSceneList(const QList<QString> &scenes)
 	}
 	
 	// 切替先シーンの選択を復元
-	if (!currentTargetScene.isEmpty()) {
+	if (wasNoSwitch) {
+		targetSceneBox_->setCurrentIndex(targetSceneBox_->count() - 1);
+	} else if (!currentTargetScene.isEmpty()) {
 		int index = targetSceneBox_->findText(currentTargetScene);
 		if (index >= 0) {
 			targetSceneBox_->setCurrentIndex(index);
@@ -151,6 +183,24 @@ void RuleRow::setRewardList(const std::vector<RewardInfo> &rewards)
 		// 内部データ：ID
 		rewardBox_->addItem(QString::fromStdString(reward.title), QString::fromStdString(reward.id));
 	}
+
+	// 引き換え以外のトリガー（同じ EventSub 接続で受ける）
+	rewardBox_->insertSeparator(rewardBox_->count());
+	for (const auto &info : kEventTypes) {
+		if (info.kind == EventKind::Redemption)
+			continue;
+		rewardBox_->addItem(eventTriggerLabel(info.kind), kEventTriggerPrefix + QString::fromUtf8(info.name));
+	}
+}
+
+EventKind RuleRow::trigger() const
+{
+	const QString data = rewardBox_ ? rewardBox_->currentData().toString() : QString();
+	if (!data.startsWith(kEventTriggerPrefix))
+		return EventKind::Redemption;
+
+	const auto kind = eventKindFromName(data.mid(kEventTriggerPrefix.size()).toStdString());
+	return kind.value_or(EventKind::Redemption);
 }
 
 std::string RuleRow::getSelectedRewardId() const
@@ -179,6 +229,11 @@ QString RuleRow::reward() const
 
 QString RuleRow::targetScene() const
 {
+	// 「切替なし」が選択されている場合は空文字列を返す
+	QVariant data = targetSceneBox_->currentData();
+	if (data.isValid() && data.toString() == "None") {
+		return QString();
+	}
 	return targetSceneBox_->currentText();
 }
 
@@ -194,7 +249,7 @@ bool RuleRow::enabled() const
 
 std::string RuleRow::rewardId() const
 {
-	if (!rewardBox_)
+	if (!rewardBox_ || trigger() != EventKind::Redemption)
 		return "";
 
 	return rewardBox_->currentData().toString().toStdString();
@@ -202,10 +257,12 @@ std::string RuleRow::rewardId() const
 
 RewardRule RuleRow::rule() const
 {
-	RewardRule r;
-	r.rewardId = rewardId();  // rewardId を設定
+	// 詳細設定の項目は保持しているルールから引き継ぐ
+	RewardRule r = rule_;
+	r.trigger = trigger();
+	r.rewardId = rewardId();  // rewardId を設定（引き換え以外は空）
 	r.sourceScene = currentScene().toStdString();  // sourceScene を設定
-	r.targetScene = targetSceneBox_->currentText().toStdString();
+	r.targetScene = targetScene().toStdString();
 	r.revertSeconds = revertSpin_->value();
 	r.enabled = enabled();
 	return r;
@@ -213,6 +270,8 @@ RewardRule RuleRow::rule() const
 
 void RuleRow::setRule(const RewardRule &rule)
 {
+	rule_ = rule;
+
 	if (enabledCheckBox_)
 		enabledCheckBox_->setChecked(rule.enabled);
 
@@ -224,14 +283,22 @@ void RuleRow::setRule(const RewardRule &rule)
 		originalSceneBox_->setCurrentText(QString::fromStdString(rule.sourceScene));
 	}
 
+	const QString rewardData = rule.trigger == EventKind::Redemption
+					   ? QString::fromStdString(rule.rewardId)
+					   : kEventTriggerPrefix + QString::fromUtf8(eventTypeInfo(rule.trigger).name);
 	for (int i = 0; i < rewardBox_->count(); ++i) {
-		if (rewardBox_->itemData(i).toString().toStdString() == rule.rewardId) {
+		if (rewardBox_->itemData(i).toString() == rewardData) {
 			rewardBox_->setCurrentIndex(i);
 			break;
 		}
 	}
 
-	targetSceneBox_->setCurrentText(QString::fromStdString(rule.targetScene));
+	if (rule.targetScene.empty()) {
+		// 切替なし（アクションのみ）は末尾
+		targetSceneBox_->setCurrentIndex(targetSceneBox_->count() - 1);
+	} else {
+		targetSceneBox_->setCurrentText(QString::fromStdString(rule.targetScene));
+	}
 	revertSpin_->setValue(rule.revertSeconds);
 	
 	updateVisualState();
@@ -256,3 +323,10 @@ void RuleRow::updateVisualState()
 	// 全体の透明度を調整してグレーアウト感を出す
 	setStyleSheet(isEnabled ? "" : "QWidget { opacity: 0.5; }");
 }
+
+void RuleRow::onAdvancedClicked()
+{
+	RuleAdvancedDialog dialog(rule(), this);
+	if (dialog.exec() == QDialog::Accepted)
+		rule_ = dialog.rule();
+}
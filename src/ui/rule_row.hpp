@@ -19,6 +19,7 @@ public:
 	explicit RuleRow(QWidget *parent = nullptr);
 
 	void setSceneList(const QList<QString> &scenes);
+	// リワード一覧（末尾に Bits・サブスク・レイド・フォローのトリガーを並べる）
 	void setRewardList(const std::vector<RewardInfo> &rewards);
 
 	QString currentScene() const;
@@ -30,6 +31,7 @@ public:
 	RewardRule rule() const;
 
 	std::string getSelectedRewardId() const;
+	EventKind trigger() const;
 	void setRule(const RewardRule &rule);
 
 signals:
@@ -37,6 +39,7 @@ signals:
 
 private slots:
 	void updateVisualState();  // 無効時のグレーアウト表示
+	void onAdvancedClicked();  // 詳細設定ダイアログを開く
 
 private:
 	QCheckBox *enabledCheckBox_;
@@ -44,7 +47,11 @@ private:
 	QComboBox *rewardBox_;
 	QComboBox *targetSceneBox_;
 	QSpinBox *revertSpin_;
+	QPushButton *advancedButton_;
 	QPushButton *removeButton_;
 
 	std::vector<RewardInfo> rewardList_;
+
+	// 行に表示しない項目（詳細設定）を保持するためのルール
+	RewardRule rule_;
 };
@@ -18,6 +18,7 @@
 #include <QScrollArea>
 #include <QListWidget>
 #include <QShowEvent>
+#include <QGroupBox>
 
 SettingsWindow::SettingsWindow(QWidget *parent) : QDialog(parent)
 {
@@ -38,7 +39,12 @@ SettingsWindow::SettingsWindow(QWidget *parent) : QDialog(parent)
 
 	addRuleButton_ = new QPushButton(Tr("SceneSwitcher.Settings.AddRule"), this);
 
+	// ルールはシーンコレクションごとに保存される（表示名は loadRules() で設定）
+	collectionLabel_ = new QLabel(this);
+	collectionLabel_->setToolTip(Tr("SceneSwitcher.Settings.SceneCollectionTooltip"));
+
 	headerLayout->addWidget(titleLabel);
+	headerLayout->addWidget(collectionLabel_);
 	headerLayout->addStretch();
 	headerLayout->addWidget(addRuleButton_);
 
@@ -62,6 +68,54 @@ SettingsWindow::SettingsWindow(QWidget *parent) : QDialog(parent)
 	
 	mainLayout->addWidget(rulesListWidget_, 1);
 
+	// 全体オプション
+	auto *optionsGroup = new QGroupBox(Tr("SceneSwitcher.Settings.Options"), this);
+	auto *optionsLayout = new QVBoxLayout(optionsGroup);
+
+	tickSyncCheckBox_ = new QCheckBox(Tr("SceneSwitcher.Settings.TickSync"), optionsGroup);
+	tickSyncCheckBox_->setToolTip(Tr("SceneSwitcher.Settings.TickSyncTooltip"));
+	optionsLayout->addWidget(tickSyncCheckBox_);
+
+	loadAwareCheckBox_ = new QCheckBox(Tr("SceneSwitcher.Settings.LoadAware"), optionsGroup);
+	loadAwareCheckBox_->setToolTip(Tr("SceneSwitcher.Settings.LoadAwareTooltip"));
+	optionsLayout->addWidget(loadAwareCheckBox_);
+
+	redemptionStatusCheckBox_ = new QCheckBox(Tr("SceneSwitcher.Settings.RedemptionStatus"), optionsGroup);
+	redemptionStatusCheckBox_->setToolTip(Tr("SceneSwitcher.Settings.RedemptionStatusTooltip"));
+	optionsLayout->addWidget(redemptionStatusCheckBox_);
+
+	eventSubStandbyCheckBox_ = new QCheckBox(Tr("SceneSwitcher.Settings.EventSubStandby"), optionsGroup);
+	eventSubStandbyCheckBox_->setToolTip(Tr("SceneSwitcher.Settings.EventSubStandbyTooltip"));
+	optionsLayout->addWidget(eventSubStandbyCheckBox_);
+
+	// 全ルール共通のクールダウン
+	auto *cooldownLayout = new QHBoxLayout();
+	globalCooldownSpin_ = new QSpinBox(optionsGroup);
+	globalCooldownSpin_->setRange(0, 3600);
+	globalCooldownSpin_->setSuffix(QString(" %1").arg(Tr("SceneSwitcher.Rule.Duration")));
+	globalCooldownSpin_->setSpecialValueText(Tr("SceneSwitcher.Settings.GlobalCooldownNone"));
+	globalCooldownSpin_->setToolTip(Tr("SceneSwitcher.Settings.GlobalCooldownTooltip"));
+	cooldownLayout->addWidget(new QLabel(Tr("SceneSwitcher.Settings.GlobalCooldown"), optionsGroup));
+	cooldownLayout->addWidget(globalCooldownSpin_);
+	cooldownLayout->addStretch();
+	optionsLayout->addLayout(cooldownLayout);
+
+	// localhost のメトリクスエンドポイント
+	auto *metricsLayout = new QHBoxLayout();
+	metricsCheckBox_ = new QCheckBox(Tr("SceneSwitcher.Settings.Metrics"), optionsGroup);
+	metricsCheckBox_->setToolTip(Tr("SceneSwitcher.Settings.MetricsTooltip"));
+	metricsPortSpin_ = new QSpinBox(optionsGroup);
+	metricsPortSpin_->setRange(1024, 65535);
+	metricsPortSpin_->setPrefix(Tr("SceneSwitcher.Settings.MetricsPort"));
+	metricsLayout->addWidget(metricsCheckBox_);
+	metricsLayout->addWidget(metricsPortSpin_);
+	metricsLayout->addStretch();
+	optionsLayout->addLayout(metricsLayout);
+
+	connect(metricsCheckBox_, &QCheckBox::toggled, metricsPortSpin_, &QSpinBox::setEnabled);
+
+	mainLayout->addWidget(optionsGroup);
+
 	// 下部ボタン行 [ 保存 ][ 閉じる ]
 	auto *buttonLayout = new QHBoxLayout();
 	saveButton_ = new QPushButton(Tr("SceneSwitcher.Settings.Save"), this);
@@ -82,7 +136,12 @@ SettingsWindow::SettingsWindow(QWidget *parent) : QDialog(parent)
 	refreshSceneList();
 	rewardList_ = ObsSceneSwitcher::instance()->getRewardList();
 
+	// リワード一覧は非同期に取得されるため、完了時に反映する
+	connect(ObsSceneSwitcher::instance(), &ObsSceneSwitcher::rewardListChanged,
+		this, &SettingsWindow::setRewardList);
+
 	loadRules();
+	loadOptions();
 }
 
 void SettingsWindow::showEvent(QShowEvent *event)
@@ -91,6 +150,10 @@ void SettingsWindow::showEvent(QShowEvent *event)
 	
 	// ウィンドウが表示されるたびにシーン一覧を更新
 	refreshSceneList();
+
+	// 閉じている間にシーンコレクションが切り替わったら、そのコレクションのルールを表示する
+	if (ConfigManager::instance().getActiveSceneCollection() != loadedCollection_)
+		loadRules();
 }
 
 void SettingsWindow::refreshSceneList()
@@ -170,8 +233,12 @@ void SettingsWindow::removeRuleRow(RuleRow *row)
 void SettingsWindow::onSaveClicked()
 {
 	// ここで ruleRows からルールをかき集めて ConfigManager に保存する想定
+	saveOptions();
 	saveRules();
 
+	ObsSceneSwitcher::instance()->updateMetricsServer();
+	ObsSceneSwitcher::instance()->updateEventSubStandby();
+
 	emit rulesSaved();
         
 	accept();
@@ -187,6 +254,10 @@ void SettingsWindow::loadRules()
 	rulesListWidget_->clear();
 
 	auto &cfg = ConfigManager::instance();
+	loadedCollection_ = cfg.getActiveSceneCollection();
+	collectionLabel_->setText(
+		Tr("SceneSwitcher.Settings.SceneCollection").arg(QString::fromStdString(loadedCollection_)));
+
 	for (const auto &rule : cfg.getRewardRules()) {
 		auto *row = new RuleRow(this);
 
@@ -214,25 +285,51 @@ void SettingsWindow::saveRules()
 		if (!row)
 			continue;
 
-		RewardRule rule;
-		rule.rewardId = row->rewardId();
-		rule.sourceScene = row->currentScene().toStdString();
-		rule.targetScene = row->targetScene().toStdString();
-		rule.revertSeconds = row->revertSeconds();
-		rule.enabled = row->enabled();
+		// 詳細設定を含めたルール全体を取得
+		RewardRule rule = row->rule();
 
-		if (rule.rewardId.empty() || rule.targetScene.empty())
+		if ((rule.trigger == EventKind::Redemption && rule.rewardId.empty()) ||
+		    (rule.targetScene.empty() && rule.actions.empty()))
 			continue;
 
 		rules.push_back(std::move(rule));
 	}
 
+	// 開いている間にシーンコレクションが切り替わっても、表示していたコレクションに保存する
 	auto &cfg = ConfigManager::instance();
-	cfg.setRewardRules(rules);
+	cfg.setRewardRules(loadedCollection_, rules);
 	cfg.save();
 
-	blog(LOG_DEBUG, "[obs-scene-switcher] Saved %zu rules", rules.size());
+	blog(LOG_DEBUG, "[obs-scene-switcher] Saved %zu rules for scene collection '%s'", rules.size(),
+	     loadedCollection_.c_str());
+
+	// ObsSceneSwitcher に即時反映（有効なコレクションのルールのときだけ）
+	if (loadedCollection_ == cfg.getActiveSceneCollection())
+		ObsSceneSwitcher::instance()->setRewardRules(rules);
+}
 
-	// ObsSceneSwitcher に即時反映
-	ObsSceneSwitcher::instance()->setRewardRules(rules);
+void SettingsWindow::loadOptions()
+{
+	auto &cfg = ConfigManager::instance();
+	tickSyncCheckBox_->setChecked(cfg.getTickSyncSwitching());
+	loadAwareCheckBox_->setChecked(cfg.getLoadAwareSwitching());
+	redemptionStatusCheckBox_->setChecked(cfg.getRedemptionStatusUpdates());
+	eventSubStandbyCheckBox_->setChecked(cfg.getEventSubStandby());
+	globalCooldownSpin_->setValue(cfg.getGlobalCooldownSeconds());
+	metricsCheckBox_->setChecked(cfg.getMetricsEnabled());
+	metricsPortSpin_->setValue(cfg.getMetricsPort());
+	metricsPortSpin_->setEnabled(cfg.getMetricsEnabled());
+}
+
+void SettingsWindow::saveOptions()
+{
+	// 保存は saveRules() 側でまとめて行う
+	auto &cfg = ConfigManager::instance();
+	cfg.setTickSyncSwitching(tickSyncCheckBox_->isChecked());
+	cfg.setLoadAwareSwitching(loadAwareCheckBox_->isChecked());
+	cfg.setRedemptionStatusUpdates(redemptionStatusCheckBox_->isChecked());
+	cfg.setEventSubStandby(eventSubStandbyCheckBox_->isChecked());
+	cfg.setGlobalCooldownSeconds(globalCooldownSpin_->value());
+	cfg.setMetricsEnabled(metricsCheckBox_->isChecked());
+	cfg.setMetricsPort(metricsPortSpin_->value());
 }
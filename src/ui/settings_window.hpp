@@ -10,6 +10,9 @@
 #include <QVector>
 #include <QVBoxLayout>
 #include <QListWidget>
+#include <QCheckBox>
+#include <QLabel>
+#include <QSpinBox>
 
 class RuleRow;
 
@@ -49,13 +52,28 @@ private:
 
 	void loadRules();
 	void saveRules();
+	void loadOptions();
+	void saveOptions();
 	void refreshSceneList();
 
 	QListWidget *rulesListWidget_ = nullptr;  // ドラッグ&ドロップ対応
 	QPushButton *addRuleButton_ = nullptr;
+	QLabel *collectionLabel_ = nullptr;
 	QPushButton *saveButton_ = nullptr;
 	QPushButton *closeButton_ = nullptr;
 
+	// 全体オプション
+	QCheckBox *tickSyncCheckBox_ = nullptr;
+	QCheckBox *loadAwareCheckBox_ = nullptr;
+	QCheckBox *redemptionStatusCheckBox_ = nullptr;
+	QCheckBox *eventSubStandbyCheckBox_ = nullptr;
+	QSpinBox *globalCooldownSpin_ = nullptr;
+	QCheckBox *metricsCheckBox_ = nullptr;
+	QSpinBox *metricsPortSpin_ = nullptr;
+
+	// 表示中のルールのシーンコレクション
+	std::string loadedCollection_;
+
 	// Scene / Reward の候補一覧
 	QStringList sceneList_;
 	std::vector<RewardInfo> rewardList_;
@@ -9,10 +9,10 @@
 
 #include "../plugin-support.h"
 #include "../i18n/locale_manager.hpp"
+#include "../net/network.hpp"
 
 #include <nlohmann/json.hpp>
 
-#include <thread>
 #include <sstream>
 #include <algorithm>
 #include <tuple>
@@ -20,29 +20,30 @@
 #ifdef _WIN32
 #define NOMINMAX  // Windows.h の min/max マクロを無効化
 #include <Windows.h>
-#include <wininet.h>
 #include <shellapi.h>
-#pragma comment(lib, "Wininet.lib")
 #endif
 
-static const char *GITHUB_API_URL = "https://api.github.com/repos/ksmksks/obs-scene-switcher/releases/latest";
-
 void UpdateChecker::checkOnStartupAsync()
 {
 	blog(LOG_DEBUG, "[obs-scene-switcher] Starting update check...");
 	
-	// 別スレッドで実行（OBS 起動をブロックしない）
-	std::thread checkThread(checkUpdateThread);
-	checkThread.detach();
+	// ネットワークスレッドで実行（OBS 起動をブロックしない）
+	HttpRequest req;
+	req.host = "api.github.com";
+	req.path = "/repos/ksmksks/obs-scene-switcher/releases/latest";
+	// User-Agent ヘッダーを追加（GitHub API 推奨）
+	req.headers = {{"User-Agent", "OBS-SceneSwitcher-UpdateChecker"}};
+
+	Network::instance().request(std::move(req), &UpdateChecker::handleLatestRelease);
 }
 
-void UpdateChecker::checkUpdateThread()
+void UpdateChecker::handleLatestRelease(const HttpResponse &response)
 {
 	std::string latestVersion;
 	std::string releaseUrl;
 	
-	// GitHub API からバージョン情報を取得
-	if (!fetchLatestVersion(latestVersion, releaseUrl)) {
+	// GitHub API の応答からバージョン情報を取得
+	if (!parseLatestVersion(response, latestVersion, releaseUrl)) {
 		blog(LOG_DEBUG, "[obs-scene-switcher] Failed to fetch latest version (network issue or API error)");
 		return;
 	}
@@ -60,61 +61,15 @@ void UpdateChecker::checkUpdateThread()
 	}
 }
 
-bool UpdateChecker::fetchLatestVersion(std::string &outVersion, std::string &outUrl)
+bool UpdateChecker::parseLatestVersion(const HttpResponse &response, std::string &outVersion, std::string &outUrl)
 {
-#ifdef _WIN32
-	HINTERNET hInet = InternetOpenA("OBS-SceneSwitcher-UpdateChecker", 
-	                                 INTERNET_OPEN_TYPE_DIRECT, NULL, NULL, 0);
-	if (!hInet) {
-		blog(LOG_DEBUG, "[obs-scene-switcher] InternetOpenA failed");
-		return false;
-	}
-	
-	HINTERNET hConnect = InternetConnectA(hInet, "api.github.com", 443, 
-	                                       NULL, NULL, INTERNET_SERVICE_HTTP, 0, 0);
-	if (!hConnect) {
-		blog(LOG_DEBUG, "[obs-scene-switcher] InternetConnectA failed");
-		InternetCloseHandle(hInet);
-		return false;
-	}
-	
-	HINTERNET hRequest = HttpOpenRequestA(hConnect, "GET", 
-	                                       "/repos/ksmksks/obs-scene-switcher/releases/latest",
-	                                       NULL, NULL, NULL, 
-	                                       INTERNET_FLAG_SECURE | INTERNET_FLAG_NO_CACHE_WRITE, 0);
-	if (!hRequest) {
-		blog(LOG_DEBUG, "[obs-scene-switcher] HttpOpenRequestA failed");
-		InternetCloseHandle(hConnect);
-		InternetCloseHandle(hInet);
+	if (!response.error.empty()) {
+		blog(LOG_DEBUG, "[obs-scene-switcher] Update check request failed: %s", response.error.c_str());
 		return false;
 	}
 	
-	// User-Agent ヘッダーを追加（GitHub API 推奨）
-	std::string headers = "User-Agent: OBS-SceneSwitcher-UpdateChecker\r\n";
-	
-	if (!HttpSendRequestA(hRequest, headers.c_str(), (DWORD)headers.size(), NULL, 0)) {
-		blog(LOG_DEBUG, "[obs-scene-switcher] HttpSendRequestA failed");
-		InternetCloseHandle(hRequest);
-		InternetCloseHandle(hConnect);
-		InternetCloseHandle(hInet);
-		return false;
-	}
-	
-	// レスポンスを読み取る
-	char buffer[8192];
-	DWORD read = 0;
-	std::string response;
-	
-	while (InternetReadFile(hRequest, buffer, sizeof(buffer), &read) && read > 0) {
-		response.append(buffer, read);
-	}
-	
-	InternetCloseHandle(hRequest);
-	InternetCloseHandle(hConnect);
-	InternetCloseHandle(hInet);
-	
 	// JSON パース
-	auto json = nlohmann::json::parse(response, nullptr, false);
+	auto json = nlohmann::json::parse(response.body, nullptr, false);
 	if (json.is_discarded()) {
 		blog(LOG_DEBUG, "[obs-scene-switcher] Failed to parse JSON response");
 		return false;
@@ -137,10 +92,6 @@ bool UpdateChecker::fetchLatestVersion(std::string &outVersion, std::string &out
 	}
 	
 	return true;
-#else
-	// Windows 以外では未実装
-	return false;
-#endif
 }
 
 bool UpdateChecker::isNewerVersion(const std::string &current, const std::string &latest)
@@ -7,14 +7,16 @@
 #include <string>
 #include <vector>
 
+struct HttpResponse;
+
 class UpdateChecker {
 public:
 	// OBS 起動時に非同期でバージョンチェックを開始
 	static void checkOnStartupAsync();
 
 private:
-	// GitHub Releases API からバージョン情報を取得
-	static bool fetchLatestVersion(std::string &outVersion, std::string &outUrl);
+	// GitHub Releases API の応答からバージョン情報を取得
+	static bool parseLatestVersion(const HttpResponse &response, std::string &outVersion, std::string &outUrl);
 	
 	// バージョン文字列を比較（例: "0.7.0" < "0.8.0"）
 	static bool isNewerVersion(const std::string &current, const std::string &latest);
@@ -25,6 +27,6 @@ private:
 	// OBS に更新通知を表示
 	static void showUpdateNotification(const std::string &latestVersion, const std::string &releaseUrl);
 	
-	// バックグラウンドスレッドでの処理
-	static void checkUpdateThread();
+	// ネットワークスレッドでの処理
+	static void handleLatestRelease(const HttpResponse &response);
 };